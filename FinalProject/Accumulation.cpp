@@ -0,0 +1,184 @@
+#include "Accumulation.h"
+
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "GLState.h"
+#include "FrameStats.h"
+
+using namespace std;
+
+// Element index of the Halton low-discrepancy sequence in [0, 1)
+static float Halton(unsigned int index, unsigned int base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f / base;
+	while (index > 0) {
+		result += fraction * (index % base);
+		index /= base;
+		fraction /= base;
+	}
+	return result;
+}
+
+// Delete the offscreen targets
+static void FreeTargets(Accumulation& accumulation)
+{
+	glDeleteFramebuffers(1, &accumulation.sceneFbo);
+	glDeleteTextures(1, &accumulation.sceneColor);
+	glDeleteRenderbuffers(1, &accumulation.sceneDepth);
+	glDeleteFramebuffers(1, &accumulation.accumFbo);
+	glDeleteTextures(1, &accumulation.accumTexture);
+
+	accumulation.sceneFbo = accumulation.sceneColor = accumulation.sceneDepth = 0;
+	accumulation.accumFbo = accumulation.accumTexture = 0;
+	accumulation.width = accumulation.height = 0;
+}
+
+// Create a texture usable as a render target
+static GLuint CreateTarget(GLint format, GLenum type, int width, int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	stateBindTexture(0, GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+// (Re)create the offscreen targets at the window size
+static void CreateTargets(Accumulation& accumulation, int width, int height)
+{
+	FreeTargets(accumulation);
+	accumulation.width = width;
+	accumulation.height = height;
+
+	// Scene: 8-bit color and depth, same as the window
+	accumulation.sceneColor = CreateTarget(GL_RGBA8, GL_UNSIGNED_BYTE, width, height);
+	glGenRenderbuffers(1, &accumulation.sceneDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, accumulation.sceneDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &accumulation.sceneFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, accumulation.sceneFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation.sceneColor, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, accumulation.sceneDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		cout << "Accumulation scene framebuffer is incomplete" << endl;
+
+	// Average: 32-bit float so hundreds of samples keep their precision
+	accumulation.accumTexture = CreateTarget(GL_RGBA32F, GL_FLOAT, width, height);
+	glGenFramebuffers(1, &accumulation.accumFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, accumulation.accumFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation.accumTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		cout << "Accumulation framebuffer is incomplete" << endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	stateBindTexture(0, GL_TEXTURE_2D, 0);
+}
+
+// Load the blend shader, targets are created on first use
+void initAccumulation(Accumulation& accumulation)
+{
+	accumulation.copy = loadShaderProgram("shaders/fullscreen.vert", "shaders/copy.frag");
+	glGenVertexArrays(1, &accumulation.vao);
+}
+
+// Restart the average if the view changed, bind the scene target and return the jittered projection
+glm::mat4 beginAccumulation(Accumulation& accumulation, const FrameSnapshot& snapshot, unsigned int sceneVersion)
+{
+	const CameraSnapshot& camera = snapshot.camera;
+
+	if (snapshot.width != accumulation.width || snapshot.height != accumulation.height) {
+		CreateTargets(accumulation, snapshot.width, snapshot.height);
+		accumulation.samples = 0;
+	}
+
+	if (camera.view != accumulation.view || camera.projection != accumulation.projection ||
+		snapshot.wireFrame != accumulation.wireFrame || snapshot.lightDraw != accumulation.lightDraw || snapshot.overdraw != accumulation.overdraw ||
+		snapshot.instances.get() != accumulation.instances || sceneVersion != accumulation.sceneVersion) {
+		accumulation.view = camera.view;
+		accumulation.projection = camera.projection;
+		accumulation.wireFrame = snapshot.wireFrame;
+		accumulation.lightDraw = snapshot.lightDraw;
+		accumulation.overdraw = snapshot.overdraw;
+		accumulation.instances = snapshot.instances.get();
+		accumulation.sceneVersion = sceneVersion;
+		accumulation.samples = 0;
+	}
+
+	if (accumulationConverged(accumulation))
+		return camera.projection;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, accumulation.sceneFbo);
+
+	// First sample is unjittered so interaction looks the same as without accumulation
+	if (accumulation.samples == 0)
+		return camera.projection;
+
+	// Sub-pixel offset in pixels, shifted in NDC after projection (works for ortho and perspective)
+	glm::vec2 jitter(Halton(accumulation.samples, 2) - 0.5f, Halton(accumulation.samples, 3) - 0.5f);
+	glm::vec3 offset(jitter.x * 2.0f / accumulation.width, jitter.y * 2.0f / accumulation.height, 0.0f);
+	return glm::translate(glm::mat4(), offset) * camera.projection;
+}
+
+// Average is final, nothing left to render
+bool accumulationConverged(const Accumulation& accumulation)
+{
+	return accumulation.samples >= MAX_ACCUMULATION_SAMPLES;
+}
+
+// Blend the scene into the average and present it, true while more samples would improve the image
+bool endAccumulation(Accumulation& accumulation)
+{
+	if (!accumulationConverged(accumulation)) {
+		// Blend shader still compiling, show the raw frame
+		if (accumulation.copy->program == 0) {
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, accumulation.sceneFbo);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+			glBlitFramebuffer(0, 0, accumulation.width, accumulation.height, 0, 0, accumulation.width, accumulation.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			return true;
+		}
+
+		// average = average * n / (n + 1) + sample / (n + 1)
+		glBindFramebuffer(GL_FRAMEBUFFER, accumulation.accumFbo);
+		statePolygonMode(GL_FILL);
+		stateEnable(GL_DEPTH_TEST, false);
+		stateEnable(GL_BLEND, true);
+		stateBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+		glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / (accumulation.samples + 1));
+
+		stateUseProgram(accumulation.copy->program);
+		glUniform1i(glGetUniformLocation(accumulation.copy->program, "source"), 0);
+		stateBindTexture(0, GL_TEXTURE_2D, accumulation.sceneColor);
+		stateBindVertexArray(accumulation.vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		frameStats.drawCalls++;
+
+		stateEnable(GL_BLEND, false);
+		stateEnable(GL_DEPTH_TEST, true);
+		accumulation.samples++;
+	}
+
+	// Present the average
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, accumulation.accumFbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, accumulation.width, accumulation.height, 0, 0, accumulation.width, accumulation.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	frameStats.accumulatedSamples = accumulation.samples;
+	return !accumulationConverged(accumulation);
+}
+
+// Release targets and the blend vertex array (the shader belongs to the shader manager)
+void freeAccumulation(Accumulation& accumulation)
+{
+	FreeTargets(accumulation);
+	glDeleteVertexArrays(1, &accumulation.vao);
+	accumulation.vao = 0;
+}
@@ -0,0 +1,50 @@
+/* Description:
+Progressive supersampling. While the view stays the same,
+every frame is rendered offscreen with the projection
+shifted by a different sub-pixel offset (Halton 2,3
+sequence) and averaged into a float buffer, converging to
+an anti-aliased image. Any change to the camera, window
+size, view toggles, instances or shaders restarts the
+average; the first sample is unjittered so a moving camera
+looks the same as without accumulation.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+
+#include "FrameSnapshot.h"
+#include "ShaderManager.h"
+
+/* Constants */
+const unsigned int MAX_ACCUMULATION_SAMPLES = 256;	// Image is final after this many samples
+
+/* Offscreen targets and the view the current average belongs to */
+struct Accumulation {
+	GLuint sceneFbo = 0;		// Single jittered frame
+	GLuint sceneColor = 0;
+	GLuint sceneDepth = 0;
+	GLuint accumFbo = 0;		// Running average, RGBA32F
+	GLuint accumTexture = 0;
+	GLuint vao = 0;				// Empty, the fullscreen triangle needs no attributes
+	ShaderProgram* copy = nullptr;
+	int width = 0;
+	int height = 0;
+	unsigned int samples = 0;	// Frames averaged so far
+
+	// View the samples were taken from
+	glm::mat4 view;
+	glm::mat4 projection;
+	WireframeMode wireFrame = WIREFRAME_OFF;
+	bool lightDraw = false;
+	bool overdraw = false;
+	const void* instances = nullptr;
+	unsigned int sceneVersion = 0;
+};
+
+/* Accumulation prototypes */
+void initAccumulation(Accumulation& accumulation);
+glm::mat4 beginAccumulation(Accumulation& accumulation, const FrameSnapshot& snapshot, unsigned int sceneVersion);
+bool accumulationConverged(const Accumulation& accumulation);
+bool endAccumulation(Accumulation& accumulation);
+void freeAccumulation(Accumulation& accumulation);
@@ -0,0 +1,73 @@
+/* Description:
+Replaces the global operator new/delete so every heap
+allocation made through new (including std containers)
+is counted. Counts are kept per thread, so the render
+thread's frame statistics only see its own allocations, not
+those of input, streaming or the encoders running beside it.
+FrameStats reports the count per frame; the steady-state
+render loop is expected to report zero.
+*/
+#include <cstdlib>
+#include <new>
+
+static thread_local unsigned long long allocations = 0;
+
+// Number of operator new calls made by the calling thread since it started
+unsigned long long heapAllocationCount()
+{
+	return allocations;
+}
+
+void* operator new(size_t size)
+{
+	allocations++;
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	allocations++;
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	free(p);
+}
@@ -0,0 +1,22 @@
+/* Description:
+Field readers and writers of the binary file formats (input
+logs, scenes). Fields are stored in native byte order with
+no padding.
+*/
+#pragma once
+
+#include <cstdio>
+
+// Write one field
+template <typename T>
+void writeField(FILE* file, T value)
+{
+	fwrite(&value, sizeof(T), 1, file);
+}
+
+// Read one field, false at end of file
+template <typename T>
+bool readField(FILE* file, T& value)
+{
+	return fread(&value, sizeof(T), 1, file) == 1;
+}
@@ -0,0 +1,179 @@
+#include "DrawList.h"
+#include "GLState.h"
+#include "FrameStats.h"
+
+#include <cstring>
+
+using namespace std;
+
+/* Key field widths */
+const int DEPTH_BITS = 24;
+const int MESH_BITS = 12;
+const int MATERIAL_BITS = 12;
+const int PROGRAM_BITS = 8;
+const uint64_t DEPTH_MAX = (1ull << DEPTH_BITS) - 1;
+
+// Pack a sort key, depth is normalized to [0, 1] (0 = nearest)
+uint64_t makeSortKey(DrawPass pass, GLuint programId, GLuint materialId, GLuint meshId, GLfloat depth)
+{
+	uint64_t d = (uint64_t)(glm::clamp(depth, 0.0f, 1.0f) * DEPTH_MAX);
+	uint64_t program = programId & ((1u << PROGRAM_BITS) - 1);
+	uint64_t material = materialId & ((1u << MATERIAL_BITS) - 1);
+	uint64_t mesh = meshId & ((1u << MESH_BITS) - 1);
+	uint64_t state = (program << (MATERIAL_BITS + MESH_BITS)) | (material << MESH_BITS) | mesh;
+
+	// Transparent geometry must be blended back-to-front, depth takes priority over state
+	if (pass == PASS_TRANSPARENT)
+		return ((uint64_t)pass << 60) | ((DEPTH_MAX - d) << 32) | state;
+
+	// Everything else groups by state, then front-to-back
+	return ((uint64_t)pass << 60) | (state << DEPTH_BITS) | d;
+}
+
+// View-space depth of a transformed point, normalized to [0, 1] between the clip planes
+GLfloat quantizeDepth(const glm::mat4& view, const glm::mat4& model, const glm::vec3& center, GLfloat zNear, GLfloat zFar)
+{
+	glm::vec4 viewPos = view * model * glm::vec4(center, 1.0f);
+	return (-viewPos.z - zNear) / (zFar - zNear);
+}
+
+// Frustum planes from the rows of the view-projection matrix, normalized so distances are in world units (inside is positive)
+void frustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	for (int i = 0; i < 3; ++i) {
+		glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		planes[i * 2] = w + row;
+		planes[i * 2 + 1] = w - row;
+	}
+	for (int i = 0; i < 6; ++i)
+		planes[i] = planes[i] / glm::length(glm::vec3(planes[i]));
+}
+
+// Sphere is at least partly inside the planes
+bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, GLfloat radius)
+{
+	for (int i = 0; i < 6; ++i)
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+			return false;
+	return true;
+}
+
+// Start a new frame, arrays are carved from the frame arena
+void beginDrawList(DrawList& list, LinearArena& arena, size_t capacity)
+{
+	list.arena = &arena;
+	list.count = 0;
+	list.capacity = capacity;
+	list.commands = arenaAllocArray<DrawCommand>(arena, capacity);
+	list.keys = arenaAllocArray<uint64_t>(arena, capacity);
+	list.order = arenaAllocArray<uint32_t>(arena, capacity);
+}
+
+// Copy a draw's uniforms into the ring, false if this frame's segment is full
+bool stageDrawUniforms(GpuRingBuffer& ring, const PerDrawUniforms& uniforms, DrawCommand& command)
+{
+	GpuAllocation allocation = gpuRingAlloc(ring, sizeof(PerDrawUniforms));
+	if (!allocation.data)
+		return false;
+
+	memcpy(allocation.data, &uniforms, sizeof(PerDrawUniforms));
+	command.uniformOffset = allocation.offset;
+	return true;
+}
+
+void addDraw(DrawList& list, const DrawCommand& command)
+{
+	// Out of room: move to arrays twice the size, the old ones are released with the arena
+	if (list.count == list.capacity) {
+		size_t capacity = list.capacity ? list.capacity * 2 : 64;
+		DrawCommand* commands = arenaAllocArray<DrawCommand>(*list.arena, capacity);
+		uint64_t* keys = arenaAllocArray<uint64_t>(*list.arena, capacity);
+		uint32_t* order = arenaAllocArray<uint32_t>(*list.arena, capacity);
+		memcpy(commands, list.commands, list.count * sizeof(DrawCommand));
+		memcpy(keys, list.keys, list.count * sizeof(uint64_t));
+		memcpy(order, list.order, list.count * sizeof(uint32_t));
+		list.commands = commands;
+		list.keys = keys;
+		list.order = order;
+		list.capacity = capacity;
+	}
+
+	list.order[list.count] = (uint32_t)list.count;
+	list.keys[list.count] = command.key;
+	list.commands[list.count] = command;
+	list.count++;
+}
+
+// LSD radix sort on 8-bit digits, passes where every key shares the digit are skipped
+void sortDrawList(DrawList& list)
+{
+	size_t count = list.count;
+	uint64_t* keys = list.keys;
+	uint32_t* order = list.order;
+	uint64_t* keysOut = arenaAllocArray<uint64_t>(*list.arena, count);
+	uint32_t* orderOut = arenaAllocArray<uint32_t>(*list.arena, count);
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; ++i)
+			histogram[(keys[i] >> shift) & 0xFF]++;
+
+		// Nothing to do for this digit
+		if (count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count)
+			continue;
+
+		// Prefix sum gives each bucket's first slot
+		size_t offset = 0;
+		for (int b = 0; b < 256; ++b) {
+			size_t n = histogram[b];
+			histogram[b] = offset;
+			offset += n;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			size_t slot = histogram[(keys[i] >> shift) & 0xFF]++;
+			keysOut[slot] = keys[i];
+			orderOut[slot] = order[i];
+		}
+
+		swap(keys, keysOut);
+		swap(order, orderOut);
+	}
+
+	// Result may have ended up in the scratch buffers
+	list.keys = keys;
+	list.order = order;
+}
+
+// Issue the sorted draws, redundant binds are filtered by the state cache
+void submitDrawList(const DrawList& list, const GpuRingBuffer& uniforms)
+{
+	submitDrawPasses(list, uniforms, PASS_OPAQUE, PASS_TRANSPARENT, 0, false);
+}
+
+// Issue the sorted draws of passes first to last, all with program if it is not 0;
+// depth-only submission uses the position-only vertex arrays and binds no textures
+void submitDrawPasses(const DrawList& list, const GpuRingBuffer& uniforms, DrawPass first, DrawPass last, GLuint program, bool depthOnly)
+{
+	for (size_t i = 0; i < list.count; ++i) {
+		// Pass is the top four bits of the sorted keys
+		DrawPass pass = (DrawPass)(list.keys[i] >> 60);
+		if (pass < first)
+			continue;
+		if (pass > last)
+			break;
+
+		const DrawCommand& command = list.commands[list.order[i]];
+
+		stateUseProgram(program ? program : command.program);
+		stateBindVertexArray(depthOnly ? command.depthVao : command.vao);
+		if (command.texture && !depthOnly)
+			stateBindTexture(0, GL_TEXTURE_2D, command.texture);
+
+		stateBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, uniforms.buffer, command.uniformOffset, sizeof(PerDrawUniforms));
+		glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, (GLvoid*)(command.firstIndex * sizeof(GLuint)));
+		frameStats.drawCalls++;
+		frameStats.trianglesDrawn += command.indexCount / 3;
+	}
+}
@@ -0,0 +1,68 @@
+/* Description:
+Per-frame list of draw commands. Every draw is described by
+a packed 64-bit sort key; the list is radix sorted before
+submission so that state changes scale with the number of
+distinct programs/materials rather than objects, and opaque
+geometry is drawn front-to-back for early depth rejection.
+
+Key layout, most significant bits first:
+	opaque/lights:	pass(4) | program(8) | material(12) | mesh(12) | depth(24)
+	transparent:	pass(4) | inverted depth(24) | program(8) | material(12) | mesh(12)
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+
+#include "FrameArena.h"
+
+/* Draw passes, submitted in this order */
+enum DrawPass {
+	PASS_OPAQUE = 0,
+	PASS_LIGHTS = 1,
+	PASS_TRANSPARENT = 2
+};
+
+/* Constants */
+const GLuint PER_DRAW_BINDING = 0;		// Uniform buffer binding of the PerDraw block
+
+/* Layout of the std140 PerDraw uniform block */
+struct PerDrawUniforms {
+	glm::mat4 model;
+	float normalMatrix[12];		// mat3, each column padded to a vec4
+};
+
+/* Everything needed to issue one draw */
+struct DrawCommand {
+	uint64_t key;			// Sort key, see makeSortKey()
+	GLuint program;			// Shader program
+	GLuint vao;				// Vertex array
+	GLuint depthVao;		// Position-only vertex array for depth-only passes
+	GLuint texture;			// Texture bound to unit 0 (0 for none)
+	GLuint firstIndex;		// First index of the range drawn (level of detail)
+	GLsizei indexCount;		// Number of indices to draw
+	GLintptr uniformOffset;	// Offset of this draw's PerDrawUniforms in the uniform ring
+};
+
+/* Draws collected for one frame, storage comes from a frame arena */
+struct DrawList {
+	LinearArena* arena = nullptr;
+	DrawCommand* commands = nullptr;
+	uint64_t* keys = nullptr;
+	uint32_t* order = nullptr;		// Command indices in draw order
+	size_t count = 0;
+	size_t capacity = 0;
+};
+
+/* Draw list prototypes */
+uint64_t makeSortKey(DrawPass pass, GLuint programId, GLuint materialId, GLuint meshId, GLfloat depth);
+GLfloat quantizeDepth(const glm::mat4& view, const glm::mat4& model, const glm::vec3& center, GLfloat zNear, GLfloat zFar);
+void frustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, GLfloat radius);
+void beginDrawList(DrawList& list, LinearArena& arena, size_t capacity);
+bool stageDrawUniforms(GpuRingBuffer& ring, const PerDrawUniforms& uniforms, DrawCommand& command);
+void addDraw(DrawList& list, const DrawCommand& command);
+void sortDrawList(DrawList& list);
+void submitDrawList(const DrawList& list, const GpuRingBuffer& uniforms);
+void submitDrawPasses(const DrawList& list, const GpuRingBuffer& uniforms, DrawPass first, DrawPass last, GLuint program, bool depthOnly);
@@ -0,0 +1,156 @@
+#include "DynamicResolution.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "GLState.h"
+#include "FrameStats.h"
+#include "FrameTimings.h"
+
+using namespace std;
+
+/* Constants */
+const float MAX_RESOLUTION_SCALE = 1.0f;
+const float TARGET_HEADROOM = 0.9f;		// Aim this far below the target so noise does not push frames over it
+const float GROW_THRESHOLD = 0.75f;		// Only grow when frames take less than this much of the target
+const float SHRINK_GAIN = 0.5f;			// Fraction of the correction applied per sample when over the target
+const float GROW_GAIN = 0.1f;			// ... and when under it, growing too fast would overshoot again
+const float SHARPEN_AMOUNT = 0.6f;		// Unsharp mask strength at the smallest scale
+
+// Delete the offscreen target
+static void FreeTarget(DynamicResolution& resolution)
+{
+	glDeleteFramebuffers(1, &resolution.fbo);
+	glDeleteTextures(1, &resolution.color);
+	glDeleteRenderbuffers(1, &resolution.depth);
+
+	resolution.fbo = resolution.color = resolution.depth = 0;
+	resolution.width = resolution.height = 0;
+}
+
+// (Re)create the offscreen target at the window size
+static void CreateTarget(DynamicResolution& resolution, int width, int height)
+{
+	FreeTarget(resolution);
+	resolution.width = width;
+	resolution.height = height;
+
+	// Linear filtering does the bilinear part of the upscale
+	glGenTextures(1, &resolution.color);
+	stateBindTexture(0, GL_TEXTURE_2D, resolution.color);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	stateBindTexture(0, GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &resolution.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, resolution.depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &resolution.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, resolution.fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolution.color, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, resolution.depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		cout << "Dynamic resolution framebuffer is incomplete" << endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Move the scale toward the one that would have met the target, from the newest GPU time available
+static void UpdateScale(DynamicResolution& resolution, const FrameSnapshot& snapshot)
+{
+	unsigned long long frame;
+	double gpuMs;
+	if (!latestGpuTiming(frame, gpuMs) || frame <= resolution.changedFrame || gpuMs <= 0.0)
+		return;
+
+	GLfloat target = snapshot.frameTargetMs;
+	GLfloat gain;
+	if (gpuMs > target)
+		gain = SHRINK_GAIN;
+	else if (gpuMs < target * GROW_THRESHOLD)
+		gain = GROW_GAIN;
+	else
+		return;
+
+	// Pixel count, and so roughly GPU time, grows with the square of the scale
+	GLfloat ideal = resolution.scale * sqrt(target * TARGET_HEADROOM / (GLfloat)gpuMs);
+	GLfloat scale = resolution.scale + (ideal - resolution.scale) * gain;
+	scale = min(max(scale, MIN_RESOLUTION_SCALE), MAX_RESOLUTION_SCALE);
+	if (scale == resolution.scale)
+		return;
+
+	resolution.scale = scale;
+	resolution.changedFrame = snapshot.frame;
+}
+
+// Load the upscale shader, the target is created on first use
+void initDynamicResolution(DynamicResolution& resolution)
+{
+	resolution.upscale = loadShaderProgram("shaders/fullscreen.vert", "shaders/upscale.frag");
+	glGenVertexArrays(1, &resolution.vao);
+}
+
+// Pick this frame's scale, bind the target and shrink the viewport to it
+void beginDynamicResolution(DynamicResolution& resolution, const FrameSnapshot& snapshot)
+{
+	if (snapshot.width != resolution.width || snapshot.height != resolution.height)
+		CreateTarget(resolution, snapshot.width, snapshot.height);
+
+	UpdateScale(resolution, snapshot);
+	resolution.renderWidth = max(1, (int)(snapshot.width * resolution.scale + 0.5f));
+	resolution.renderHeight = max(1, (int)(snapshot.height * resolution.scale + 0.5f));
+	frameStats.resolutionScale = resolution.scale;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, resolution.fbo);
+	stateViewport(0, 0, resolution.renderWidth, resolution.renderHeight);
+}
+
+// Scale the rendered part of the target up to the window
+void endDynamicResolution(DynamicResolution& resolution, const FrameSnapshot& snapshot)
+{
+	// Upscale shader still compiling, a linear blit is plain bilinear
+	if (resolution.upscale->program == 0) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, resolution.fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, resolution.renderWidth, resolution.renderHeight, 0, 0, snapshot.width, snapshot.height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		stateViewport(0, 0, snapshot.width, snapshot.height);
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	stateViewport(0, 0, snapshot.width, snapshot.height);
+	statePolygonMode(GL_FILL);
+	stateEnable(GL_DEPTH_TEST, false);
+
+	// Sharpen in proportion to how much detail the lower resolution lost
+	GLfloat sharpness = 0.0f;
+	if (snapshot.sharpenUpscale)
+		sharpness = SHARPEN_AMOUNT * (1.0f - resolution.scale) / (1.0f - MIN_RESOLUTION_SCALE);
+
+	GLuint program = resolution.upscale->program;
+	stateUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "source"), 0);
+	glUniform2f(glGetUniformLocation(program, "uvScale"), (GLfloat)resolution.renderWidth / resolution.width, (GLfloat)resolution.renderHeight / resolution.height);
+	glUniform2f(glGetUniformLocation(program, "texelSize"), 1.0f / resolution.width, 1.0f / resolution.height);
+	glUniform1f(glGetUniformLocation(program, "sharpness"), sharpness);
+	stateBindTexture(0, GL_TEXTURE_2D, resolution.color);
+	stateBindVertexArray(resolution.vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	frameStats.drawCalls++;
+
+	stateEnable(GL_DEPTH_TEST, true);
+}
+
+// Release the target and the vertex array (the shader belongs to the shader manager)
+void freeDynamicResolution(DynamicResolution& resolution)
+{
+	FreeTarget(resolution);
+	glDeleteVertexArrays(1, &resolution.vao);
+	resolution.vao = 0;
+}
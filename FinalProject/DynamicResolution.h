@@ -0,0 +1,48 @@
+/* Description:
+Dynamic resolution. The scene is drawn into an offscreen
+target at a fraction of the window size and scaled up to
+the window, with plain bilinear filtering or bilinear plus
+a sharpening pass.
+
+The fraction is picked by a feedback controller from the
+GPU time of recent frames (timer queries, see
+FrameTimings.h): over the frame time target it drops
+quickly, with plenty of headroom it grows slowly back
+toward full size. GPU cost is taken to grow with the pixel
+count, i.e. with the square of the scale. Results arrive a
+few frames late, so frames drawn before the last change
+are ignored.
+
+The target is allocated at the window size and only the
+viewport shrinks, so changing the scale never reallocates.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+
+#include "FrameSnapshot.h"
+#include "ShaderManager.h"
+
+/* Constants */
+const float MIN_RESOLUTION_SCALE = 0.5f;	// Smallest fraction of the window size rendered
+
+/* Offscreen target and controller state */
+struct DynamicResolution {
+	GLuint fbo = 0;
+	GLuint color = 0;
+	GLuint depth = 0;
+	GLuint vao = 0;				// Empty, the fullscreen triangle needs no attributes
+	ShaderProgram* upscale = nullptr;
+	int width = 0;				// Target size (the window size)
+	int height = 0;
+	int renderWidth = 0;		// Part of the target drawn this frame
+	int renderHeight = 0;
+	float scale = 1.0f;			// renderWidth / width
+	unsigned long long changedFrame = 0;	// GPU times of frames up to this one predate the current scale
+};
+
+/* Dynamic resolution prototypes */
+void initDynamicResolution(DynamicResolution& resolution);
+void beginDynamicResolution(DynamicResolution& resolution, const FrameSnapshot& snapshot);
+void endDynamicResolution(DynamicResolution& resolution, const FrameSnapshot& snapshot);
+void freeDynamicResolution(DynamicResolution& resolution);
@@ -0,0 +1,270 @@
+#include "FrameArena.h"
+#include "FrameStats.h"
+
+#include <iostream>
+#include <new>
+#include <cstring>
+
+using namespace std;
+
+/* Constants */
+const size_t OVERFLOW_BLOCKS = 64;		// Overflow slots reserved up front
+const GLuint64 FENCE_TIMEOUT = 1000000000;	// 1 second, in nanoseconds
+
+/* Module state */
+static LinearArena frameArenas[FRAMES_IN_FLIGHT];
+static int currentArena = 0;
+
+// Round value up to a power-of-two alignment
+static size_t AlignUp(size_t value, size_t align)
+{
+	return (value + align - 1) & ~(align - 1);
+}
+
+void initArena(LinearArena& arena, size_t capacity)
+{
+	arena.base = static_cast<unsigned char*>(::operator new(capacity));
+	arena.capacity = capacity;
+	arena.used = 0;
+	arena.peak = 0;
+	arena.overflow.reserve(OVERFLOW_BLOCKS);
+}
+
+// Release everything allocated since the last reset, growing the arena if it overflowed
+void resetArena(LinearArena& arena)
+{
+	for (void* block : arena.overflow)
+		::operator delete(block);
+	arena.overflow.clear();
+
+	if (arena.peak > arena.capacity) {
+		size_t capacity = arena.peak + arena.peak / 2;
+		::operator delete(arena.base);
+		arena.base = static_cast<unsigned char*>(::operator new(capacity));
+		arena.capacity = capacity;
+	}
+
+	arena.used = 0;
+}
+
+void freeArena(LinearArena& arena)
+{
+	resetArena(arena);
+	::operator delete(arena.base);
+	arena.base = nullptr;
+	arena.capacity = 0;
+}
+
+// Bump allocate, falls back to the heap (and grows at next reset) when full
+void* arenaAlloc(LinearArena& arena, size_t size, size_t align)
+{
+	size_t start = AlignUp(arena.used, align);
+
+	if (start + size <= arena.capacity) {
+		arena.used = start + size;
+		if (arena.used > arena.peak)
+			arena.peak = arena.used;
+		return arena.base + start;
+	}
+
+	// Out of space: remember the demand so the arena grows next frame
+	arena.used = start + size;
+	if (arena.used > arena.peak)
+		arena.peak = arena.used;
+
+	void* block = ::operator new(size + align);
+	arena.overflow.push_back(block);
+	return reinterpret_cast<void*>(AlignUp(reinterpret_cast<size_t>(block), align));
+}
+
+void initFrameArenas(size_t bytesPerFrame)
+{
+	for (LinearArena& arena : frameArenas)
+		initArena(arena, bytesPerFrame);
+	currentArena = 0;
+}
+
+// Advance to the next arena and release what it held FRAMES_IN_FLIGHT frames ago
+LinearArena& beginFrameArena()
+{
+	currentArena = (currentArena + 1) % FRAMES_IN_FLIGHT;
+	resetArena(frameArenas[currentArena]);
+	return frameArenas[currentArena];
+}
+
+LinearArena& frameArena()
+{
+	return frameArenas[currentArena];
+}
+
+void freeFrameArenas()
+{
+	for (LinearArena& arena : frameArenas)
+		freeArena(arena);
+}
+
+// Create the buffer object for segmentSize and map it for the lifetime of the ring
+static void CreateRingStorage(GpuRingBuffer& ring)
+{
+	GLenum target = ring.target;
+	size_t total = ring.segmentSize * FRAMES_IN_FLIGHT;
+	ring.persistent = false;
+
+	glGenBuffers(1, &ring.buffer);
+	glBindBuffer(target, ring.buffer);
+
+	if (GLEW_ARB_buffer_storage) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, total, nullptr, flags);
+		ring.mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, total, flags));
+		ring.persistent = ring.mapped != nullptr;
+	}
+
+	// No persistent mapping: write to a CPU copy and upload the used range at flush
+	if (!ring.persistent) {
+		glBufferData(target, total, nullptr, GL_STREAM_DRAW);
+		ring.shadow.resize(total);
+		ring.mapped = ring.shadow.data();
+	}
+
+	glBindBuffer(target, 0);
+}
+
+// Unmap and delete the buffer object, draws already issued keep reading the old storage
+static void ReleaseRingStorage(GpuRingBuffer& ring)
+{
+	for (GLsync& fence : ring.fences) {
+		if (fence)
+			glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (ring.persistent) {
+		glBindBuffer(ring.target, ring.buffer);
+		glUnmapBuffer(ring.target);
+		glBindBuffer(ring.target, 0);
+	}
+
+	glDeleteBuffers(1, &ring.buffer);
+	ring.buffer = 0;
+	ring.mapped = nullptr;
+	ring.shadow.clear();
+}
+
+// Replace the buffer with one whose segments hold bytes, with room to spare like a grown arena
+static void GrowGpuRing(GpuRingBuffer& ring, size_t bytes)
+{
+	ReleaseRingStorage(ring);
+	ring.segmentSize = AlignUp(bytes + bytes / 2, ring.alignment);
+	CreateRingStorage(ring);
+	ring.head = 0;
+	ring.flushed = 0;
+	ring.demand = 0;
+	cout << "GPU ring grown to " << ring.segmentSize / 1024 << "KB per frame" << endl;
+}
+
+bool initGpuRing(GpuRingBuffer& ring, GLenum target, size_t bytesPerFrame)
+{
+	GLint alignment = 16;
+	if (target == GL_UNIFORM_BUFFER)
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	else if (target == GL_SHADER_STORAGE_BUFFER)
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	ring.target = target;
+	ring.alignment = alignment > 16 ? alignment : 16;
+	ring.segmentSize = AlignUp(bytesPerFrame, ring.alignment);
+	CreateRingStorage(ring);
+
+	ring.segment = 0;
+	ring.head = 0;
+	ring.flushed = 0;
+	ring.demand = 0;
+	ring.peak = 0;
+	return ring.buffer != 0;
+}
+
+// Move to the next segment, waiting only if the GPU has not finished with it yet
+void beginGpuRingFrame(GpuRingBuffer& ring)
+{
+	// A frame that did not fit grows the ring, the fenced segments go with the old buffer
+	if (ring.peak > ring.segmentSize) {
+		GrowGpuRing(ring, ring.peak);
+		return;
+	}
+
+	ring.segment = (ring.segment + 1) % FRAMES_IN_FLIGHT;
+
+	GLsync& fence = ring.fences[ring.segment];
+	if (fence) {
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			frameStats.fenceWaits++;
+			do {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	ring.head = 0;
+	ring.flushed = 0;
+	ring.demand = 0;
+}
+
+// Make sure count allocations of size bytes fit in this frame's segment. Before the frame's first allocation the
+// ring grows right away; after it, offsets already handed out point into the buffer, so only the next frame grows
+void reserveGpuRing(GpuRingBuffer& ring, size_t count, size_t size)
+{
+	size_t bytes = AlignUp(ring.demand, ring.alignment) + count * AlignUp(size, ring.alignment);
+	if (bytes <= ring.segmentSize)
+		return;
+
+	if (ring.demand == 0)
+		GrowGpuRing(ring, bytes);
+	else if (bytes > ring.peak)
+		ring.peak = bytes;
+}
+
+// Reserve aligned space in this frame's segment, data is nullptr if the segment is full
+GpuAllocation gpuRingAlloc(GpuRingBuffer& ring, size_t size)
+{
+	// Demand counts what did not fit too, so the next frame grows to hold all of it
+	size_t start = AlignUp(ring.head, ring.alignment);
+	ring.demand = AlignUp(ring.demand, ring.alignment) + size;
+	if (ring.demand > ring.peak)
+		ring.peak = ring.demand;
+	if (start + size > ring.segmentSize) {
+		frameStats.ringOverflows++;
+		return { nullptr, 0 };
+	}
+
+	ring.head = start + size;
+	size_t offset = ring.segment * ring.segmentSize + start;
+	return { ring.mapped + offset, (GLintptr)offset };
+}
+
+// Make writes visible to the GPU (only needed without a persistent mapping)
+void flushGpuRing(GpuRingBuffer& ring)
+{
+	if (ring.persistent || ring.head == ring.flushed)
+		return;
+
+	size_t offset = ring.segment * ring.segmentSize + ring.flushed;
+	glBindBuffer(ring.target, ring.buffer);
+	glBufferSubData(ring.target, offset, ring.head - ring.flushed, ring.mapped + offset);
+	glBindBuffer(ring.target, 0);
+	ring.flushed = ring.head;
+}
+
+// Fence the segment after the frame's commands that read it
+void endGpuRingFrame(GpuRingBuffer& ring)
+{
+	ring.fences[ring.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void freeGpuRing(GpuRingBuffer& ring)
+{
+	ReleaseRingStorage(ring);
+}
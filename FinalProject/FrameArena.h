@@ -0,0 +1,83 @@
+/* Description:
+Per-frame memory for transient render data.
+
+LinearArena is a bump allocator: allocations are a pointer
+increment and the whole arena is released at once. Frame
+arenas rotate through FRAMES_IN_FLIGHT arenas so data built
+for one frame stays valid while the next is being built.
+
+GpuRingBuffer is the GPU-side equivalent: one buffer object,
+persistently mapped when ARB_buffer_storage is available,
+split into one segment per frame in flight. A fence placed
+at the end of each frame guards its segment from being
+overwritten while the GPU may still read it. A frame that
+needs more than a segment grows the ring: right away when it
+reserves before allocating, otherwise at the next frame.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <cstddef>
+#include <vector>
+
+/* Constants */
+const int FRAMES_IN_FLIGHT = 3;		// Frames the CPU may run ahead of the GPU
+
+/* Bump allocator */
+struct LinearArena {
+	unsigned char* base = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+	size_t peak = 0;				// Highest use seen, drives growth
+	std::vector<void*> overflow;	// Heap blocks handed out when the arena was full
+};
+
+/* Persistently mapped, fenced ring buffer */
+struct GpuRingBuffer {
+	GLuint buffer = 0;
+	GLenum target = GL_UNIFORM_BUFFER;
+	size_t segmentSize = 0;			// Bytes available to each frame
+	size_t alignment = 16;			// Offset alignment required by target
+	unsigned char* mapped = nullptr;	// Persistent mapping (or shadow copy when unsupported)
+	bool persistent = false;
+	std::vector<unsigned char> shadow;	// CPU copy uploaded at flush when not persistent
+	GLsync fences[FRAMES_IN_FLIGHT] = {};
+	int segment = 0;				// Segment owned by the current frame
+	size_t head = 0;				// Bytes used in the current segment
+	size_t flushed = 0;				// Bytes already uploaded (non-persistent path)
+	size_t demand = 0;				// Bytes requested this frame, including allocations that did not fit
+	size_t peak = 0;				// Highest demand seen, drives growth
+};
+
+/* Sub-allocation from the ring */
+struct GpuAllocation {
+	void* data;				// Write pointer
+	GLintptr offset;		// Offset within the buffer object
+};
+
+/* Arena prototypes */
+void initArena(LinearArena& arena, size_t capacity);
+void resetArena(LinearArena& arena);
+void freeArena(LinearArena& arena);
+void* arenaAlloc(LinearArena& arena, size_t size, size_t align = 16);
+
+template <typename T>
+T* arenaAllocArray(LinearArena& arena, size_t count)
+{
+	return static_cast<T*>(arenaAlloc(arena, sizeof(T) * count, alignof(T)));
+}
+
+/* Frame arena prototypes */
+void initFrameArenas(size_t bytesPerFrame);
+LinearArena& beginFrameArena();
+LinearArena& frameArena();
+void freeFrameArenas();
+
+/* GPU ring buffer prototypes */
+bool initGpuRing(GpuRingBuffer& ring, GLenum target, size_t bytesPerFrame);
+void beginGpuRingFrame(GpuRingBuffer& ring);
+void reserveGpuRing(GpuRingBuffer& ring, size_t count, size_t size);
+GpuAllocation gpuRingAlloc(GpuRingBuffer& ring, size_t size);
+void flushGpuRing(GpuRingBuffer& ring);
+void endGpuRingFrame(GpuRingBuffer& ring);
+void freeGpuRing(GpuRingBuffer& ring);
@@ -0,0 +1,323 @@
+#include "FrameCapture.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include <SOIL2\SOIL2.h>
+
+#include "FrameArena.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+/* Constants */
+const int CAPTURE_SLOTS = FRAMES_IN_FLIGHT + 1;	// Read-backs in flight before one must be finished
+const size_t MAX_QUEUED_FRAMES = 16;			// Frames waiting for the encoders before the render thread waits
+
+/* Read-back in flight */
+struct CaptureSlot {
+	GLuint pbo = 0;
+	GLsync fence = 0;			// Passed once the pixels are in the buffer
+	size_t size = 0;			// Bytes allocated for the buffer
+	unsigned long long frame = 0;
+	int width = 0;
+	int height = 0;
+};
+
+/* Module state */
+static CaptureFormat format = CAPTURE_PNG;
+static string outputPath;				// PNG folder or Y4M file
+static FILE* videoFile = nullptr;
+static int videoFps = 60;
+static int videoWidth = 0, videoHeight = 0;	// Size of the first frame, 0 until it arrives
+static bool enabled = false;
+static bool created = false;
+static CaptureSlot slots[CAPTURE_SLOTS];
+static int currentSlot = 0;
+static WorkerPool encoders;
+
+// Video frames are converted in any order but written in sequence
+static mutex videoMutex;
+static condition_variable videoTurn;
+static unsigned long long videoSubmitted = 0;	// Sequence numbers handed out (render thread)
+static unsigned long long videoWritten = 0;		// Frames written or skipped so far
+
+// Pixel buffers come back from the encoders for reuse, so capturing does not allocate every frame
+static mutex bufferMutex;
+static vector<vector<unsigned char>> freeBuffers;
+
+static vector<unsigned char> TakeBuffer(size_t size)
+{
+	vector<unsigned char> buffer;
+	{
+		lock_guard<mutex> lock(bufferMutex);
+		if (!freeBuffers.empty()) {
+			buffer = move(freeBuffers.back());
+			freeBuffers.pop_back();
+		}
+	}
+	buffer.resize(size);
+	return buffer;
+}
+
+static void ReturnBuffer(vector<unsigned char>&& buffer)
+{
+	lock_guard<mutex> lock(bufferMutex);
+	freeBuffers.push_back(move(buffer));
+}
+
+// RGBA rows from the bottom up to RGB rows from the top down
+static void ToImageRows(const unsigned char* rgba, int width, int height, unsigned char* rgb)
+{
+	for (int y = 0; y < height; ++y) {
+		const unsigned char* source = rgba + (size_t)(height - 1 - y) * width * 4;
+		unsigned char* target = rgb + (size_t)y * width * 3;
+		for (int x = 0; x < width; ++x) {
+			target[x * 3] = source[x * 4];
+			target[x * 3 + 1] = source[x * 4 + 1];
+			target[x * 3 + 2] = source[x * 4 + 2];
+		}
+	}
+}
+
+// Encode one frame as a PNG (encoder thread)
+static void EncodePng(vector<unsigned char>& pixels, unsigned long long frame, int width, int height)
+{
+	vector<unsigned char> rgb((size_t)width * height * 3);
+	ToImageRows(pixels.data(), width, height, rgb.data());
+
+	char path[512];
+	snprintf(path, sizeof(path), "%s/frame_%06llu.png", outputPath.c_str(), frame);
+	if (!SOIL_save_image(path, SOIL_SAVE_TYPE_PNG, width, height, 3, rgb.data()))
+		cout << "Failed to save capture " << path << endl;
+}
+
+// Full range BT.601 4:2:0 planes (encoder thread)
+static void ToYuv420(const unsigned char* rgba, int width, int height, vector<unsigned char>& yuv)
+{
+	int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	yuv.resize((size_t)width * height + 2 * (size_t)chromaWidth * chromaHeight);
+	unsigned char* yPlane = yuv.data();
+	unsigned char* uPlane = yPlane + (size_t)width * height;
+	unsigned char* vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+	// Image rows go from the top, GL rows from the bottom
+	for (int y = 0; y < height; ++y) {
+		const unsigned char* row = rgba + (size_t)(height - 1 - y) * width * 4;
+		for (int x = 0; x < width; ++x) {
+			float r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+			yPlane[(size_t)y * width + x] = (unsigned char)min(255.0f, 0.299f * r + 0.587f * g + 0.114f * b + 0.5f);
+		}
+	}
+
+	// Chroma of each 2x2 block from its average color
+	for (int cy = 0; cy < chromaHeight; ++cy) {
+		for (int cx = 0; cx < chromaWidth; ++cx) {
+			float r = 0.0f, g = 0.0f, b = 0.0f;
+			int samples = 0;
+			for (int dy = 0; dy < 2 && cy * 2 + dy < height; ++dy) {
+				const unsigned char* row = rgba + (size_t)(height - 1 - (cy * 2 + dy)) * width * 4;
+				for (int dx = 0; dx < 2 && cx * 2 + dx < width; ++dx) {
+					const unsigned char* p = row + (cx * 2 + dx) * 4;
+					r += p[0];
+					g += p[1];
+					b += p[2];
+					samples++;
+				}
+			}
+			r /= samples;
+			g /= samples;
+			b /= samples;
+
+			size_t i = (size_t)cy * chromaWidth + cx;
+			uPlane[i] = (unsigned char)max(0.0f, min(255.0f, -0.168736f * r - 0.331264f * g + 0.5f * b + 128.5f));
+			vPlane[i] = (unsigned char)max(0.0f, min(255.0f, 0.5f * r - 0.418688f * g - 0.081312f * b + 128.5f));
+		}
+	}
+}
+
+// Convert one frame, then wait for its turn to be written (encoder thread)
+static void EncodeY4m(vector<unsigned char>& pixels, unsigned long long sequence, int width, int height)
+{
+	vector<unsigned char> yuv;
+	bool matches = width == videoWidth && height == videoHeight;
+	if (matches)
+		ToYuv420(pixels.data(), width, height, yuv);
+
+	unique_lock<mutex> lock(videoMutex);
+	videoTurn.wait(lock, [sequence] { return videoWritten == sequence; });
+	if (matches) {
+		fputs("FRAME\n", videoFile);
+		fwrite(yuv.data(), 1, yuv.size(), videoFile);
+	}
+	else {
+		cout << "Skipped a " << width << "x" << height << " frame, the video is " << videoWidth << "x" << videoHeight << endl;
+	}
+	videoWritten++;
+	lock.unlock();
+	videoTurn.notify_all();
+}
+
+// Copy a finished read-back out of its buffer and queue it for encoding
+static void FinishSlot(CaptureSlot& slot, bool wait)
+{
+	if (!slot.fence)
+		return;
+
+	GLenum status = glClientWaitSync(slot.fence, 0, wait ? GL_TIMEOUT_IGNORED : 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return;
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	size_t size = (size_t)slot.width * slot.height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (!mapped) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		return;
+	}
+
+	// Shared so the job stays copyable for std::function
+	shared_ptr<vector<unsigned char>> pixels = make_shared<vector<unsigned char>>(TakeBuffer(size));
+	memcpy(pixels->data(), mapped, size);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// Encoders are behind, waiting here is the only way to keep every frame
+	if (pendingWork(encoders) >= MAX_QUEUED_FRAMES)
+		waitWorkerPool(encoders, MAX_QUEUED_FRAMES - 1);
+
+	int width = slot.width, height = slot.height;
+	unsigned long long frame = slot.frame;
+	if (format == CAPTURE_PNG) {
+		submitWork(encoders, [pixels, frame, width, height] {
+			EncodePng(*pixels, frame, width, height);
+			ReturnBuffer(move(*pixels));
+		});
+	}
+	else {
+		// Header needs the size, so it is written once the first frame arrives
+		if (videoWidth == 0) {
+			videoWidth = width;
+			videoHeight = height;
+			fprintf(videoFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, videoFps);
+		}
+
+		unsigned long long sequence = videoSubmitted++;
+		submitWork(encoders, [pixels, sequence, width, height] {
+			EncodeY4m(*pixels, sequence, width, height);
+			ReturnBuffer(move(*pixels));
+		});
+	}
+}
+
+// Choose the output, called before the render thread starts
+bool openFrameCapture(const string& path, CaptureFormat captureFormat, int fps)
+{
+	format = captureFormat;
+	outputPath = path;
+	videoFps = max(fps, 1);
+
+	if (format == CAPTURE_Y4M) {
+		videoFile = fopen(path.c_str(), "wb");
+		if (!videoFile) {
+			cout << "Could not create video file " << path << endl;
+			return false;
+		}
+	}
+
+	startWorkerPool(encoders);
+	enabled = true;
+	return true;
+}
+
+// Frames are being captured
+bool frameCaptureEnabled()
+{
+	return enabled;
+}
+
+// Start reading back the back buffer, after the frame is drawn and before it is swapped
+void captureFrame(unsigned long long frame, int width, int height)
+{
+	if (!enabled || width <= 0 || height <= 0)
+		return;
+
+	if (!created) {
+		for (CaptureSlot& slot : slots)
+			glGenBuffers(1, &slot.pbo);
+		created = true;
+	}
+
+	// Hand over every finished read-back, then make sure this frame's slot is free
+	pollFrameCapture();
+	CaptureSlot& slot = slots[currentSlot];
+	FinishSlot(slot, true);
+
+	size_t size = (size_t)width * height * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	if (size > slot.size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.size = size;
+	}
+
+	// RGBA rows are 4-byte aligned, the copy into the buffer happens on the GPU
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadBuffer(GL_BACK);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frame;
+	slot.width = width;
+	slot.height = height;
+	currentSlot = (currentSlot + 1) % CAPTURE_SLOTS;
+}
+
+// Queue every read-back the GPU has finished, oldest first
+void pollFrameCapture()
+{
+	if (!created)
+		return;
+
+	for (int i = 0; i < CAPTURE_SLOTS; ++i) {
+		CaptureSlot& slot = slots[(currentSlot + i) % CAPTURE_SLOTS];
+		FinishSlot(slot, false);
+		if (slot.fence)
+			break;
+	}
+}
+
+// Finish outstanding read-backs and encodes, the GL context must still be current
+void closeFrameCapture()
+{
+	if (!enabled)
+		return;
+
+	if (created) {
+		for (int i = 0; i < CAPTURE_SLOTS; ++i)
+			FinishSlot(slots[(currentSlot + i) % CAPTURE_SLOTS], true);
+
+		for (CaptureSlot& slot : slots) {
+			glDeleteBuffers(1, &slot.pbo);
+			slot = CaptureSlot();
+		}
+		created = false;
+	}
+
+	stopWorkerPool(encoders);
+	if (videoFile) {
+		fclose(videoFile);
+		videoFile = nullptr;
+	}
+
+	freeBuffers.clear();
+	enabled = false;
+}
@@ -0,0 +1,35 @@
+/* Description:
+Captures rendered frames without stalling the render thread.
+Each frame is copied from the back buffer into one of a ring
+of pixel buffer objects and fenced; a few frames later, once
+the fence has passed, the pixels are mapped, copied out and
+handed to a pool of encoder threads. The render thread only
+waits when the encoders fall too far behind.
+
+Frames are written either as a PNG sequence (frame_<n>.png
+in a folder, encoded in parallel) or as one raw Y4M video
+(4:2:0, converted in parallel, written in frame order). A
+video keeps the size of its first frame; frames of another
+size are skipped.
+
+openFrameCapture() runs on the main thread before the render
+thread starts; everything else on the render thread, with
+the GL context current.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <string>
+
+/* Output written by the capture */
+enum CaptureFormat {
+	CAPTURE_PNG = 0,	// One PNG per frame in a folder
+	CAPTURE_Y4M = 1		// Raw YUV 4:2:0 video in a single file
+};
+
+/* Frame capture prototypes */
+bool openFrameCapture(const std::string& path, CaptureFormat format, int fps);
+bool frameCaptureEnabled();
+void captureFrame(unsigned long long frame, int width, int height);
+void pollFrameCapture();
+void closeFrameCapture();
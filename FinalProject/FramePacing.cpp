@@ -0,0 +1,146 @@
+#include "FramePacing.h"
+
+#include <GLFW/glfw3.h>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+using namespace std;
+
+/* Constants */
+const double SPIN_MARGIN = 0.002;		// Seconds before a deadline to stop sleeping and start spinning
+const double LATENCY_INTERVAL = 1.0;	// Seconds per latency report
+
+/* Module state */
+static mutex latencyMutex;				// Samples are added on the render thread, read on the main thread
+static LatencySample latencyCurrent;
+static double latencyTotalMs = 0.0;
+static double latencyStart = -1.0;
+
+// Read a swap mode from the command line ("off", "on" or "adaptive")
+bool parseSwapMode(const string& name, SwapMode& mode)
+{
+	if (name == "off")
+		mode = SWAP_OFF;
+	else if (name == "on")
+		mode = SWAP_ON;
+	else if (name == "adaptive")
+		mode = SWAP_ADAPTIVE;
+	else
+		return false;
+
+	return true;
+}
+
+// Printable name of a swap mode
+const char* swapModeName(SwapMode mode)
+{
+	switch (mode) {
+	case SWAP_OFF:
+		return "off";
+	case SWAP_ADAPTIVE:
+		return "adaptive";
+	default:
+		return "on";
+	}
+}
+
+// Set the swap interval of the current context, returns the mode actually used
+SwapMode applySwapMode(SwapMode mode)
+{
+	// Adaptive vsync is a negative interval, only valid with the swap_control_tear extensions
+	if (mode == SWAP_ADAPTIVE &&
+		!glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+		!glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+		mode = SWAP_ON;
+
+	glfwSwapInterval(mode == SWAP_ADAPTIVE ? -1 : (int)mode);
+	return mode;
+}
+
+// Limit to framesPerSecond, 0 disables the limiter
+void initFrameLimiter(FrameLimiter& limiter, double framesPerSecond)
+{
+	limiter.period = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+	limiter.deadline = glfwGetTime();
+
+#ifdef _WIN32
+	// Default scheduler tick is ~15ms, far too coarse for frame pacing
+	if (limiter.period > 0.0)
+		limiter.finePeriod = timeBeginPeriod(1) == TIMERR_NOERROR;
+#endif
+}
+
+// Wait for the start of the next frame slot
+void waitFrameLimiter(FrameLimiter& limiter)
+{
+	if (limiter.period <= 0.0)
+		return;
+
+	limiter.deadline += limiter.period;
+
+	// Fell more than a frame behind, restart from now instead of racing to catch up
+	double now = glfwGetTime();
+	if (limiter.deadline < now - limiter.period)
+		limiter.deadline = now;
+
+	sleepUntil(limiter.deadline);
+}
+
+// Give back the timer resolution the limiter asked for
+void shutdownFrameLimiter(FrameLimiter& limiter)
+{
+#ifdef _WIN32
+	if (limiter.finePeriod)
+		timeEndPeriod(1);
+#endif
+	limiter.finePeriod = false;
+	limiter.period = 0.0;
+}
+
+// Sleep most of the way to time, then spin for accuracy
+void sleepUntil(double time)
+{
+	double now = glfwGetTime();
+	if (time - now > SPIN_MARGIN)
+		this_thread::sleep_for(chrono::duration<double>(time - now - SPIN_MARGIN));
+
+	while (glfwGetTime() < time)
+		this_thread::yield();
+}
+
+// Record one input-to-present latency (render thread)
+void addLatencySample(double latencySeconds)
+{
+	lock_guard<mutex> lock(latencyMutex);
+	double ms = latencySeconds * 1000.0;
+	latencyCurrent.count++;
+	latencyTotalMs += ms;
+	latencyCurrent.maxMs = max(latencyCurrent.maxMs, ms);
+}
+
+// Close the reporting interval once it has passed, true with the finished sample
+bool updateLatency(double currentTime, LatencySample& sample)
+{
+	lock_guard<mutex> lock(latencyMutex);
+	if (latencyStart < 0.0)
+		latencyStart = currentTime;
+	if (currentTime - latencyStart < LATENCY_INTERVAL)
+		return false;
+
+	sample = latencyCurrent;
+	sample.averageMs = sample.count ? latencyTotalMs / sample.count : 0.0;
+
+	latencyCurrent = LatencySample();
+	latencyTotalMs = 0.0;
+	latencyStart = currentTime;
+	return true;
+}
@@ -0,0 +1,47 @@
+/* Description:
+Frame pacing controls: the swap interval (vsync off, on or
+adaptive, where late frames tear instead of waiting a whole
+refresh), a frame rate limiter that sleeps for most of the
+wait and spins for the last stretch so it wakes on time,
+and input-to-present latency statistics.
+
+Latency is measured from the timestamp of the first input
+event that changed a frame to the moment glfwSwapBuffers
+returns on the render thread. Drivers may queue the swap,
+so this is a lower bound on the true photon latency.
+*/
+#pragma once
+
+#include <string>
+
+/* Swap interval choices */
+enum SwapMode {
+	SWAP_OFF = 0,		// Present immediately (may tear)
+	SWAP_ON = 1,		// Wait for vertical blank
+	SWAP_ADAPTIVE = 2	// Wait for vertical blank unless the frame is late
+};
+
+/* Limits how often the main thread builds frames */
+struct FrameLimiter {
+	double period = 0.0;		// Seconds per frame, 0 for no limit
+	double deadline = 0.0;		// glfwGetTime() the next frame may start
+	bool finePeriod = false;	// Raised the system timer resolution, restored on shutdown
+};
+
+/* Input-to-present latency over the last reporting interval */
+struct LatencySample {
+	unsigned int count = 0;
+	double averageMs = 0.0;
+	double maxMs = 0.0;
+};
+
+/* Frame pacing prototypes */
+bool parseSwapMode(const std::string& name, SwapMode& mode);
+const char* swapModeName(SwapMode mode);
+SwapMode applySwapMode(SwapMode mode);
+void initFrameLimiter(FrameLimiter& limiter, double framesPerSecond);
+void waitFrameLimiter(FrameLimiter& limiter);
+void shutdownFrameLimiter(FrameLimiter& limiter);
+void sleepUntil(double time);
+void addLatencySample(double latencySeconds);
+bool updateLatency(double currentTime, LatencySample& sample);
@@ -0,0 +1,79 @@
+/* Description:
+Immutable description of one frame, built by the main
+(event/simulation) thread and consumed by the render thread.
+Everything the renderer needs is copied in, so the main
+thread is free to keep changing its state while the frame
+is drawn.
+
+Instance lists are shared, not copied: a snapshot holds a
+pointer to a transform list that is never modified after
+it is published. Changing the instances means publishing a
+new list.
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "TransformKernel.h"
+#include "FramePacing.h"
+
+/* Constants */
+const int LIGHT_COUNT = 3;
+const int QUAD_VIEWS = 4;		// Front, side, top and perspective
+
+/* Wireframe display, cycled in this order */
+enum WireframeMode {
+	WIREFRAME_OFF = 0,
+	WIREFRAME_OVERLAY = 1,		// Edges drawn over the shaded surfaces
+	WIREFRAME_HIDDEN_LINE = 2,	// Edges only, surfaces still hide the edges behind them
+	WIREFRAME_ALL_EDGES = 3,	// Every edge, front and back
+	WIREFRAME_MODE_COUNT
+};
+
+/* Camera state for one frame */
+struct CameraSnapshot {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 position;
+	float zNear = 0.1f;
+	float zFar = 100.0f;
+};
+
+/* Point light */
+struct LightSnapshot {
+	glm::vec3 position;
+	glm::vec3 color;
+};
+
+/* Everything the renderer reads for one frame */
+struct FrameSnapshot {
+	unsigned long long frame = 0;	// Sequence number, increases by one per published snapshot
+	float time = 0.0f;				// Simulation time in seconds
+	int width = 0;					// Framebuffer size in pixels
+	int height = 0;
+	CameraSnapshot camera;
+	LightSnapshot lights[LIGHT_COUNT];
+	WireframeMode wireFrame = WIREFRAME_OFF;
+	bool lightDraw = false;
+	bool printStats = false;
+	bool progressive = false;		// Accumulate jittered samples while the view is unchanged
+	bool capture = false;			// Save the rendered frame to an image
+	double buildMs = 0.0;			// Main thread time spent building this snapshot
+	double inputTime = -1.0;		// Time of the first input that changed this frame, -1 if none
+	unsigned int inputDropped = 0;	// Input events lost to a full queue since the program started
+	bool lateLatch = false;			// Renderer may replace the camera with a newer one just before drawing
+	SwapMode swapMode = SWAP_ON;
+	float frameTargetMs = 0.0f;		// Dynamic resolution: GPU time per frame to stay under, 0 for full resolution
+	bool sharpenUpscale = false;	// Sharpen the upscaled image instead of plain bilinear
+	bool meshletCulling = false;	// Cull harmonica meshlets on the GPU and draw them indirectly
+	bool depthPrepass = false;		// Lay down opaque depth first, then shade with GL_EQUAL
+	bool overdraw = false;			// Show how many times each pixel is shaded instead of the scene
+	bool quadView = false;			// Split the window into the four views below
+	CameraSnapshot views[QUAD_VIEWS];	// Quad view cameras, bottom left, bottom right, top left, top right
+	std::shared_ptr<const TransformSoA> instances;	// Harmonica instances, each drawn as two halves
+	std::shared_ptr<const std::vector<uint16_t>> materials;	// Material of every instance, nullptr for the built-in textures
+	std::shared_ptr<const std::vector<glm::vec3>> lamps;	// Every light position drawn as a lamp, when there are more than lights
+};
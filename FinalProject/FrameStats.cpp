@@ -0,0 +1,64 @@
+#include "FrameStats.h"
+
+#include <iostream>
+
+using namespace std;
+
+/* Constants */
+const GLfloat PRINT_INTERVAL = 1.0f;	// Seconds between console reports
+
+FrameStats frameStats;
+bool printStats = false;
+
+static FrameStats previous;				// Completed frame
+static GLfloat lastPrint = 0.0f;		// Time of last console report
+static unsigned long long frameStartAllocations = 0;	// Allocation count when the frame began
+
+// Store the finished frame's counters and start a new frame
+void beginFrameStats()
+{
+	unsigned long long allocations = heapAllocationCount();
+	frameStats.heapAllocations = (unsigned int)(allocations - frameStartAllocations);
+	frameStartAllocations = allocations;
+
+	previous = frameStats;
+	frameStats = FrameStats();
+}
+
+// Counters of the last completed frame
+const FrameStats& lastFrameStats()
+{
+	return previous;
+}
+
+// Print the last completed frame's counters (if enabled)
+void printFrameStats(GLfloat currentTime)
+{
+	if (!printStats || currentTime - lastPrint < PRINT_INTERVAL)
+		return;
+	lastPrint = currentTime;
+
+	cout << "Draw calls: " << previous.drawCalls
+		<< " | Triangles: " << previous.trianglesDrawn
+		<< " | GL state calls: " << previous.stateCallsIssued << " issued, "
+		<< previous.stateCallsElided << " elided"
+		<< " | Heap allocations: " << previous.heapAllocations
+		<< " | Fence waits: " << previous.fenceWaits;
+	if (previous.impostorsDrawn)
+		cout << " | Impostors: " << previous.impostorsDrawn;
+	if (previous.ringOverflows)
+		cout << " | Ring overflows: " << previous.ringOverflows;
+	if (previous.snapshotsDropped)
+		cout << " | Snapshots dropped: " << previous.snapshotsDropped;
+	if (previous.inputDropped)
+		cout << " | Input events dropped: " << previous.inputDropped;
+	if (previous.inputLatencyMs > 0.0f)
+		cout << " | Input latency: " << previous.inputLatencyMs << "ms";
+	if (previous.resolutionScale > 0.0f)
+		cout << " | Resolution scale: " << previous.resolutionScale;
+	if (previous.shadedFragments)
+		cout << " | Fragments: " << previous.prepassFragments << " pre-pass, " << previous.shadedFragments << " shaded";
+	if (previous.accumulatedSamples)
+		cout << " | Accumulated samples: " << previous.accumulatedSamples;
+	cout << endl;
+}
@@ -0,0 +1,37 @@
+/* Description:
+Per-frame counters collected by the renderer, on the render
+thread only. The counters in frameStats are filled while a
+frame is built and moved to the previous-frame slot by
+beginFrameStats().
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+
+/* Counters for a single frame */
+struct FrameStats {
+	unsigned int drawCalls = 0;			// glDraw* calls issued
+	unsigned int trianglesDrawn = 0;	// Triangles submitted by the draw list, after level of detail selection
+	unsigned int impostorsDrawn = 0;	// Instances drawn as impostor quads
+	unsigned int stateCallsIssued = 0;	// GL state calls passed to the driver
+	unsigned int stateCallsElided = 0;	// GL state calls skipped because nothing changed
+	unsigned int heapAllocations = 0;	// operator new calls on the render thread during the frame
+	unsigned int fenceWaits = 0;		// Times the CPU had to wait for the GPU to release a ring segment
+	unsigned int ringOverflows = 0;		// GPU ring allocations that did not fit
+	unsigned int snapshotsDropped = 0;	// Published snapshots replaced before the render thread drew them
+	unsigned int inputDropped = 0;		// Input events lost to a full queue since the previous frame drawn
+	unsigned int accumulatedSamples = 0;	// Progressive mode: frames averaged into the image shown
+	float inputLatencyMs = 0.0f;		// Input-to-present latency of the input this frame showed first
+	float resolutionScale = 0.0f;		// Dynamic resolution: render size / window size, 0 when off
+	unsigned long long prepassFragments = 0;	// Fragment shader invocations of the depth pre-pass (a few frames old)
+	unsigned long long shadedFragments = 0;		// Fragment shader invocations of the shading pass (a few frames old)
+};
+
+extern FrameStats frameStats;		// Frame currently being built
+extern bool printStats;				// Print last frame's stats to the console once per second
+
+/* Frame statistics prototypes */
+unsigned long long heapAllocationCount();	// Calling thread's count, defined in AllocationCounter.cpp
+void beginFrameStats();
+const FrameStats& lastFrameStats();
+void printFrameStats(GLfloat currentTime);
@@ -0,0 +1,167 @@
+#include "FrameTimings.h"
+
+#include <cstdio>
+#include <iostream>
+#include <atomic>
+
+#include "FrameArena.h"
+
+using namespace std;
+
+/* Constants */
+const int TIMER_SLOTS = FRAMES_IN_FLIGHT + 1;	// Queries in flight before a result is needed
+
+/* Frame whose GPU time has not been read yet */
+struct PendingTiming {
+	GLuint query = 0;
+	bool active = false;
+	unsigned long long frame = 0;
+	double buildMs = 0.0;
+	double submitMs = 0.0;
+	double swapMs = 0.0;
+	double latencyMs = -1.0;
+	float scale = 1.0f;
+};
+
+/* Module state */
+static FILE* timingFile = nullptr;
+static PendingTiming pending[TIMER_SLOTS];
+static int currentSlot = 0;
+static bool queriesCreated = false;
+static bool timerQueries = false;		// GL 3.3 / ARB_timer_query available
+static atomic<unsigned long long> gpuBusy{ 0 };	// Total GPU time of every measured frame
+static unsigned long long latestFrame = 0;	// Newest frame whose GPU time has been read
+static double latestGpuMs = -1.0;
+
+// Write a frame's row, blocking on its query result if wait is set
+static bool WriteRow(PendingTiming& slot, bool wait)
+{
+	if (!slot.active)
+		return true;
+
+	double gpuMs = -1.0;
+	if (timerQueries) {
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available && !wait)
+			return false;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed);
+		gpuBusy.fetch_add(elapsed, memory_order_relaxed);
+		gpuMs = elapsed / 1.0e6;
+		latestFrame = slot.frame;
+		latestGpuMs = gpuMs;
+	}
+
+	if (timingFile)
+		fprintf(timingFile, "%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f\n", slot.frame, slot.buildMs, slot.submitMs, slot.swapMs, gpuMs, slot.latencyMs, slot.scale);
+	slot.active = false;
+	return true;
+}
+
+// Create the CSV file, called before the render thread starts
+bool openFrameTimings(const string& path)
+{
+	timingFile = fopen(path.c_str(), "w");
+	if (!timingFile) {
+		cout << "Could not create timing file " << path << endl;
+		return false;
+	}
+
+	fprintf(timingFile, "frame,build_ms,submit_ms,swap_ms,gpu_ms,latency_ms,scale\n");
+	return true;
+}
+
+// Timings are being written
+bool frameTimingsEnabled()
+{
+	return timingFile != nullptr;
+}
+
+// Start measuring GPU time of the frame about to be submitted
+void beginFrameTiming()
+{
+	if (!queriesCreated) {
+		timerQueries = GLEW_ARB_timer_query != 0;
+		for (PendingTiming& slot : pending)
+			glGenQueries(1, &slot.query);
+		queriesCreated = true;
+	}
+
+	// Slot is reused, its result must be written first
+	WriteRow(pending[currentSlot], true);
+
+	if (timerQueries)
+		glBeginQuery(GL_TIME_ELAPSED, pending[currentSlot].query);
+}
+
+// Stop measuring GPU time, before the swap so waiting for vertical blank is not counted
+void stopGpuTiming()
+{
+	if (timerQueries)
+		glEndQuery(GL_TIME_ELAPSED);
+}
+
+// Queue the frame's row
+void endFrameTiming(unsigned long long frame, double buildMs, double submitMs, double swapMs, double latencyMs, float scale)
+{
+	PendingTiming& slot = pending[currentSlot];
+	slot.active = true;
+	slot.frame = frame;
+	slot.buildMs = buildMs;
+	slot.submitMs = submitMs;
+	slot.swapMs = swapMs;
+	slot.latencyMs = latencyMs;
+	slot.scale = scale;
+	currentSlot = (currentSlot + 1) % TIMER_SLOTS;
+
+	pollFrameTimings();
+}
+
+// Write older frames whose results are already available, in order
+void pollFrameTimings()
+{
+	if (!queriesCreated)
+		return;
+
+	for (int i = 0; i < TIMER_SLOTS; ++i) {
+		if (!WriteRow(pending[(currentSlot + i) % TIMER_SLOTS], false))
+			break;
+	}
+}
+
+// Write outstanding rows, delete the queries and close the file, the GL context must still be current
+void closeFrameTimings()
+{
+	if (queriesCreated) {
+		for (int i = 0; i < TIMER_SLOTS; ++i)
+			WriteRow(pending[(currentSlot + i) % TIMER_SLOTS], true);
+
+		for (PendingTiming& slot : pending)
+			glDeleteQueries(1, &slot.query);
+		queriesCreated = false;
+	}
+
+	if (timingFile) {
+		fclose(timingFile);
+		timingFile = nullptr;
+	}
+}
+
+// GPU time of every frame measured so far
+unsigned long long gpuBusyNanoseconds()
+{
+	return gpuBusy.load(memory_order_relaxed);
+}
+
+// GPU time of the newest frame whose result has been read, false if none yet
+bool latestGpuTiming(unsigned long long& frame, double& gpuMs)
+{
+	if (latestGpuMs < 0.0)
+		return false;
+
+	frame = latestFrame;
+	gpuMs = latestGpuMs;
+	return true;
+}
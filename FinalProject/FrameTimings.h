@@ -0,0 +1,33 @@
+/* Description:
+Per-frame timings. The GPU time of every frame is measured
+with a timer query and added to a running total (used for
+GPU load); when a CSV file is open each frame also gets a
+row with the main thread's time to build the snapshot, the
+render thread's CPU time to submit it and to swap, the
+GPU time (up to the swap), the input-to-present latency
+(-1 when no input reached the screen that frame) and the
+dynamic resolution scale.
+
+GPU results are read a few frames late so the CPU never
+waits on a query; rows are written as results arrive and
+the remainder is flushed when timings are closed. Functions
+run on the render thread except openFrameTimings() (called
+before it starts) and gpuBusyNanoseconds() (any thread).
+latestGpuTiming() gives the newest result read so far, for
+controllers that adapt to GPU load.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <string>
+
+/* Frame timing prototypes */
+bool openFrameTimings(const std::string& path);
+bool frameTimingsEnabled();
+void beginFrameTiming();
+void stopGpuTiming();
+void endFrameTiming(unsigned long long frame, double buildMs, double submitMs, double swapMs, double latencyMs, float scale);
+void pollFrameTimings();
+void closeFrameTimings();
+unsigned long long gpuBusyNanoseconds();
+bool latestGpuTiming(unsigned long long& frame, double& gpuMs);
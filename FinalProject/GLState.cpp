@@ -0,0 +1,165 @@
+#include "GLState.h"
+#include "FrameStats.h"
+
+/* Constants */
+const GLuint UNKNOWN = 0xFFFFFFFF;		// Value not known to the cache, next call always issues
+
+/* Cached state */
+static GLuint program;
+static GLuint vao;
+static GLuint activeUnit;
+static GLuint textures[STATE_TEXTURE_UNITS];
+static GLenum textureTargets[STATE_TEXTURE_UNITS];
+static GLenum polygonMode;
+static GLint viewport[4];
+static GLuint depthTest, blend, cullFace;
+static GLenum depthFunc;
+static GLuint depthMask;
+static GLenum blendSource, blendDestination;
+static GLuint uniformBuffers[STATE_UNIFORM_BINDINGS];
+static GLintptr uniformOffsets[STATE_UNIFORM_BINDINGS];
+
+// Returns true (and counts) if value changes, false (and counts) if call can be skipped
+template <typename T>
+static bool Changed(T& cached, T value)
+{
+	if (cached == value) {
+		frameStats.stateCallsElided++;
+		return false;
+	}
+
+	cached = value;
+	frameStats.stateCallsIssued++;
+	return true;
+}
+
+// Forget everything, the next call of each kind reaches the driver
+void stateReset()
+{
+	program = UNKNOWN;
+	vao = UNKNOWN;
+	activeUnit = UNKNOWN;
+	for (GLuint i = 0; i < STATE_TEXTURE_UNITS; ++i) {
+		textures[i] = UNKNOWN;
+		textureTargets[i] = UNKNOWN;
+	}
+	polygonMode = UNKNOWN;
+	viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+	depthTest = blend = cullFace = UNKNOWN;
+	depthFunc = UNKNOWN;
+	depthMask = UNKNOWN;
+	blendSource = blendDestination = UNKNOWN;
+	for (GLuint i = 0; i < STATE_UNIFORM_BINDINGS; ++i) {
+		uniformBuffers[i] = UNKNOWN;
+		uniformOffsets[i] = -1;
+	}
+}
+
+void stateUseProgram(GLuint newProgram)
+{
+	if (Changed(program, newProgram))
+		glUseProgram(newProgram);
+}
+
+void stateBindVertexArray(GLuint newVao)
+{
+	if (Changed(vao, newVao))
+		glBindVertexArray(newVao);
+}
+
+void stateBindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	if (textures[unit] == texture && textureTargets[unit] == target) {
+		frameStats.stateCallsElided++;
+		return;
+	}
+
+	// Only switch the active unit when a bind is actually needed
+	if (Changed(activeUnit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+
+	textures[unit] = texture;
+	textureTargets[unit] = target;
+	frameStats.stateCallsIssued++;
+	glBindTexture(target, texture);
+}
+
+void statePolygonMode(GLenum mode)
+{
+	if (Changed(polygonMode, mode))
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void stateViewport(GLint x, GLint y, GLsizei w, GLsizei h)
+{
+	if (viewport[0] == x && viewport[1] == y && viewport[2] == w && viewport[3] == h) {
+		frameStats.stateCallsElided++;
+		return;
+	}
+
+	viewport[0] = x;
+	viewport[1] = y;
+	viewport[2] = w;
+	viewport[3] = h;
+	frameStats.stateCallsIssued++;
+	glViewport(x, y, w, h);
+}
+
+void stateEnable(GLenum capability, bool enabled)
+{
+	GLuint* cached;
+	switch (capability) {
+	case GL_DEPTH_TEST:	cached = &depthTest; break;
+	case GL_BLEND:		cached = &blend; break;
+	case GL_CULL_FACE:	cached = &cullFace; break;
+	default:
+		// Untracked capability, always issue
+		frameStats.stateCallsIssued++;
+		enabled ? glEnable(capability) : glDisable(capability);
+		return;
+	}
+
+	if (Changed(*cached, (GLuint)enabled))
+		enabled ? glEnable(capability) : glDisable(capability);
+}
+
+void stateDepthFunc(GLenum func)
+{
+	if (Changed(depthFunc, func))
+		glDepthFunc(func);
+}
+
+void stateDepthMask(GLboolean mask)
+{
+	if (Changed(depthMask, (GLuint)mask))
+		glDepthMask(mask);
+}
+
+void stateBlendFunc(GLenum source, GLenum destination)
+{
+	if (blendSource == source && blendDestination == destination) {
+		frameStats.stateCallsElided++;
+		return;
+	}
+
+	blendSource = source;
+	blendDestination = destination;
+	frameStats.stateCallsIssued++;
+	glBlendFunc(source, destination);
+}
+
+void stateBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	// Only uniform buffer bindings are tracked
+	if (target == GL_UNIFORM_BUFFER && index < STATE_UNIFORM_BINDINGS) {
+		if (uniformBuffers[index] == buffer && uniformOffsets[index] == offset) {
+			frameStats.stateCallsElided++;
+			return;
+		}
+		uniformBuffers[index] = buffer;
+		uniformOffsets[index] = offset;
+	}
+
+	frameStats.stateCallsIssued++;
+	glBindBufferRange(target, index, buffer, offset, size);
+}
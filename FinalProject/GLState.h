@@ -0,0 +1,30 @@
+/* Description:
+Thin cache over frequently used OpenGL state. Each call
+compares against the last value sent to the driver and is
+skipped when nothing would change. Issued and elided calls
+are counted in frameStats.
+
+All state changes that go through the renderer must use
+these functions, otherwise the cache falls out of sync.
+Call stateReset() after touching GL state directly.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+
+/* Constants */
+const GLuint STATE_TEXTURE_UNITS = 16;	// Texture units tracked by the cache
+const GLuint STATE_UNIFORM_BINDINGS = 8;	// Uniform buffer binding points tracked by the cache
+
+/* State cache prototypes */
+void stateReset();
+void stateUseProgram(GLuint program);
+void stateBindVertexArray(GLuint vao);
+void stateBindTexture(GLuint unit, GLenum target, GLuint texture);
+void statePolygonMode(GLenum mode);
+void stateViewport(GLint x, GLint y, GLsizei w, GLsizei h);
+void stateEnable(GLenum capability, bool enabled);
+void stateDepthFunc(GLenum func);
+void stateDepthMask(GLboolean mask);
+void stateBlendFunc(GLenum source, GLenum destination);
+void stateBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
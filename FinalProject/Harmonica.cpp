@@ -0,0 +1,71 @@
+#include "Harmonica.h"
+#include "HarmonicaGenerator.h"
+
+/* Default model, generated by the compiler (see HarmonicaGenerator.h) */
+static constexpr HarmonicaSize REED_SIZE = harmonicaMeshSize(DEFAULT_HARMONICA, MESH_REED);
+static constexpr HarmonicaSize COVER_SIZE = harmonicaMeshSize(DEFAULT_HARMONICA, MESH_COVER);
+static constexpr HarmonicaSize COMB_SIZE = harmonicaMeshSize(DEFAULT_HARMONICA, MESH_COMB);
+
+static constexpr HarmonicaBuffer<REED_SIZE.vertices, REED_SIZE.indices> reed =
+	bakeHarmonicaMesh<REED_SIZE.vertices, REED_SIZE.indices>(DEFAULT_HARMONICA, MESH_REED);
+static constexpr HarmonicaBuffer<COVER_SIZE.vertices, COVER_SIZE.indices> cover =
+	bakeHarmonicaMesh<COVER_SIZE.vertices, COVER_SIZE.indices>(DEFAULT_HARMONICA, MESH_COVER);
+static constexpr HarmonicaBuffer<COMB_SIZE.vertices, COMB_SIZE.indices> comb =
+	bakeHarmonicaMesh<COMB_SIZE.vertices, COMB_SIZE.indices>(DEFAULT_HARMONICA, MESH_COMB);
+
+static const GLfloat lampV[] = {
+	// Vertex
+	//X     Y		Z
+	-0.5,	-0.5,	0.0,		// index 0
+	-0.5,	0.5,	0.0,		// index 1
+	0.5,	-0.5,	0.0,		// index 2		
+	0.5,	0.5,	0.0,		// index 3	
+};
+
+static const GLuint lampI[] = {
+	0, 1, 2,
+	1, 2, 3
+};
+
+// Build a MeshData from static arrays
+template <size_t V, size_t I>
+static MeshData MakeMeshData(const GLfloat (&vertices)[V], const GLuint (&indices)[I], int stride)
+{
+	MeshData data;
+	data.vertices.assign(vertices, vertices + V);
+	data.indices.assign(indices, indices + I);
+	data.stride = stride;
+	return data;
+}
+
+// Vertex and index arrays of one mesh
+MeshData harmonicaMeshData(HarmonicaMesh mesh)
+{
+	switch (mesh) {
+	case MESH_REED:
+		return MakeMeshData(reed.vertices, reed.indices, FULL_VERTEX_STRIDE);
+	case MESH_COVER:
+		return MakeMeshData(cover.vertices, cover.indices, FULL_VERTEX_STRIDE);
+	case MESH_COMB:
+		return MakeMeshData(comb.vertices, comb.indices, FULL_VERTEX_STRIDE);
+	case MESH_LAMP:
+		return MakeMeshData(lampV, lampI, POSITION_VERTEX_STRIDE);
+	default:
+		return MeshData();
+	}
+}
+
+// Texture file of a mesh, nullptr if untextured
+const char* harmonicaTexture(HarmonicaMesh mesh)
+{
+	switch (mesh) {
+	case MESH_REED:
+		return "brass1024.jpg";
+	case MESH_COVER:
+		return "silver.jpg";
+	case MESH_COMB:
+		return "burl2.jpg";
+	default:
+		return nullptr;
+	}
+}
@@ -0,0 +1,23 @@
+/* Description:
+Geometry of the low-poly harmonica: one half of each part
+(the second half is the same mesh rotated 180 degrees on Z)
+and the unit plane used to build the lamp cubes. The parts
+are the default shape of HarmonicaGenerator.h, generated at
+compile time.
+*/
+#pragma once
+
+#include "Mesh.h"
+
+/* Meshes of the model, also used as draw list sort ids */
+enum HarmonicaMesh {
+	MESH_REED = 0,
+	MESH_COVER = 1,
+	MESH_COMB = 2,
+	MESH_LAMP = 3,
+	MESH_COUNT
+};
+
+/* Harmonica prototypes */
+MeshData harmonicaMeshData(HarmonicaMesh mesh);
+const char* harmonicaTexture(HarmonicaMesh mesh);
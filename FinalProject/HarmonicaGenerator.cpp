@@ -0,0 +1,138 @@
+#include "HarmonicaGenerator.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/* Parameters settable by name */
+struct FloatParam {
+	const char* name;
+	GLfloat HarmonicaParams::* value;
+};
+
+static const FloatParam FLOAT_PARAMS[] = {
+	{ "holeWidth", &HarmonicaParams::holeWidth },
+	{ "dividerWidth", &HarmonicaParams::dividerWidth },
+	{ "length", &HarmonicaParams::length },
+	{ "depth", &HarmonicaParams::depth },
+	{ "combHeight", &HarmonicaParams::combHeight },
+	{ "combChamfer", &HarmonicaParams::combChamfer },
+	{ "reedThickness", &HarmonicaParams::reedThickness },
+	{ "coverLength", &HarmonicaParams::coverLength },
+	{ "coverHeight", &HarmonicaParams::coverHeight },
+	{ "coverBack", &HarmonicaParams::coverBack },
+	{ "coverInset", &HarmonicaParams::coverInset },
+	{ "coverChamfer", &HarmonicaParams::coverChamfer },
+	{ "coverRoundness", &HarmonicaParams::coverRoundness },
+	{ "finRise", &HarmonicaParams::finRise },
+	{ "finDrop", &HarmonicaParams::finDrop },
+	{ "finInset", &HarmonicaParams::finInset },
+};
+
+// Vertex and index arrays of one part of any shape
+MeshData generateHarmonicaMesh(const HarmonicaParams& params, HarmonicaMesh mesh)
+{
+	HarmonicaSize size = harmonicaMeshSize(params, mesh);
+	MeshData data;
+	data.vertices.resize((size_t)size.vertices * FULL_VERTEX_STRIDE);
+	data.indices.resize(size.indices);
+	data.stride = FULL_VERTEX_STRIDE;
+
+	HarmonicaWriter writer = {};
+	writer.vertices = data.vertices.data();
+	writer.indices = data.indices.data();
+	writeHarmonicaMesh(params, mesh, writer);
+	return data;
+}
+
+// Comma separated name=value pairs over the given parameters, e.g. holes=12,length=12
+bool parseHarmonicaParams(const string& text, HarmonicaParams& params)
+{
+	istringstream fields(text);
+	string field;
+	while (getline(fields, field, ',')) {
+		size_t equals = field.find('=');
+		if (equals == string::npos) {
+			cout << "Expected name=value in harmonica parameters, got " << field << endl;
+			return false;
+		}
+		string name = field.substr(0, equals);
+		const char* value = field.c_str() + equals + 1;
+
+		char* end = nullptr;
+		double number = strtod(value, &end);
+		if (*value == '\0' || *end != '\0') {
+			cout << "Harmonica parameter " << name << " is not a number: " << value << endl;
+			return false;
+		}
+
+		bool found = true;
+		if (name == "holes")
+			params.holes = atoi(value);
+		else if (name == "coverStrips")
+			params.coverStrips = atoi(value);
+		else {
+			found = false;
+			for (const FloatParam& param : FLOAT_PARAMS) {
+				if (name == param.name) {
+					params.*param.value = (GLfloat)number;
+					found = true;
+					break;
+				}
+			}
+		}
+		if (!found) {
+			cout << "Unknown harmonica parameter " << name << endl;
+			return false;
+		}
+	}
+
+	if (params.holes < 1 || params.coverStrips < 1 || params.length <= 0.0f || params.depth <= 0.0f) {
+		cout << "Harmonica needs at least one hole and cover strip and a positive length and depth" << endl;
+		return false;
+	}
+	return true;
+}
+
+// Time generating random variants of every part, as a configurator would
+void runHarmonicaBenchmark(int variants)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	mt19937 random(330);
+	uniform_int_distribution<int> holes(4, 24), strips(1, 12);
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// Shapes first, so only the generator is timed
+	vector<HarmonicaParams> shapes(variants);
+	for (HarmonicaParams& shape : shapes) {
+		shape.holes = holes(random);
+		shape.coverStrips = strips(random);
+		shape.length = shape.holes * (shape.holeWidth + shape.dividerWidth) + 1.0f + 3.0f * unit(random);
+		shape.coverLength = shape.length - 1.8f;
+		shape.depth = 2.0f + unit(random);
+		shape.combChamfer = unit(random) < 0.5f ? 0.0f : 0.1f * unit(random);
+		shape.coverChamfer = 0.6f * unit(random);
+		shape.coverRoundness = unit(random);
+	}
+
+	size_t vertices = 0, indices = 0;
+	auto start = Clock::now();
+	for (const HarmonicaParams& shape : shapes) {
+		for (HarmonicaMesh part : { MESH_REED, MESH_COVER, MESH_COMB }) {
+			MeshData data = generateHarmonicaMesh(shape, part);
+			vertices += data.vertices.size() / FULL_VERTEX_STRIDE;
+			indices += data.indices.size();
+		}
+	}
+	double total = chrono::duration<double, milli>(Clock::now() - start).count();
+
+	cout << variants << " harmonica variants in " << total << "ms (" << total * 1000.0 / max(1, variants) << "us each), "
+		<< vertices << " vertices, " << indices / 3 << " triangles" << endl;
+}
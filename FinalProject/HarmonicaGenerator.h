@@ -0,0 +1,324 @@
+/* Description:
+Parametric harmonica: the reed, cover plate and comb built
+from a hole count, dimensions, a cover profile and chamfers
+instead of typed-out vertex arrays.
+
+The builder is constexpr, so the default model is generated
+by the compiler and stored in the binary like literal data
+(see Harmonica.cpp); the same code runs at runtime for
+variants (generateHarmonicaMesh), e.g. configurator previews.
+
+Layout of the default model (one half, the second half is
+rotated 180 degrees on Z), all in cm:
+	comb	Back wall, two end blocks and holes - 1 dividers,
+			y 0 to combHeight, z 0 (back) to depth (front)
+	reed	Plate over the comb, reedThickness thick
+	cover	coverStrips strips rising from the reed to
+			coverHeight above it, their front edges set back
+			along the profile by up to coverChamfer; a fin at
+			the back rises finRise above the cover
+Vertices use the full layout (FULL_VERTEX_STRIDE) with face
+normals; texture coordinates are projected from the part's
+bounds on the face's axis.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <string>
+
+#include "Harmonica.h"
+
+/* Shape of a harmonica */
+struct HarmonicaParams {
+	int holes = 10;
+	GLfloat holeWidth = 0.4f;
+	GLfloat dividerWidth = 0.3f;
+	GLfloat length = 10.0f;			// Comb and reed, the end blocks fill what the holes leave
+	GLfloat depth = 2.5f;
+	GLfloat combHeight = 0.3f;
+	GLfloat combChamfer = 0.0f;		// Bevel on the front top edge of the blocks and dividers
+	GLfloat reedThickness = 0.1f;
+	GLfloat coverLength = 8.2f;
+	GLfloat coverHeight = 0.5f;
+	GLfloat coverBack = 0.3f;		// Distance of the cover from the back of the comb
+	GLfloat coverInset = 0.05f;		// Distance of the cover's bottom front edge from the front of the comb
+	int coverStrips = 4;
+	GLfloat coverChamfer = 0.45f;	// How far the top of the cover's front is set back
+	GLfloat coverRoundness = 0.6f;	// Profile of the set back: 0 a straight chamfer, 1 a parabola
+	GLfloat finRise = 0.1f;			// Back fin height above the cover
+	GLfloat finDrop = 0.4f;			// Back fin height down from its top
+	GLfloat finInset = 0.2f;		// Back fin length is coverLength less twice this
+};
+
+/* Vertex and index counts of a generated part */
+struct HarmonicaSize {
+	GLuint vertices;
+	GLuint indices;
+};
+
+/* Destination of the builder, counts only when the arrays are null */
+struct HarmonicaWriter {
+	GLfloat* vertices;
+	GLuint* indices;
+	GLuint vertexCount;
+	GLuint indexCount;
+	GLfloat low[3];		// Bounds of the part, for texture coordinates and color gradients
+	GLfloat size[3];
+};
+
+/* Point or direction */
+struct HarmonicaPoint {
+	GLfloat x, y, z;
+};
+
+/* Fixed size arrays of a part generated at compile time */
+template <GLuint Vertices, GLuint Indices>
+struct HarmonicaBuffer {
+	GLfloat vertices[Vertices * FULL_VERTEX_STRIDE] = {};
+	GLuint indices[Indices] = {};
+};
+
+/* Colors */
+constexpr HarmonicaPoint REED_LOW = { 0.80f, 0.65f, 0.20f };	// Bronze
+constexpr HarmonicaPoint REED_HIGH = { 1.00f, 0.85f, 0.40f };
+constexpr HarmonicaPoint COVER_LOW = { 0.65f, 0.65f, 0.85f };	// Silver
+constexpr HarmonicaPoint COVER_HIGH = { 0.85f, 0.85f, 1.00f };
+constexpr HarmonicaPoint COMB_COLOR = { 0.82f, 0.42f, 0.12f };	// Chocolate brown
+constexpr HarmonicaPoint COMB_BACK = { 0.20f, 0.20f, 0.20f };
+
+/* Default model, baked at compile time */
+constexpr HarmonicaParams DEFAULT_HARMONICA = {};
+
+/* Builder (constexpr, usable at compile time and at runtime) */
+constexpr GLfloat HarmonicaMin(GLfloat a, GLfloat b) { return a < b ? a : b; }
+constexpr GLfloat HarmonicaMax(GLfloat a, GLfloat b) { return a > b ? a : b; }
+
+// Square root by Newton's method, std::sqrt is not constexpr
+constexpr GLfloat HarmonicaSqrt(GLfloat x)
+{
+	if (x <= 0.0f)
+		return 0.0f;
+	GLfloat root = x > 1.0f ? x : 1.0f;
+	for (int i = 0; i < 32; ++i)
+		root = 0.5f * (root + x / root);
+	return root;
+}
+
+// Unit normal of the plane through a, b, c (counterclockwise seen from outside)
+constexpr HarmonicaPoint HarmonicaNormal(HarmonicaPoint a, HarmonicaPoint b, HarmonicaPoint c)
+{
+	HarmonicaPoint u = { b.x - a.x, b.y - a.y, b.z - a.z };
+	HarmonicaPoint v = { c.x - a.x, c.y - a.y, c.z - a.z };
+	HarmonicaPoint n = { u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x };
+	GLfloat length = HarmonicaSqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+	if (length > 0.0f) {
+		n.x /= length;
+		n.y /= length;
+		n.z /= length;
+	}
+	return n;
+}
+
+// Start a part: reset the counts and set its bounds
+constexpr void HarmonicaBegin(HarmonicaWriter& writer, HarmonicaPoint low, HarmonicaPoint high)
+{
+	writer.vertexCount = 0;
+	writer.indexCount = 0;
+	writer.low[0] = low.x;
+	writer.low[1] = low.y;
+	writer.low[2] = low.z;
+	writer.size[0] = HarmonicaMax(high.x - low.x, 1.0e-6f);
+	writer.size[1] = HarmonicaMax(high.y - low.y, 1.0e-6f);
+	writer.size[2] = HarmonicaMax(high.z - low.z, 1.0e-6f);
+}
+
+// Flat convex face, corners counterclockwise seen from outside, fanned from the first
+// Colors blend from low to high with height in the part; texture coordinates are the
+// position across the part's bounds on the two axes the face is most parallel to
+constexpr void HarmonicaFace(HarmonicaWriter& writer, const HarmonicaPoint* corners, int count, HarmonicaPoint low, HarmonicaPoint high)
+{
+	HarmonicaPoint n = HarmonicaNormal(corners[0], corners[1], corners[count - 1]);
+	GLfloat ax = n.x < 0.0f ? -n.x : n.x, ay = n.y < 0.0f ? -n.y : n.y, az = n.z < 0.0f ? -n.z : n.z;
+	int s = ax >= ay && ax >= az ? 2 : 0;	// Facing X: s along Z, t along Y
+	int t = ay > ax && ay >= az ? 2 : 1;	// Facing Y: s along X, t along Z
+
+	GLuint first = writer.vertexCount;
+	for (int i = 0; i < count; ++i) {
+		if (writer.vertices) {
+			GLfloat position[3] = { corners[i].x, corners[i].y, corners[i].z };
+			GLfloat blend = (position[1] - writer.low[1]) / writer.size[1];
+			GLfloat* v = writer.vertices + (size_t)writer.vertexCount * FULL_VERTEX_STRIDE;
+			v[0] = position[0];
+			v[1] = position[1];
+			v[2] = position[2];
+			v[3] = low.x + (high.x - low.x) * blend;
+			v[4] = low.y + (high.y - low.y) * blend;
+			v[5] = low.z + (high.z - low.z) * blend;
+			v[6] = (position[s] - writer.low[s]) / writer.size[s];
+			v[7] = (position[t] - writer.low[t]) / writer.size[t];
+			v[8] = n.x;
+			v[9] = n.y;
+			v[10] = n.z;
+		}
+		++writer.vertexCount;
+	}
+	for (int i = 1; i + 1 < count; ++i) {
+		if (writer.indices) {
+			writer.indices[writer.indexCount] = first;
+			writer.indices[writer.indexCount + 1] = first + i;
+			writer.indices[writer.indexCount + 2] = first + i + 1;
+		}
+		writer.indexCount += 3;
+	}
+}
+
+// Four corner face
+constexpr void HarmonicaQuad(HarmonicaWriter& writer, HarmonicaPoint a, HarmonicaPoint b, HarmonicaPoint c, HarmonicaPoint d, HarmonicaPoint low, HarmonicaPoint high)
+{
+	HarmonicaPoint corners[4] = { a, b, c, d };
+	HarmonicaFace(writer, corners, 4, low, high);
+}
+
+// Reed plate: a box over the comb
+constexpr void HarmonicaReed(const HarmonicaParams& p, HarmonicaWriter& writer)
+{
+	GLfloat x0 = -0.5f * p.length, x1 = 0.5f * p.length;
+	GLfloat y0 = p.combHeight, y1 = p.combHeight + p.reedThickness;
+	GLfloat z0 = 0.0f, z1 = p.depth;
+	HarmonicaBegin(writer, { x0, y0, z0 }, { x1, y1, z1 });
+
+	HarmonicaQuad(writer, { x1, y0, z0 }, { x0, y0, z0 }, { x0, y1, z0 }, { x1, y1, z0 }, REED_LOW, REED_HIGH);	// back
+	HarmonicaQuad(writer, { x0, y0, z1 }, { x1, y0, z1 }, { x1, y1, z1 }, { x0, y1, z1 }, REED_LOW, REED_HIGH);	// front
+	HarmonicaQuad(writer, { x0, y0, z0 }, { x0, y0, z1 }, { x0, y1, z1 }, { x0, y1, z0 }, REED_LOW, REED_HIGH);	// left
+	HarmonicaQuad(writer, { x1, y0, z1 }, { x1, y0, z0 }, { x1, y1, z0 }, { x1, y1, z1 }, REED_LOW, REED_HIGH);	// right
+	HarmonicaQuad(writer, { x0, y0, z0 }, { x1, y0, z0 }, { x1, y0, z1 }, { x0, y0, z1 }, REED_LOW, REED_HIGH);	// bottom
+	HarmonicaQuad(writer, { x0, y1, z1 }, { x1, y1, z1 }, { x1, y1, z0 }, { x0, y1, z0 }, REED_LOW, REED_HIGH);	// top
+}
+
+// Cover plate: strips following the front profile, the top and the back fin
+constexpr void HarmonicaCover(const HarmonicaParams& p, HarmonicaWriter& writer)
+{
+	const int MAX_STRIPS = 64;
+	int strips = p.coverStrips < 1 ? 1 : (p.coverStrips > MAX_STRIPS ? MAX_STRIPS : p.coverStrips);
+	GLfloat x = 0.5f * p.coverLength, finX = HarmonicaMax(x - p.finInset, 0.0f);
+	GLfloat base = p.combHeight + p.reedThickness, top = base + p.coverHeight;
+	GLfloat back = p.coverBack, front = p.depth - p.coverInset;
+	GLfloat chamfer = HarmonicaMin(p.coverChamfer, front - back);
+	GLfloat finTop = top + p.finRise, finBottom = HarmonicaMax(finTop - p.finDrop, base);
+	HarmonicaBegin(writer, { -x, base, 0.0f }, { x, finTop, front });
+
+	// Front edge of every strip boundary, set back more steeply towards the top
+	GLfloat y[MAX_STRIPS + 1] = {}, z[MAX_STRIPS + 1] = {};
+	for (int k = 0; k <= strips; ++k) {
+		GLfloat t = (GLfloat)k / (GLfloat)strips;
+		y[k] = base + p.coverHeight * t;
+		z[k] = front - chamfer * ((1.0f - p.coverRoundness) * t + p.coverRoundness * t * t);
+	}
+
+	// Strips
+	for (int k = 0; k < strips; ++k)
+		HarmonicaQuad(writer, { -x, y[k], z[k] }, { x, y[k], z[k] }, { x, y[k + 1], z[k + 1] }, { -x, y[k + 1], z[k + 1] }, COVER_LOW, COVER_HIGH);
+
+	// Sides: the profile closed at the back, convex since the set back only grows
+	HarmonicaPoint left[MAX_STRIPS + 3] = {}, right[MAX_STRIPS + 3] = {};
+	left[0] = { -x, base, back };
+	right[0] = { x, base, back };
+	right[1] = { x, top, back };
+	for (int k = 0; k <= strips; ++k) {
+		left[k + 1] = { -x, y[k], z[k] };
+		right[k + 2] = { x, y[strips - k], z[strips - k] };
+	}
+	left[strips + 2] = { -x, top, back };
+	HarmonicaFace(writer, left, strips + 3, COVER_LOW, COVER_HIGH);
+	HarmonicaFace(writer, right, strips + 3, COVER_LOW, COVER_HIGH);
+
+	// Top, then the fin sloping up to the back and its back face
+	HarmonicaQuad(writer, { -x, top, z[strips] }, { x, top, z[strips] }, { x, top, back }, { -x, top, back }, COVER_LOW, COVER_HIGH);
+	HarmonicaQuad(writer, { -x, top, back }, { x, top, back }, { finX, finTop, 0.0f }, { -finX, finTop, 0.0f }, COVER_LOW, COVER_HIGH);
+	HarmonicaQuad(writer, { finX, finBottom, 0.0f }, { -finX, finBottom, 0.0f }, { -finX, finTop, 0.0f }, { finX, finTop, 0.0f }, COVER_LOW, COVER_HIGH);
+}
+
+// One comb tooth (end block or divider) from x0 to x1: sides and front, the reed covers its top
+constexpr void HarmonicaTooth(const HarmonicaParams& p, HarmonicaWriter& writer, GLfloat x0, GLfloat x1)
+{
+	GLfloat h = p.combHeight, d = p.depth;
+	GLfloat c = HarmonicaMin(p.combChamfer, HarmonicaMin(h, d));
+	if (c <= 0.0f) {
+		HarmonicaQuad(writer, { x0, 0.0f, 0.0f }, { x0, 0.0f, d }, { x0, h, d }, { x0, h, 0.0f }, COMB_COLOR, COMB_COLOR);	// left
+		HarmonicaQuad(writer, { x1, 0.0f, d }, { x1, 0.0f, 0.0f }, { x1, h, 0.0f }, { x1, h, d }, COMB_COLOR, COMB_COLOR);	// right
+		HarmonicaQuad(writer, { x0, 0.0f, d }, { x1, 0.0f, d }, { x1, h, d }, { x0, h, d }, COMB_COLOR, COMB_COLOR);	// front
+		return;
+	}
+
+	HarmonicaPoint left[5] = { { x0, 0.0f, 0.0f }, { x0, 0.0f, d }, { x0, h - c, d }, { x0, h, d - c }, { x0, h, 0.0f } };
+	HarmonicaPoint right[5] = { { x1, h, 0.0f }, { x1, h, d - c }, { x1, h - c, d }, { x1, 0.0f, d }, { x1, 0.0f, 0.0f } };
+	HarmonicaFace(writer, left, 5, COMB_COLOR, COMB_COLOR);
+	HarmonicaFace(writer, right, 5, COMB_COLOR, COMB_COLOR);
+	HarmonicaQuad(writer, { x0, 0.0f, d }, { x1, 0.0f, d }, { x1, h - c, d }, { x0, h - c, d }, COMB_COLOR, COMB_COLOR);		// front
+	HarmonicaQuad(writer, { x0, h - c, d }, { x1, h - c, d }, { x1, h, d - c }, { x0, h, d - c }, COMB_COLOR, COMB_COLOR);		// chamfer
+}
+
+// Comb: back wall, end blocks and the dividers between the holes
+constexpr void HarmonicaComb(const HarmonicaParams& p, HarmonicaWriter& writer)
+{
+	int holes = p.holes < 1 ? 1 : p.holes;
+	GLfloat x = 0.5f * p.length, h = p.combHeight;
+	HarmonicaBegin(writer, { -x, 0.0f, 0.0f }, { x, h, p.depth });
+
+	HarmonicaQuad(writer, { x, 0.0f, 0.0f }, { -x, 0.0f, 0.0f }, { -x, h, 0.0f }, { x, h, 0.0f }, COMB_BACK, COMB_BACK);	// back wall
+
+	// Holes are centered, the end blocks take the rest of the length
+	GLfloat holesWidth = holes * p.holeWidth + (holes - 1) * p.dividerWidth;
+	GLfloat start = -0.5f * HarmonicaMin(holesWidth, p.length);
+	HarmonicaTooth(p, writer, -x, start);
+	for (int i = 1; i < holes; ++i) {
+		GLfloat x0 = start + i * p.holeWidth + (i - 1) * p.dividerWidth;
+		HarmonicaTooth(p, writer, x0, x0 + p.dividerWidth);
+	}
+	HarmonicaTooth(p, writer, -start, x);
+}
+
+// Build one part into writer (the lamp plane is not generated)
+constexpr void writeHarmonicaMesh(const HarmonicaParams& params, HarmonicaMesh mesh, HarmonicaWriter& writer)
+{
+	switch (mesh) {
+	case MESH_REED:
+		HarmonicaReed(params, writer);
+		break;
+	case MESH_COVER:
+		HarmonicaCover(params, writer);
+		break;
+	case MESH_COMB:
+		HarmonicaComb(params, writer);
+		break;
+	default:
+		writer.vertexCount = 0;
+		writer.indexCount = 0;
+		break;
+	}
+}
+
+// Vertex and index counts of one part
+constexpr HarmonicaSize harmonicaMeshSize(const HarmonicaParams& params, HarmonicaMesh mesh)
+{
+	HarmonicaWriter writer = {};
+	writeHarmonicaMesh(params, mesh, writer);
+	return { writer.vertexCount, writer.indexCount };
+}
+
+// One part in fixed size arrays, sized by harmonicaMeshSize()
+template <GLuint Vertices, GLuint Indices>
+constexpr HarmonicaBuffer<Vertices, Indices> bakeHarmonicaMesh(const HarmonicaParams& params, HarmonicaMesh mesh)
+{
+	HarmonicaBuffer<Vertices, Indices> buffer;
+	HarmonicaWriter writer = {};
+	writer.vertices = buffer.vertices;
+	writer.indices = buffer.indices;
+	writeHarmonicaMesh(params, mesh, writer);
+	return buffer;
+}
+
+/* Harmonica generator prototypes */
+MeshData generateHarmonicaMesh(const HarmonicaParams& params, HarmonicaMesh mesh);
+bool parseHarmonicaParams(const std::string& text, HarmonicaParams& params);
+void runHarmonicaBenchmark(int variants);
@@ -0,0 +1,225 @@
+#include "Impostor.h"
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLState.h"
+#include "FrameStats.h"
+
+using namespace std;
+
+/* Constants */
+const int IMPOSTOR_ATLAS_SIZE = IMPOSTOR_GRID * IMPOSTOR_FRAME_SIZE;
+const int IMPOSTOR_MIP_LEVELS = 4;		// Down to 16 pixels per view, further would bleed between views
+
+// Direction of an octahedral coordinate in [-1, 1], Y is the octahedron's axis
+static glm::vec3 OctDecode(GLfloat u, GLfloat v)
+{
+	glm::vec3 n(u, 1.0f - fabs(u) - fabs(v), v);
+	if (n.y < 0.0f) {
+		GLfloat x = (1.0f - fabs(n.z)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		GLfloat z = (1.0f - fabs(n.x)) * (n.z >= 0.0f ? 1.0f : -1.0f);
+		n.x = x;
+		n.z = z;
+	}
+	return glm::normalize(n);
+}
+
+// Up vector of a view, must match FrameBasis() in impostor.vert/frag
+static glm::vec3 ViewUp(const glm::vec3& direction)
+{
+	return fabs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+// Create a texture of the atlas with room for its mipmaps
+static GLuint CreateAtlasTexture(GLint format, GLenum type)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	stateBindTexture(0, GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, IMPOSTOR_ATLAS_SIZE, IMPOSTOR_ATLAS_SIZE, 0, GL_RGBA, type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, IMPOSTOR_MIP_LEVELS);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	return texture;
+}
+
+// Atlas render target, created on the first bake
+static void CreateTargets(Impostor& impostor)
+{
+	impostor.albedo = CreateAtlasTexture(GL_RGBA8, GL_UNSIGNED_BYTE);
+	impostor.normalDepth = CreateAtlasTexture(GL_RGBA16F, GL_FLOAT);
+	stateBindTexture(0, GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &impostor.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, impostor.depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, IMPOSTOR_ATLAS_SIZE, IMPOSTOR_ATLAS_SIZE);
+
+	glGenFramebuffers(1, &impostor.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, impostor.fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, impostor.albedo, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, impostor.normalDepth, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, impostor.depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		cout << "Impostor atlas framebuffer is incomplete" << endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Load the programs and describe the instance attributes, the atlas is baked later
+void initImpostor(Impostor& impostor, const glm::vec3& center, GLfloat radius)
+{
+	impostor.center = center;
+	impostor.radius = radius;
+	impostor.bake = loadShaderProgram("shaders/harmonica.vert", "shaders/impostor_bake.frag");
+	impostor.draw = loadShaderProgram("shaders/impostor.vert", "shaders/impostor.frag");
+
+	glGenBuffers(1, &impostor.uniforms);
+	glGenVertexArrays(1, &impostor.vao);
+	glBindVertexArray(impostor.vao);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(0, 1);
+	glVertexAttribDivisor(1, 1);
+	glBindVertexArray(0);
+}
+
+// Atlas is up to date and can be drawn
+bool impostorReady(const Impostor& impostor)
+{
+	return impostor.draw->program != 0 && impostor.bakedGeneration != 0 && impostor.bakedGeneration == impostor.bake->generation;
+}
+
+// Render every view of the object into the atlas, false while the bake shader is still compiling
+bool bakeImpostor(Impostor& impostor, const ImpostorPart* parts, size_t count)
+{
+	if (impostor.bake->program == 0)
+		return false;
+
+	if (!impostor.fbo)
+		CreateTargets(impostor);
+
+	// Parts' PerDraw blocks, each at an offset the driver accepts
+	GLint alignment = 16;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	size_t stride = (sizeof(PerDrawUniforms) + alignment - 1) / alignment * alignment;
+	vector<unsigned char> blocks(stride * count);
+	for (size_t i = 0; i < count; ++i)
+		*(PerDrawUniforms*)&blocks[i * stride] = parts[i].uniforms;
+	glBindBuffer(GL_UNIFORM_BUFFER, impostor.uniforms);
+	glBufferData(GL_UNIFORM_BUFFER, blocks.size(), blocks.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, impostor.fbo);
+	const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, buffers);
+
+	// Empty texels: no coverage, farthest depth
+	const GLfloat clearAlbedo[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearNormalDepth[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 0, clearAlbedo);
+	glClearBufferfv(GL_COLOR, 1, clearNormalDepth);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	statePolygonMode(GL_FILL);
+	stateEnable(GL_DEPTH_TEST, true);
+	stateEnable(GL_BLEND, false);
+
+	GLuint program = impostor.bake->program;
+	stateUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "myTexture"), 0);
+	GLint viewLoc = glGetUniformLocation(program, "view");
+	GLint projectionLoc = glGetUniformLocation(program, "projection");
+
+	// Orthographic box around the bounding sphere, depth runs front to back across it
+	GLfloat r = impostor.radius;
+	glm::mat4 projection = glm::ortho(-r, r, -r, r, 0.0f, 2.0f * r);
+	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+
+	for (int y = 0; y < IMPOSTOR_GRID; ++y) {
+		for (int x = 0; x < IMPOSTOR_GRID; ++x) {
+			// Grid corners are views too, so the directions span the whole sphere
+			glm::vec3 direction = OctDecode(x * 2.0f / (IMPOSTOR_GRID - 1) - 1.0f, y * 2.0f / (IMPOSTOR_GRID - 1) - 1.0f);
+			glm::mat4 view = glm::lookAt(impostor.center + direction * r, impostor.center, ViewUp(direction));
+			glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+			stateViewport(x * IMPOSTOR_FRAME_SIZE, y * IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE);
+
+			for (size_t i = 0; i < count; ++i) {
+				stateBindVertexArray(parts[i].vao);
+				stateBindTexture(0, GL_TEXTURE_2D, parts[i].texture);
+				stateBindBufferRange(GL_UNIFORM_BUFFER, PER_DRAW_BINDING, impostor.uniforms, i * stride, sizeof(PerDrawUniforms));
+				glDrawElements(GL_TRIANGLES, parts[i].indexCount, GL_UNSIGNED_INT, nullptr);
+			}
+		}
+	}
+
+	glDrawBuffers(1, buffers);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Distant quads sample the smaller levels
+	stateBindTexture(0, GL_TEXTURE_2D, impostor.albedo);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	stateBindTexture(0, GL_TEXTURE_2D, impostor.normalDepth);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	stateBindTexture(0, GL_TEXTURE_2D, 0);
+
+	impostor.bakedGeneration = impostor.bake->generation;
+	return true;
+}
+
+// One instanced draw of count quads whose attributes are at offset in buffer (view, projection and lights are set by the caller)
+void drawImpostors(Impostor& impostor, const glm::mat4& view, const glm::mat4& projection, GLuint buffer, GLintptr offset, size_t count)
+{
+	if (count == 0 || !impostorReady(impostor))
+		return;
+
+	GLuint program = impostor.draw->program;
+	stateUseProgram(program);
+
+	// Orthographic projections keep w = 1, rays are then parallel to the view direction
+	glm::vec3 forward(-view[0][2], -view[1][2], -view[2][2]);
+	glUniform3f(glGetUniformLocation(program, "viewForward"), forward.x, forward.y, forward.z);
+	glUniform1i(glGetUniformLocation(program, "orthographic"), projection[2][3] == 0.0f);
+	glUniform3f(glGetUniformLocation(program, "boundsCenter"), impostor.center.x, impostor.center.y, impostor.center.z);
+	glUniform1f(glGetUniformLocation(program, "boundsRadius"), impostor.radius);
+	glUniform1i(glGetUniformLocation(program, "gridSize"), IMPOSTOR_GRID);
+	glUniform1i(glGetUniformLocation(program, "albedoAtlas"), 0);
+	glUniform1i(glGetUniformLocation(program, "normalDepthAtlas"), 1);
+
+	stateBindTexture(0, GL_TEXTURE_2D, impostor.albedo);
+	stateBindTexture(1, GL_TEXTURE_2D, impostor.normalDepth);
+
+	// Attributes point into this frame's part of the instance ring
+	stateBindVertexArray(impostor.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (GLvoid*)offset);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (GLvoid*)(offset + 4 * sizeof(float)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+	frameStats.drawCalls++;
+	frameStats.impostorsDrawn += (unsigned int)count;
+
+	stateBindTexture(1, GL_TEXTURE_2D, 0);
+}
+
+// Release the atlas, buffers and vertex array (the shaders belong to the shader manager)
+void freeImpostor(Impostor& impostor)
+{
+	glDeleteFramebuffers(1, &impostor.fbo);
+	glDeleteTextures(1, &impostor.albedo);
+	glDeleteTextures(1, &impostor.normalDepth);
+	glDeleteRenderbuffers(1, &impostor.depth);
+	glDeleteBuffers(1, &impostor.uniforms);
+	glDeleteVertexArrays(1, &impostor.vao);
+
+	impostor.fbo = impostor.albedo = impostor.normalDepth = impostor.depth = 0;
+	impostor.uniforms = impostor.vao = 0;
+	impostor.bakedGeneration = 0;
+}
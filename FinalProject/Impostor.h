@@ -0,0 +1,64 @@
+/* Description:
+Octahedral impostors. An object is rendered once from a
+grid of directions covering the sphere (octahedral mapping:
+grid positions unfold to directions) into an atlas holding
+albedo with coverage, and object-space normal with depth.
+
+Far instances are then drawn with one instanced call as
+camera-facing quads. Each quad blends the three grid views
+around its view direction: the view ray is intersected with
+every view's plane to find where to sample, and the stored
+depth rebuilds the surface point so instances are lit by
+the scene lights and write correct depth.
+
+Baking needs the bake shader, so it happens on the first
+frame the shader is ready and again whenever it reloads.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+
+#include "DrawList.h"
+#include "ShaderManager.h"
+
+/* Constants */
+const int IMPOSTOR_GRID = 8;			// Views per atlas side
+const int IMPOSTOR_FRAME_SIZE = 128;	// Pixels per view
+
+/* Piece of the object drawn into the atlas */
+struct ImpostorPart {
+	GLuint vao;
+	GLuint texture;
+	GLsizei indexCount;
+	PerDrawUniforms uniforms;	// Object-space placement of the piece
+};
+
+/* Per-instance attributes of the impostor draw */
+struct ImpostorInstance {
+	float position[3];
+	float scale;				// Uniform scale (largest axis)
+	float rotation[4];			// Quaternion x, y, z, w
+};
+
+/* Atlas of one object and the programs that bake and draw it */
+struct Impostor {
+	GLuint fbo = 0;
+	GLuint albedo = 0;			// RGB albedo, A coverage
+	GLuint normalDepth = 0;		// XYZ object-space normal, W depth across the bounds
+	GLuint depth = 0;
+	GLuint uniforms = 0;		// PerDraw blocks of the parts while baking
+	GLuint vao = 0;				// Instance attributes only, corners come from gl_VertexID
+	ShaderProgram* bake = nullptr;
+	ShaderProgram* draw = nullptr;
+	glm::vec3 center;			// Object-space bounding sphere the views were taken around
+	GLfloat radius = 1.0f;
+	unsigned int bakedGeneration = 0;	// Bake shader generation the atlas was rendered with, 0 if never
+};
+
+/* Impostor prototypes */
+void initImpostor(Impostor& impostor, const glm::vec3& center, GLfloat radius);
+bool impostorReady(const Impostor& impostor);
+bool bakeImpostor(Impostor& impostor, const ImpostorPart* parts, size_t count);
+void drawImpostors(Impostor& impostor, const glm::mat4& view, const glm::mat4& projection, GLuint buffer, GLintptr offset, size_t count);
+void freeImpostor(Impostor& impostor);
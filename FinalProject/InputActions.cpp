@@ -0,0 +1,102 @@
+#include "InputActions.h"
+
+using namespace std;
+
+// Press or release one source bound to an action
+static void UpdateAction(ActionState& state, int action)
+{
+	if (action == GLFW_PRESS) {
+		if (state.sources++ == 0) {
+			state.down = true;
+			state.pressed++;
+		}
+	}
+	else if (action == GLFW_RELEASE && state.sources > 0) {
+		if (--state.sources == 0) {
+			state.down = false;
+			state.released++;
+		}
+	}
+}
+
+// Clear all bindings and state
+void initInputState(InputState& input)
+{
+	input = InputState();
+	for (InputAction& binding : input.keyBindings)
+		binding = ACTION_NONE;
+	for (InputAction& binding : input.buttonBindings)
+		binding = ACTION_NONE;
+}
+
+// Bind a GLFW key to an action
+void bindKey(InputState& input, int key, InputAction action)
+{
+	if (key >= 0 && key <= GLFW_KEY_LAST)
+		input.keyBindings[key] = action;
+}
+
+// Bind a GLFW mouse button to an action
+void bindMouseButton(InputState& input, int button, InputAction action)
+{
+	if (button >= 0 && button <= GLFW_MOUSE_BUTTON_LAST)
+		input.buttonBindings[button] = action;
+}
+
+// Start a new frame, per-frame counters restart at zero
+void beginInputFrame(InputState& input)
+{
+	for (ActionState& state : input.actions) {
+		state.pressed = 0;
+		state.released = 0;
+	}
+	input.cursorDeltaX = 0.0;
+	input.cursorDeltaY = 0.0;
+	input.scroll = 0.0;
+}
+
+// Update actions and cursor from one event
+void applyInputEvent(InputState& input, const InputEvent& event)
+{
+	switch (event.type) {
+	case INPUT_KEY:
+		if (event.code >= 0 && event.code <= GLFW_KEY_LAST && input.keyBindings[event.code] != ACTION_NONE)
+			UpdateAction(input.actions[input.keyBindings[event.code]], event.action);
+		break;
+
+	case INPUT_MOUSE_BUTTON:
+		if (event.code >= 0 && event.code <= GLFW_MOUSE_BUTTON_LAST && input.buttonBindings[event.code] != ACTION_NONE)
+			UpdateAction(input.actions[input.buttonBindings[event.code]], event.action);
+		break;
+
+	case INPUT_CURSOR:
+		// First position only sets the reference point
+		if (!input.cursorValid) {
+			input.cursorX = event.x;
+			input.cursorY = event.y;
+			input.cursorValid = true;
+		}
+
+		input.cursorDeltaX = event.x - input.cursorX;
+		input.cursorDeltaY = input.cursorY - event.y; // inverted Y axis
+		input.cursorX = event.x;
+		input.cursorY = event.y;
+		break;
+
+	case INPUT_SCROLL:
+		input.scroll += event.y;
+		break;
+	}
+}
+
+// Action is currently held
+bool actionDown(const InputState& input, InputAction action)
+{
+	return input.actions[action].down;
+}
+
+// Number of times the action was pressed this frame
+int actionPressed(const InputState& input, InputAction action)
+{
+	return input.actions[action].pressed;
+}
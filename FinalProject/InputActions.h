@@ -0,0 +1,59 @@
+/* Description:
+Maps raw input events to named actions. Keys and mouse
+buttons are bound to actions; consumers ask whether an
+action is held or how many times it was pressed this
+frame instead of reading key codes directly.
+*/
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include "InputQueue.h"
+
+/* Actions the application responds to */
+enum InputAction {
+	ACTION_NONE = -1,
+	ACTION_RESET_VIEW = 0,		// Reset camera to its starting position
+	ACTION_TOGGLE_ORTHO,		// Toggle orthographic projection
+	ACTION_TOGGLE_LIGHTS,		// Toggle drawing of light objects
+	ACTION_TOGGLE_STATS,		// Toggle printing of frame statistics
+	ACTION_TOGGLE_WIREFRAME,	// Step through the wireframe modes
+	ACTION_TOGGLE_PROGRESSIVE,	// Toggle progressive supersampling while the view is still
+	ACTION_CYCLE_VSYNC,			// Step through the swap interval modes
+	ACTION_TOGGLE_PREPASS,		// Toggle the depth pre-pass
+	ACTION_TOGGLE_OVERDRAW,		// Toggle the overdraw heat map
+	ACTION_TOGGLE_QUAD_VIEW,	// Toggle the four-view layout
+	ACTION_ORBIT_MODIFIER,		// Held together with ACTION_ORBIT_DRAG to orbit
+	ACTION_ORBIT_DRAG,
+	ACTION_COUNT
+};
+
+/* State of one action */
+struct ActionState {
+	bool down = false;		// Currently held
+	int pressed = 0;		// Presses since beginInputFrame()
+	int released = 0;		// Releases since beginInputFrame()
+	int sources = 0;		// Bound keys/buttons currently held
+};
+
+/* Bindings and current state of every action */
+struct InputState {
+	InputAction keyBindings[GLFW_KEY_LAST + 1];
+	InputAction buttonBindings[GLFW_MOUSE_BUTTON_LAST + 1];
+	ActionState actions[ACTION_COUNT];
+
+	bool cursorValid = false;			// A cursor position has been seen
+	double cursorX = 0.0, cursorY = 0.0;	// Last cursor position
+	double cursorDeltaX = 0.0;			// Movement of the last cursor event
+	double cursorDeltaY = 0.0;			// (positive Y is up)
+	double scroll = 0.0;				// Vertical scroll since beginInputFrame()
+};
+
+/* Input action prototypes */
+void initInputState(InputState& input);
+void bindKey(InputState& input, int key, InputAction action);
+void bindMouseButton(InputState& input, int button, InputAction action);
+void beginInputFrame(InputState& input);
+void applyInputEvent(InputState& input, const InputEvent& event);
+bool actionDown(const InputState& input, InputAction action);
+int actionPressed(const InputState& input, InputAction action);
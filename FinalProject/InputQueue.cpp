@@ -0,0 +1,35 @@
+#include "InputQueue.h"
+
+using namespace std;
+
+// Producer: append an event, false (and counted as dropped) if the queue is full
+bool pushInputEvent(InputQueue& queue, const InputEvent& event)
+{
+	uint32_t head = queue.head.load(memory_order_relaxed);
+	uint32_t tail = queue.tail.load(memory_order_acquire);
+	if (head - tail >= INPUT_QUEUE_SIZE) {
+		queue.dropped.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+
+	queue.events[head & (INPUT_QUEUE_SIZE - 1)] = event;
+
+	// Publish the event after it has been written
+	queue.head.store(head + 1, memory_order_release);
+	return true;
+}
+
+// Consumer: take the oldest event, false if the queue is empty
+bool popInputEvent(InputQueue& queue, InputEvent& event)
+{
+	uint32_t tail = queue.tail.load(memory_order_relaxed);
+	uint32_t head = queue.head.load(memory_order_acquire);
+	if (tail == head)
+		return false;
+
+	event = queue.events[tail & (INPUT_QUEUE_SIZE - 1)];
+
+	// Hand the slot back to the producer after it has been read
+	queue.tail.store(tail + 1, memory_order_release);
+	return true;
+}
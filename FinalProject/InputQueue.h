@@ -0,0 +1,48 @@
+/* Description:
+Timestamped input events passed from the GLFW callbacks to
+the code that consumes them, through a fixed size lock-free
+ring buffer. Exactly one thread may push (the thread that
+polls GLFW events) and one thread may pop.
+
+Every press, release, cursor move and scroll is kept in
+order, so input that starts and ends within one frame is
+not lost.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/* Constants */
+const uint32_t INPUT_QUEUE_SIZE = 1024;		// Events, must be a power of two
+
+/* Kinds of input event */
+enum InputEventType : uint8_t {
+	INPUT_KEY,				// code = GLFW key
+	INPUT_MOUSE_BUTTON,		// code = GLFW mouse button
+	INPUT_CURSOR,			// x, y = cursor position in screen coordinates
+	INPUT_SCROLL			// x, y = scroll offsets
+};
+
+/* Single input event */
+struct InputEvent {
+	double time = 0.0;		// glfwGetTime() when the event was received
+	InputEventType type = INPUT_KEY;
+	int code = 0;			// Key or mouse button
+	int action = 0;			// GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+	int mods = 0;			// GLFW modifier bits
+	double x = 0.0;
+	double y = 0.0;
+};
+
+/* Single-producer/single-consumer ring of events */
+struct InputQueue {
+	InputEvent events[INPUT_QUEUE_SIZE];
+	alignas(64) std::atomic<uint32_t> head{ 0 };	// Next slot to write, owned by the producer
+	alignas(64) std::atomic<uint32_t> tail{ 0 };	// Next slot to read, owned by the consumer
+	std::atomic<uint32_t> dropped{ 0 };				// Events pushed while the queue was full
+};
+
+/* Input queue prototypes */
+bool pushInputEvent(InputQueue& queue, const InputEvent& event);
+bool popInputEvent(InputQueue& queue, InputEvent& event);
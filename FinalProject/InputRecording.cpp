@@ -0,0 +1,158 @@
+#include "InputRecording.h"
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+#include "BinaryIO.h"
+
+using namespace std;
+
+/* Constants */
+const char LOG_MAGIC[4] = { 'H', 'R', 'I', 'L' };
+const uint8_t RECORD_EVENT = 1;
+const uint8_t RECORD_FRAME = 2;
+const float CAMERA_TOLERANCE = 1e-4f;	// Allowed drift between builds before a frame counts as diverged
+
+// Create the log and write its header
+bool openInputRecording(InputRecorder& recorder, const string& path, int width, int height, double startTime)
+{
+	recorder = InputRecorder();
+	recorder.file = fopen(path.c_str(), "wb");
+	if (!recorder.file) {
+		cout << "Could not create input log " << path << endl;
+		return false;
+	}
+
+	fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), recorder.file);
+	writeField<uint32_t>(recorder.file, INPUT_LOG_VERSION);
+	writeField<int32_t>(recorder.file, width);
+	writeField<int32_t>(recorder.file, height);
+
+	recorder.startTime = startTime;
+	return true;
+}
+
+// Append an event consumed during frame
+void recordInputEvent(InputRecorder& recorder, uint32_t frame, const InputEvent& event)
+{
+	if (!recorder.file)
+		return;
+
+	writeField<uint8_t>(recorder.file, RECORD_EVENT);
+	writeField<uint32_t>(recorder.file, frame);
+	writeField<double>(recorder.file, event.time - recorder.startTime);
+	writeField<uint8_t>(recorder.file, event.type);
+	writeField<int16_t>(recorder.file, (int16_t)event.code);
+	writeField<int8_t>(recorder.file, (int8_t)event.action);
+	writeField<uint8_t>(recorder.file, (uint8_t)event.mods);
+	writeField<double>(recorder.file, event.x);
+	writeField<double>(recorder.file, event.y);
+	recorder.events++;
+}
+
+// Mark the end of a frame with the camera state it produced
+void recordFrameEnd(InputRecorder& recorder, uint32_t frame, const CameraState& camera)
+{
+	if (!recorder.file)
+		return;
+
+	writeField<uint8_t>(recorder.file, RECORD_FRAME);
+	writeField<uint32_t>(recorder.file, frame);
+	writeField<float>(recorder.file, camera.position.x);
+	writeField<float>(recorder.file, camera.position.y);
+	writeField<float>(recorder.file, camera.position.z);
+	writeField<float>(recorder.file, camera.yaw);
+	writeField<float>(recorder.file, camera.pitch);
+	writeField<float>(recorder.file, camera.fov);
+	writeField<uint8_t>(recorder.file, camera.flags);
+	recorder.frames++;
+}
+
+// Finish the log
+void closeInputRecording(InputRecorder& recorder)
+{
+	if (!recorder.file)
+		return;
+
+	fclose(recorder.file);
+	cout << "Recorded " << recorder.frames << " frames, " << recorder.events << " input events" << endl;
+	recorder.file = nullptr;
+}
+
+// Read a whole log, grouping events by frame
+bool loadInputReplay(InputReplay& replay, const string& path)
+{
+	replay = InputReplay();
+
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		cout << "Could not open input log " << path << endl;
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	int32_t width = 0, height = 0;
+	if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0 ||
+		!readField(file, version) || version != INPUT_LOG_VERSION || !readField(file, width) || !readField(file, height)) {
+		cout << path << " is not an input log (or has an unsupported version)" << endl;
+		fclose(file);
+		return false;
+	}
+	replay.width = width;
+	replay.height = height;
+
+	ReplayFrame current;
+	uint8_t record;
+	bool valid = true;
+	while (valid && readField(file, record)) {
+		uint32_t frame = 0;
+		valid = readField(file, frame) && frame == replay.frames.size();
+
+		if (valid && record == RECORD_EVENT) {
+			InputEvent event;
+			uint8_t type, mods;
+			int16_t code;
+			int8_t action;
+			valid = readField(file, event.time) && readField(file, type) && readField(file, code) && readField(file, action) &&
+				readField(file, mods) && readField(file, event.x) && readField(file, event.y);
+			event.type = (InputEventType)type;
+			event.code = code;
+			event.action = action;
+			event.mods = mods;
+
+			if (current.eventCount == 0)
+				current.firstEvent = replay.events.size();
+			replay.events.push_back(event);
+			current.eventCount++;
+		}
+		else if (valid && record == RECORD_FRAME) {
+			CameraState& camera = current.camera;
+			valid = readField(file, camera.position.x) && readField(file, camera.position.y) && readField(file, camera.position.z) &&
+				readField(file, camera.yaw) && readField(file, camera.pitch) && readField(file, camera.fov) && readField(file, camera.flags);
+
+			replay.frames.push_back(current);
+			current = ReplayFrame();
+		}
+		else {
+			valid = false;
+		}
+	}
+	fclose(file);
+
+	if (!valid)
+		cout << path << " is truncated, replaying the first " << replay.frames.size() << " frames" << endl;
+
+	return !replay.frames.empty();
+}
+
+// Same view within floating point tolerance
+bool cameraStatesMatch(const CameraState& a, const CameraState& b)
+{
+	return a.flags == b.flags &&
+		glm::length(a.position - b.position) <= CAMERA_TOLERANCE &&
+		fabs(a.yaw - b.yaw) <= CAMERA_TOLERANCE &&
+		fabs(a.pitch - b.pitch) <= CAMERA_TOLERANCE &&
+		fabs(a.fov - b.fov) <= CAMERA_TOLERANCE;
+}
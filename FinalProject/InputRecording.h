@@ -0,0 +1,77 @@
+/* Description:
+Records input events and the resulting camera state to a
+compact binary log, and loads such a log back for replay.
+
+Events are stored with the index of the frame that consumed
+them, so a replay applies exactly the same events on exactly
+the same frames regardless of how fast either run was. The
+camera state stored at the end of every frame lets a replay
+detect where it diverges from the recording.
+
+File layout (native byte order):
+	header:	"HRIL" | version u32 | width i32 | height i32
+	event:	1 u8 | frame u32 | time f64 | type u8 | code i16 | action i8 | mods u8 | x f64 | y f64
+	frame:	2 u8 | frame u32 | position 3*f32 | yaw f32 | pitch f32 | fov f32 | flags u8
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "InputQueue.h"
+
+/* Constants */
+const uint32_t INPUT_LOG_VERSION = 2;	// 2: flags hold the wireframe mode, depth pre-pass and overdraw
+
+/* View state compared between recording and replay */
+struct CameraState {
+	glm::vec3 position;
+	float yaw = 0.0f;			// Raw yaw/pitch accumulated from cursor movement
+	float pitch = 0.0f;
+	float fov = 0.0f;
+	uint8_t flags = 0;			// CAMERA_* bits
+};
+
+/* CameraState flags */
+const uint8_t CAMERA_ORTHO = 1;
+const uint8_t CAMERA_PREPASS = 2;
+const uint8_t CAMERA_LIGHTS = 4;
+const uint8_t CAMERA_PROGRESSIVE = 8;
+const uint8_t CAMERA_QUAD_VIEW = 16;
+const int CAMERA_WIREFRAME_SHIFT = 5;			// WireframeMode, two bits
+const uint8_t CAMERA_WIREFRAME = 3 << CAMERA_WIREFRAME_SHIFT;
+const uint8_t CAMERA_OVERDRAW = 128;
+
+/* Log being written */
+struct InputRecorder {
+	FILE* file = nullptr;
+	double startTime = 0.0;		// Event times are stored relative to this
+	uint32_t events = 0;
+	uint32_t frames = 0;
+};
+
+/* Events of one recorded frame */
+struct ReplayFrame {
+	size_t firstEvent = 0;
+	size_t eventCount = 0;
+	CameraState camera;			// State after the frame's events were applied
+};
+
+/* Log loaded for replay */
+struct InputReplay {
+	int width = 0;				// Framebuffer size during the recording
+	int height = 0;
+	std::vector<InputEvent> events;
+	std::vector<ReplayFrame> frames;
+};
+
+/* Input recording prototypes */
+bool openInputRecording(InputRecorder& recorder, const std::string& path, int width, int height, double startTime);
+void recordInputEvent(InputRecorder& recorder, uint32_t frame, const InputEvent& event);
+void recordFrameEnd(InputRecorder& recorder, uint32_t frame, const CameraState& camera);
+void closeInputRecording(InputRecorder& recorder);
+bool loadInputReplay(InputReplay& replay, const std::string& path);
+bool cameraStatesMatch(const CameraState& a, const CameraState& b);
@@ -0,0 +1,181 @@
+#include "IrradianceVolume.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#include "WorkerPool.h"
+#include "GLState.h"
+
+using namespace std;
+
+/* Constants */
+const char IRRADIANCE_MAGIC[4] = { 'H', 'R', 'I', 'V' };
+const GLfloat LIGHT_MATCH = 1.0e-4f;	// Largest difference of a light value still considered the same light
+
+static const glm::vec3 DIRECTIONS[IRRADIANCE_DIRECTIONS] = {
+	glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+	glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+	glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+};
+
+// Diffuse light of every direction of the probes in one z slice, as harmonica.frag computes it
+static void BakeSlice(IrradianceVolume* volume, int z)
+{
+	int nx = volume->probes[0], ny = volume->probes[1], nz = volume->probes[2];
+	glm::vec3 step = (volume->high - volume->low) / glm::max(glm::vec3((float)(nx - 1), (float)(ny - 1), (float)(nz - 1)), glm::vec3(1.0f));
+
+	for (int y = 0; y < ny; ++y) {
+		for (int x = 0; x < nx; ++x) {
+			glm::vec3 position = volume->low + step * glm::vec3((float)x, (float)y, (float)z);
+			glm::vec3 diffuse[IRRADIANCE_DIRECTIONS];
+			for (int d = 0; d < IRRADIANCE_DIRECTIONS; ++d)
+				diffuse[d] = glm::vec3(0.0f);
+
+			for (const BakeLight& light : volume->lights) {
+				glm::vec3 toLight = light.position - position;
+				GLfloat distance = glm::length(toLight);
+				if (distance <= 0.0f)
+					continue;
+				toLight /= distance;
+				for (int d = 0; d < IRRADIANCE_DIRECTIONS; ++d)
+					diffuse[d] += max(glm::dot(DIRECTIONS[d], toLight), 0.0f) * light.strength * light.color;
+			}
+
+			for (int d = 0; d < IRRADIANCE_DIRECTIONS; ++d) {
+				GLfloat* out = &volume->irradiance[((((size_t)d * nz + z) * ny + y) * nx + x) * 3];
+				out[0] = diffuse[d].x;
+				out[1] = diffuse[d].y;
+				out[2] = diffuse[d].z;
+			}
+		}
+	}
+}
+
+// Bake the diffuse light of the given lights on a grid covering low to high
+void bakeIrradianceVolume(IrradianceVolume& volume, const glm::vec3& low, const glm::vec3& high, const vector<BakeLight>& lights, const BakeSettings& settings)
+{
+	volume = IrradianceVolume();
+	volume.low = low;
+	volume.high = high;
+	volume.lights = lights;
+
+	// As many probes as the spacing asks for, at most maxProbes along any axis
+	glm::vec3 extent = high - low;
+	GLfloat longest = max(extent.x, max(extent.y, extent.z));
+	GLfloat spacing = max(settings.spacing, longest / max(settings.maxProbes - 1, 1));
+	for (int axis = 0; axis < 3; ++axis)
+		volume.probes[axis] = max(2, (int)ceil(extent[axis] / spacing) + 1);
+	volume.irradiance.resize((size_t)volume.probes[0] * volume.probes[1] * volume.probes[2] * IRRADIANCE_DIRECTIONS * 3);
+
+	// Nothing else runs yet, every core can bake
+	WorkerPool pool;
+	startWorkerPool(pool, settings.threads ? settings.threads : max(thread::hardware_concurrency(), 1u));
+	IrradianceVolume* target = &volume;
+	for (int z = 0; z < volume.probes[2]; ++z)
+		submitWork(pool, [target, z] { BakeSlice(target, z); });
+	waitWorkerPool(pool);
+	stopWorkerPool(pool);
+}
+
+// Write a baked volume
+bool saveIrradianceVolume(const IrradianceVolume& volume, const string& path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		cout << "Could not create lighting file " << path << endl;
+		return false;
+	}
+
+	uint32_t lightCount = (uint32_t)volume.lights.size();
+	fwrite(IRRADIANCE_MAGIC, 1, sizeof(IRRADIANCE_MAGIC), file);
+	fwrite(&IRRADIANCE_FILE_VERSION, sizeof(uint32_t), 1, file);
+	fwrite(volume.probes, sizeof(int32_t), 3, file);
+	fwrite(&volume.low.x, sizeof(float), 3, file);
+	fwrite(&volume.high.x, sizeof(float), 3, file);
+	fwrite(&lightCount, sizeof(uint32_t), 1, file);
+	for (const BakeLight& light : volume.lights) {
+		fwrite(&light.position.x, sizeof(float), 3, file);
+		fwrite(&light.color.x, sizeof(float), 3, file);
+		fwrite(&light.strength, sizeof(float), 1, file);
+	}
+	fwrite(volume.irradiance.data(), sizeof(float), volume.irradiance.size(), file);
+
+	bool ok = !ferror(file);
+	fclose(file);
+	if (!ok)
+		cout << "Could not write lighting file " << path << endl;
+	return ok;
+}
+
+// Read a baked volume
+bool loadIrradianceVolume(IrradianceVolume& volume, const string& path)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		cout << "Could not open lighting file " << path << endl;
+		return false;
+	}
+
+	volume = IrradianceVolume();
+	char magic[4];
+	uint32_t version = 0, lightCount = 0;
+	bool valid = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, IRRADIANCE_MAGIC, sizeof(magic)) == 0 &&
+		fread(&version, sizeof(uint32_t), 1, file) == 1 && version == IRRADIANCE_FILE_VERSION &&
+		fread(volume.probes, sizeof(int32_t), 3, file) == 3 &&
+		fread(&volume.low.x, sizeof(float), 3, file) == 3 &&
+		fread(&volume.high.x, sizeof(float), 3, file) == 3 &&
+		fread(&lightCount, sizeof(uint32_t), 1, file) == 1;
+	for (int axis = 0; axis < 3 && valid; ++axis)
+		valid = volume.probes[axis] >= 2 && volume.probes[axis] <= 4096;
+
+	for (uint32_t i = 0; i < lightCount && valid; ++i) {
+		BakeLight light;
+		valid = fread(&light.position.x, sizeof(float), 3, file) == 3 && fread(&light.color.x, sizeof(float), 3, file) == 3 &&
+			fread(&light.strength, sizeof(float), 1, file) == 1;
+		volume.lights.push_back(light);
+	}
+	if (valid) {
+		volume.irradiance.resize((size_t)volume.probes[0] * volume.probes[1] * volume.probes[2] * IRRADIANCE_DIRECTIONS * 3);
+		valid = fread(volume.irradiance.data(), sizeof(float), volume.irradiance.size(), file) == volume.irradiance.size();
+	}
+	fclose(file);
+
+	if (!valid) {
+		cout << "Lighting file " << path << " is not a version " << IRRADIANCE_FILE_VERSION << " irradiance volume" << endl;
+		volume = IrradianceVolume();
+	}
+	return valid;
+}
+
+// The volume was baked for these lights
+bool sameBakeLights(const IrradianceVolume& volume, const vector<BakeLight>& lights)
+{
+	if (volume.lights.size() != lights.size())
+		return false;
+	for (size_t i = 0; i < lights.size(); ++i) {
+		const BakeLight& a = volume.lights[i];
+		const BakeLight& b = lights[i];
+		if (glm::length(a.position - b.position) > LIGHT_MATCH || glm::length(a.color - b.color) > LIGHT_MATCH || fabs(a.strength - b.strength) > LIGHT_MATCH)
+			return false;
+	}
+	return true;
+}
+
+// 3D texture of the volume, the directions stacked along z; the GL context must be current
+GLuint createIrradianceTexture(const IrradianceVolume& volume)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	stateBindTexture(IRRADIANCE_UNIT, GL_TEXTURE_3D, texture);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, volume.probes[0], volume.probes[1], volume.probes[2] * IRRADIANCE_DIRECTIONS, 0, GL_RGB, GL_FLOAT, volume.irradiance.data());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	return texture;
+}
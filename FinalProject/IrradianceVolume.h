@@ -0,0 +1,70 @@
+/* Description:
+Baked diffuse lighting for static scenes. The lamps never
+move, so the diffuse term of harmonica.frag is computed once
+on the CPU for a grid of probes covering the scene, and the
+shader looks it up instead of evaluating every light per
+fragment; specular stays live.
+
+Each probe stores the diffuse light arriving on a surface
+facing each of the six axis directions (an ambient cube).
+The shader blends the three facing its normal by the
+squared normal components, which is exact for faces on the
+axes (almost all of the harmonica). Unlike the live
+shader the bake has room for every light of a scene, not
+only the first LIGHT_COUNT. No shadows or bounces, like the
+live diffuse term.
+
+Probes are baked one z slice per job on a WorkerPool. The
+grid is a 3D texture with the six directions stacked along
+z (+X, -X, +Y, -Y, +Z, -Z), so a lookup never blends across
+two of them.
+
+File layout (native byte order):
+	"HRIV" | version u32 | probes 3*i32 | low 3*f32 | high 3*f32 | lights u32
+	light:		position 3*f32 | color 3*f32 | strength f32
+	irradiance:	RGB f32 per probe per direction, direction-major, then z, y, x
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Constants */
+const uint32_t IRRADIANCE_FILE_VERSION = 1;
+const int IRRADIANCE_DIRECTIONS = 6;
+const GLfloat PRIMARY_DIFFUSE = 1.0f;		// Diffuse strength of the first light in harmonica.frag
+const GLfloat SECONDARY_DIFFUSE = 0.2f;		// Every other light
+const GLuint IRRADIANCE_UNIT = 2;			// Texture unit of the volume
+
+/* Point light as the shader applies it */
+struct BakeLight {
+	glm::vec3 position;
+	glm::vec3 color;
+	GLfloat strength;
+};
+
+/* Grid spacing and size */
+struct BakeSettings {
+	GLfloat spacing = 0.25f;		// Distance between probes, widened if the grid would exceed maxProbes
+	int maxProbes = 64;				// Per axis
+	unsigned int threads = 0;		// 0 for one per core
+};
+
+/* Diffuse light on a regular grid of probes */
+struct IrradianceVolume {
+	int probes[3] = {};					// Along each axis, probes sit on the corners of the box too
+	glm::vec3 low = glm::vec3(0.0f);
+	glm::vec3 high = glm::vec3(0.0f);
+	std::vector<BakeLight> lights;		// Lights it was baked for
+	std::vector<GLfloat> irradiance;	// See the file layout
+};
+
+/* Irradiance volume prototypes */
+void bakeIrradianceVolume(IrradianceVolume& volume, const glm::vec3& low, const glm::vec3& high, const std::vector<BakeLight>& lights, const BakeSettings& settings);
+bool saveIrradianceVolume(const IrradianceVolume& volume, const std::string& path);
+bool loadIrradianceVolume(IrradianceVolume& volume, const std::string& path);
+bool sameBakeLights(const IrradianceVolume& volume, const std::vector<BakeLight>& lights);
+GLuint createIrradianceTexture(const IrradianceVolume& volume);
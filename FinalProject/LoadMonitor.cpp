@@ -0,0 +1,135 @@
+#include "LoadMonitor.h"
+
+#include <iostream>
+#include <iomanip>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+#include "FrameTimings.h"
+
+using namespace std;
+
+/* Constants */
+const double SAMPLE_INTERVAL = 1.0;		// Seconds per load sample
+
+/* Module state */
+static LoadSample current;				// Sample being collected
+static LoadSample previous;				// Last completed sample
+static unsigned long long totalSkipped = 0;
+static double sampleStart = -1.0;		// Wall time the current sample began
+static double sampleCpuStart = 0.0;
+static unsigned long long sampleGpuStart = 0;
+
+// Frame was built and handed to the renderer
+void countRenderedFrame()
+{
+	current.renderedFrames++;
+}
+
+// Loop woke up but nothing had changed, so no frame was rendered
+void countSkippedFrame()
+{
+	current.skippedFrames++;
+	totalSkipped++;
+}
+
+// Frames skipped since startup
+unsigned long long skippedFrameCount()
+{
+	return totalSkipped;
+}
+
+// Close the sample once per interval (printing it if asked), true when a sample completed
+bool updateLoad(double currentTime, bool print)
+{
+	if (sampleStart < 0.0) {
+		sampleStart = currentTime;
+		sampleCpuStart = processCpuSeconds();
+		sampleGpuStart = gpuBusyNanoseconds();
+		return false;
+	}
+
+	double elapsed = currentTime - sampleStart;
+	if (elapsed < SAMPLE_INTERVAL)
+		return false;
+
+	double cpu = processCpuSeconds();
+	unsigned long long gpu = gpuBusyNanoseconds();
+	current.cpuLoad = (cpu - sampleCpuStart) / elapsed;
+	current.gpuLoad = (gpu - sampleGpuStart) / 1.0e9 / elapsed;
+
+	previous = current;
+	current = LoadSample();
+	sampleStart = currentTime;
+	sampleCpuStart = cpu;
+	sampleGpuStart = gpu;
+
+	if (print) {
+		ios::fmtflags flags = cout.flags();
+		streamsize precision = cout.precision();
+		cout << fixed << setprecision(1)
+			<< "Frames: " << previous.renderedFrames << " rendered, " << previous.skippedFrames << " skipped"
+			<< " | CPU load: " << previous.cpuLoad * 100.0 << "%"
+			<< " | GPU load: " << previous.gpuLoad * 100.0 << "%" << endl;
+		cout.flags(flags);
+		cout.precision(precision);
+	}
+
+	return true;
+}
+
+// Last completed sample
+const LoadSample& lastLoadSample()
+{
+	return previous;
+}
+
+// User + kernel CPU time of every thread in the process
+double processCpuSeconds()
+{
+#ifdef _WIN32
+	FILETIME created, exited, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+		return 0.0;
+
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) * 1.0e-7; // 100ns units
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e-6;
+#endif
+}
+
+// Resident memory of the process (working set) in bytes, 0 if unknown
+unsigned long long processMemoryBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.WorkingSetSize;
+#else
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (!statm)
+		return 0;
+
+	unsigned long long size = 0, resident = 0;
+	bool ok = fscanf(statm, "%llu %llu", &size, &resident) == 2;
+	fclose(statm);
+	return ok ? resident * (unsigned long long)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
@@ -0,0 +1,26 @@
+/* Description:
+Measures what the application costs while it runs: frames
+rendered and skipped, and the CPU time of the whole process
+and the GPU time of rendered frames as a share of wall-clock
+time. Used to check that an idle on-demand window really is
+idle. Main thread only, except processCpuSeconds() and
+processMemoryBytes() (resident memory, for benchmarks).
+*/
+#pragma once
+
+/* Load over the last sample interval */
+struct LoadSample {
+	unsigned int renderedFrames = 0;
+	unsigned int skippedFrames = 0;
+	double cpuLoad = 0.0;		// Process CPU time / wall time (1.0 = one full core)
+	double gpuLoad = 0.0;		// GPU busy time / wall time
+};
+
+/* Load monitor prototypes */
+void countRenderedFrame();
+void countSkippedFrame();
+unsigned long long skippedFrameCount();
+bool updateLoad(double currentTime, bool print);
+const LoadSample& lastLoadSample();
+double processCpuSeconds();
+unsigned long long processMemoryBytes();
@@ -0,0 +1,127 @@
+#include "Mesh.h"
+
+#include <algorithm>
+
+using namespace std;
+
+/* Constants */
+const GLfloat LOD_HYSTERESIS = 0.75f;	// A coarser level must be this far under the error limit before switching to it
+
+// Center of the axis aligned bounds of the vertex positions
+glm::vec3 boundsCenter(const GLfloat* vertices, size_t floatCount, size_t stride)
+{
+	glm::vec3 low(vertices[0], vertices[1], vertices[2]);
+	glm::vec3 high = low;
+
+	for (size_t i = 0; i + 2 < floatCount; i += stride) {
+		glm::vec3 p(vertices[i], vertices[i + 1], vertices[i + 2]);
+		low = glm::min(low, p);
+		high = glm::max(high, p);
+	}
+
+	return (low + high) * 0.5f;
+}
+
+// Describe the vertex attributes of the buffer bound to GL_ARRAY_BUFFER in the bound vertex array
+void setVertexLayout(int floatsPerVertex)
+{
+	GLsizei stride = floatsPerVertex * sizeof(GLfloat);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+
+	if (floatsPerVertex == FULL_VERTEX_STRIDE) {
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(1);
+
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(6 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(2);
+
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(8 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(3);
+	}
+}
+
+// Upload vertices and indices and describe the vertex layout
+Mesh createMesh(const MeshData& data)
+{
+	Mesh mesh;
+	mesh.indexCount = (GLsizei)data.indices.size();
+	mesh.center = boundsCenter(data.vertices.data(), data.vertices.size(), data.stride);
+	mesh.stride = data.stride;
+
+	// Without a chain the whole index array is the only level
+	mesh.lods[0].indexCount = mesh.indexCount;
+	mesh.lodCount = 1;
+	if (!data.lods.empty()) {
+		mesh.lodCount = (int)min(data.lods.size(), (size_t)MAX_MESH_LODS);
+		for (int i = 0; i < mesh.lodCount; ++i)
+			mesh.lods[i] = data.lods[i];
+		mesh.indexCount = mesh.lods[0].indexCount;
+	}
+
+	glGenBuffers(1, &mesh.vbo);
+	glGenBuffers(1, &mesh.ebo);
+	glGenVertexArrays(1, &mesh.vao);
+
+	glBindVertexArray(mesh.vao); // Bind VAO
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo); // Select VBO
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo); // Select EBO
+
+	glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(GLfloat), data.vertices.data(), GL_STATIC_DRAW); // Load vertex attributes
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(GLuint), data.indices.data(), GL_STATIC_DRAW); // Load indices
+
+	// Specify attribute location and layout to GPU
+	setVertexLayout(data.stride);
+
+	glBindVertexArray(0); // Unbind VAO
+
+	// Depth-only passes read a tightly packed position stream instead of the full vertices
+	mesh.depthVao = mesh.vao;
+	if (data.stride != POSITION_VERTEX_STRIDE) {
+		vector<GLfloat> positions;
+		positions.reserve(data.vertices.size() / data.stride * POSITION_VERTEX_STRIDE);
+		for (size_t v = 0; v + POSITION_VERTEX_STRIDE <= data.vertices.size(); v += data.stride)
+			positions.insert(positions.end(), &data.vertices[v], &data.vertices[v] + POSITION_VERTEX_STRIDE);
+
+		glGenBuffers(1, &mesh.positionVbo);
+		glGenVertexArrays(1, &mesh.depthVao);
+		glBindVertexArray(mesh.depthVao);
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.positionVbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+		glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(GLfloat), positions.data(), GL_STATIC_DRAW);
+		setVertexLayout(POSITION_VERTEX_STRIDE);
+		glBindVertexArray(0);
+	}
+
+	return mesh;
+}
+
+// Release the mesh's GL objects
+void deleteMesh(Mesh& mesh)
+{
+	if (mesh.depthVao != mesh.vao)
+		glDeleteVertexArrays(1, &mesh.depthVao);
+	if (mesh.positionVbo)
+		glDeleteBuffers(1, &mesh.positionVbo);
+	glDeleteVertexArrays(1, &mesh.vao);
+	glDeleteBuffers(1, &mesh.vbo);
+	glDeleteBuffers(1, &mesh.ebo);
+	mesh = Mesh();
+}
+
+// Level of detail whose error stays under maxPixelError on screen, moving from the current one with hysteresis
+int selectMeshLod(const Mesh& mesh, int current, GLfloat pixelsPerUnit, GLfloat maxPixelError)
+{
+	int lod = min(max(current, 0), mesh.lodCount - 1);
+
+	// Too coarse, refine until the error fits
+	while (lod > 0 && mesh.lods[lod].error * pixelsPerUnit > maxPixelError)
+		lod--;
+
+	// Coarsen only well inside the limit so an object near the threshold does not pop back and forth
+	while (lod + 1 < mesh.lodCount && mesh.lods[lod + 1].error * pixelsPerUnit < maxPixelError * LOD_HYSTERESIS)
+		lod++;
+
+	return lod;
+}
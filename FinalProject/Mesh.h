@@ -0,0 +1,59 @@
+/* Description:
+GPU mesh created from vertex and index arrays. Vertices are
+either the full harmonica layout (position, color, texcoord,
+normal) or position only, selected by the vertex stride.
+
+A mesh may hold a chain of levels of detail (see
+MeshSimplify.h), all in the same buffers; each level is a
+range of the index buffer with the object-space error it
+introduces, used to pick a level from its size on screen.
+
+Full layout meshes also get a position-only copy of their
+vertices for depth-only passes, sharing the index buffer.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/* Constants */
+const int FULL_VERTEX_STRIDE = 11;		// position(3) color(3) texcoord(2) normal(3)
+const int POSITION_VERTEX_STRIDE = 3;	// position(3)
+const int MAX_MESH_LODS = 4;			// Full detail plus up to three simplified levels
+
+/* Index range of one level of detail */
+struct MeshLod {
+	GLuint firstIndex = 0;
+	GLsizei indexCount = 0;
+	GLfloat error = 0.0f;	// Object-space distance the level may deviate from full detail
+};
+
+/* Vertex and index arrays of a mesh, kept on the CPU */
+struct MeshData {
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	int stride = FULL_VERTEX_STRIDE;	// Floats per vertex
+	std::vector<MeshLod> lods;			// Finest first, empty if the whole index array is the only level
+};
+
+/* Mesh uploaded to the GPU */
+struct Mesh {
+	GLuint vao = 0;
+	GLuint vbo = 0;
+	GLuint ebo = 0;
+	GLuint depthVao = 0;		// Positions only, same indices (vao itself if the mesh is position only)
+	GLuint positionVbo = 0;
+	GLsizei indexCount = 0;
+	glm::vec3 center;		// Bounds center, used for depth sorting
+	MeshLod lods[MAX_MESH_LODS];
+	int lodCount = 1;
+	int stride = FULL_VERTEX_STRIDE;
+};
+
+/* Mesh prototypes */
+glm::vec3 boundsCenter(const GLfloat* vertices, size_t floatCount, size_t stride);
+void setVertexLayout(int floatsPerVertex);
+Mesh createMesh(const MeshData& data);
+void deleteMesh(Mesh& mesh);
+int selectMeshLod(const Mesh& mesh, int current, GLfloat pixelsPerUnit, GLfloat maxPixelError);
@@ -0,0 +1,432 @@
+#include "MeshInstancing.h"
+
+#include <iostream>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+
+using namespace std;
+
+/* Constants */
+const double SPREAD_TOLERANCE = 1.0e-3;		// Principal spreads closer than this (relative to the largest) are equal
+const GLfloat TIE_TOLERANCE = 1.0e-3f;		// Points this close to the farthest distance (relative) are tied with it
+const size_t MAX_AXIS_CANDIDATES = 12;		// Farthest points tried per free axis
+const GLfloat SIGNATURE_CELL = 16.0f;		// Radius quantum of the bucket key, in tolerances
+const GLfloat MIN_TOLERANCE = 1.0e-7f;
+
+typedef tuple<long long, long long, long long> Cell;
+typedef tuple<GLuint, GLuint, GLuint> Triangle;
+typedef tuple<size_t, size_t, long long> BucketKey;	// Points, triangles and the coarse radius of a piece
+
+/* Connected piece of the mesh */
+struct Piece {
+	vector<GLuint> triangles;		// Triangle numbers in the index array
+	vector<GLuint> points;			// Welded points
+	vector<GLuint> corners;			// Local point of every triangle corner
+	vector<Triangle> shape;			// Local corners of every triangle, each triangle and the list sorted
+	glm::vec3 centroid;
+	vector<GLfloat> distances;		// Sorted distances of the points from the centroid
+	vector<glm::mat3> frames;		// Candidate canonical frames, the axes are the columns
+	map<Cell, vector<GLuint>> grid;	// Local points by cell of the tolerance
+};
+
+static Cell CellOf(const glm::vec3& p, GLfloat size)
+{
+	return Cell((long long)floor(p.x / size), (long long)floor(p.y / size), (long long)floor(p.z / size));
+}
+
+static Triangle SortedTriangle(GLuint a, GLuint b, GLuint c)
+{
+	if (a > b) swap(a, b);
+	if (b > c) swap(b, c);
+	if (a > b) swap(a, b);
+	return Triangle(a, b, c);
+}
+
+static GLuint FindRoot(vector<GLuint>& parent, GLuint i)
+{
+	while (parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+// Eigenvalues and eigenvectors (columns) of a symmetric 3x3 matrix by Jacobi rotations
+static void SymmetricEigen(double a[3][3], double values[3], double vectors[3][3])
+{
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			vectors[i][j] = i == j ? 1.0 : 0.0;
+
+	for (int sweep = 0; sweep < 32; ++sweep) {
+		if (a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2] < 1.0e-30)
+			break;
+		for (int p = 0; p < 2; ++p) {
+			for (int q = p + 1; q < 3; ++q) {
+				if (fabs(a[p][q]) < 1.0e-30)
+					continue;
+
+				// Rotation zeroing a[p][q]: A = J^T A J
+				double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+				for (int k = 0; k < 3; ++k) {
+					double kp = a[k][p], kq = a[k][q];
+					a[k][p] = c * kp - s * kq;
+					a[k][q] = s * kp + c * kq;
+				}
+				for (int k = 0; k < 3; ++k) {
+					double pk = a[p][k], qk = a[q][k];
+					a[p][k] = c * pk - s * qk;
+					a[q][k] = s * pk + c * qk;
+				}
+				for (int k = 0; k < 3; ++k) {
+					double kp = vectors[k][p], kq = vectors[k][q];
+					vectors[k][p] = c * kp - s * kq;
+					vectors[k][q] = s * kp + c * kq;
+				}
+			}
+		}
+	}
+	for (int i = 0; i < 3; ++i)
+		values[i] = a[i][i];
+}
+
+// Unit directions to the farthest of the offsets (and those tied with it), ignoring their part along remove
+static void FarthestDirections(const vector<glm::vec3>& offsets, const glm::vec3* remove, vector<glm::vec3>& directions)
+{
+	vector<pair<GLfloat, glm::vec3>> candidates;
+	for (const glm::vec3& offset : offsets) {
+		glm::vec3 d = remove ? offset - *remove * glm::dot(offset, *remove) : offset;
+		candidates.push_back(make_pair(glm::length(d), d));
+	}
+	sort(candidates.begin(), candidates.end(), [](const pair<GLfloat, glm::vec3>& a, const pair<GLfloat, glm::vec3>& b) { return a.first > b.first; });
+	if (candidates.empty() || candidates[0].first <= 0.0f)
+		return;
+
+	for (const pair<GLfloat, glm::vec3>& candidate : candidates) {
+		if (candidate.first < candidates[0].first * (1.0f - TIE_TOLERANCE) || directions.size() >= MAX_AXIS_CANDIDATES)
+			break;
+		directions.push_back(candidate.second / candidate.first);
+	}
+}
+
+// Frames that could line the piece up with a copy of itself: principal axes with every sign,
+// the farthest points standing in for axes whose spread is not unique
+static void CanonicalFrames(Piece& piece, const vector<glm::vec3>& offsets)
+{
+	double covariance[3][3] = {};
+	for (const glm::vec3& o : offsets)
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				covariance[i][j] += (double)o[i] * o[j];
+
+	double values[3], vectors[3][3];
+	SymmetricEigen(covariance, values, vectors);
+	int order[3] = { 0, 1, 2 };
+	sort(order, order + 3, [&](int a, int b) { return values[a] > values[b]; });
+
+	glm::vec3 axes[3];
+	for (int i = 0; i < 3; ++i)
+		axes[i] = glm::vec3((float)vectors[0][order[i]], (float)vectors[1][order[i]], (float)vectors[2][order[i]]);
+	double largest = max(values[order[0]], 1.0e-30);
+	bool distinct01 = values[order[0]] - values[order[1]] > SPREAD_TOLERANCE * largest;
+	bool distinct12 = values[order[1]] - values[order[2]] > SPREAD_TOLERANCE * largest;
+
+	// First axis: the one with a unique spread, else any farthest point
+	vector<glm::vec3> primaries;
+	if (distinct01)
+		primaries = { axes[0], -axes[0] };
+	else if (distinct12)
+		primaries = { axes[2], -axes[2] };
+	else
+		FarthestDirections(offsets, nullptr, primaries);
+
+	for (const glm::vec3& a : primaries) {
+		vector<glm::vec3> secondaries;
+		if (distinct01 && distinct12)
+			secondaries = { axes[1], -axes[1] };
+		else
+			FarthestDirections(offsets, &a, secondaries);
+		for (const glm::vec3& b : secondaries)
+			piece.frames.push_back(glm::mat3(a, b, glm::cross(a, b)));
+	}
+}
+
+// Bucket of a piece: counts and its farthest distance from the centroid, both unchanged by rigid transforms
+static BucketKey BucketOf(const Piece& piece, long long radiusCell)
+{
+	return BucketKey(piece.points.size(), piece.triangles.size(), radiusCell);
+}
+
+// The sorted distances of two pieces agree within tolerance, as they must for the points to match
+static bool SameDistances(const Piece& a, const Piece& b, GLfloat tolerance)
+{
+	if (a.distances.size() != b.distances.size())
+		return false;
+	for (size_t i = 0; i < a.distances.size(); ++i)
+		if (fabs(a.distances[i] - b.distances[i]) > tolerance)
+			return false;
+	return true;
+}
+
+// Nearest of the points within tolerance of p, looked up in the cells around it
+static bool NearestInGrid(const map<Cell, vector<GLuint>>& grid, const vector<GLuint>* indices, const vector<glm::vec3>& points, const glm::vec3& p, GLfloat tolerance, GLuint& nearest, GLfloat& distance)
+{
+	Cell center = CellOf(p, tolerance);
+	distance = tolerance;
+	bool found = false;
+	for (long long dx = -1; dx <= 1; ++dx) {
+		for (long long dy = -1; dy <= 1; ++dy) {
+			for (long long dz = -1; dz <= 1; ++dz) {
+				auto cell = grid.find(Cell(get<0>(center) + dx, get<1>(center) + dy, get<2>(center) + dz));
+				if (cell == grid.end())
+					continue;
+				for (GLuint i : cell->second) {
+					GLfloat d = glm::length(points[indices ? (*indices)[i] : i] - p);
+					if (d <= distance) {
+						distance = d;
+						nearest = i;
+						found = true;
+					}
+				}
+			}
+		}
+	}
+	return found;
+}
+
+// Nearest point of the piece within tolerance of p
+static bool NearestPoint(const Piece& piece, const vector<glm::vec3>& points, const glm::vec3& p, GLfloat tolerance, GLuint& nearest, GLfloat& distance)
+{
+	return NearestInGrid(piece.grid, &piece.points, points, p, tolerance, nearest, distance);
+}
+
+// Rotation placing the prototype piece onto another piece, and the largest point distance it leaves
+static bool MatchPiece(const Piece& prototype, const Piece& piece, const vector<glm::vec3>& points, GLfloat tolerance, glm::mat3& rotation, GLfloat& error)
+{
+	if (prototype.points.size() != piece.points.size() || prototype.triangles.size() != piece.triangles.size())
+		return false;
+
+	// Plain translation first, it is the common case and exact
+	vector<glm::mat3> rotations(1, glm::mat3(1.0f));
+	if (!prototype.frames.empty())
+		for (const glm::mat3& frame : piece.frames)
+			rotations.push_back(frame * glm::transpose(prototype.frames[0]));
+
+	vector<GLuint> mapped(prototype.points.size());
+	vector<bool> used(piece.points.size());
+	vector<Triangle> shape(prototype.shape.size());
+	for (const glm::mat3& r : rotations) {
+		bool matched = true;
+		GLfloat worst = 0.0f;
+		fill(used.begin(), used.end(), false);
+		for (size_t i = 0; i < prototype.points.size() && matched; ++i) {
+			glm::vec3 p = piece.centroid + r * (points[prototype.points[i]] - prototype.centroid);
+			GLfloat distance;
+			matched = NearestPoint(piece, points, p, tolerance, mapped[i], distance) && !used[mapped[i]];
+			if (matched) {
+				used[mapped[i]] = true;
+				worst = max(worst, distance);
+			}
+		}
+		if (!matched)
+			continue;
+
+		// Same points, now the same triangles between them
+		for (size_t t = 0; t < prototype.triangles.size(); ++t)
+			shape[t] = SortedTriangle(mapped[prototype.corners[t * 3]], mapped[prototype.corners[t * 3 + 1]], mapped[prototype.corners[t * 3 + 2]]);
+		sort(shape.begin(), shape.end());
+		if (shape != piece.shape)
+			continue;
+
+		rotation = r;
+		error = worst;
+		return true;
+	}
+	return false;
+}
+
+// Vertices and indices of a piece, moved so its centroid is the origin
+static MeshData PieceMesh(const MeshData& data, const Piece& piece)
+{
+	MeshData mesh;
+	mesh.stride = data.stride;
+	map<GLuint, GLuint> remap;
+	for (GLuint t : piece.triangles) {
+		for (int c = 0; c < 3; ++c) {
+			GLuint vertex = data.indices[t * 3 + c];
+			auto it = remap.find(vertex);
+			if (it == remap.end()) {
+				it = remap.insert(make_pair(vertex, (GLuint)remap.size())).first;
+				const GLfloat* v = &data.vertices[(size_t)vertex * data.stride];
+				mesh.vertices.insert(mesh.vertices.end(), v, v + data.stride);
+				for (int k = 0; k < 3; ++k)
+					mesh.vertices[mesh.vertices.size() - data.stride + k] -= piece.centroid[k];
+			}
+			mesh.indices.push_back(it->second);
+		}
+	}
+	return mesh;
+}
+
+static size_t MeshBytes(const MeshData& data)
+{
+	return data.vertices.size() * sizeof(GLfloat) + data.indices.size() * sizeof(GLuint);
+}
+
+// Split a mesh into pieces, keep one prototype per shape and a placement per piece
+void findRepeatedSubmeshes(const MeshData& data, const InstancingSettings& settings, SubmeshInstancing& result)
+{
+	result = SubmeshInstancing();
+	result.bytesBefore = MeshBytes(data);
+	size_t vertexCount = data.vertices.size() / data.stride;
+	size_t indexCount = data.lods.empty() ? data.indices.size() : data.lods[0].indexCount;	// Full detail only
+	if (vertexCount == 0 || indexCount < 3)
+		return;
+
+	/* Weld positions within the tolerance */
+	glm::vec3 low(data.vertices[0], data.vertices[1], data.vertices[2]), high = low;
+	for (size_t v = 0; v < vertexCount; ++v) {
+		glm::vec3 p(data.vertices[v * data.stride], data.vertices[v * data.stride + 1], data.vertices[v * data.stride + 2]);
+		low = glm::min(low, p);
+		high = glm::max(high, p);
+	}
+	GLfloat tolerance = max(settings.tolerance * glm::length(high - low), MIN_TOLERANCE);
+
+	// A position joins the nearest earlier point within tolerance, whichever cell that point fell in
+	vector<glm::vec3> points;
+	vector<GLuint> pointOf(vertexCount);
+	map<Cell, vector<GLuint>> welded;
+	for (size_t v = 0; v < vertexCount; ++v) {
+		glm::vec3 p(data.vertices[v * data.stride], data.vertices[v * data.stride + 1], data.vertices[v * data.stride + 2]);
+		GLfloat distance;
+		if (!NearestInGrid(welded, nullptr, points, p, tolerance, pointOf[v], distance)) {
+			pointOf[v] = (GLuint)points.size();
+			welded[CellOf(p, tolerance)].push_back(pointOf[v]);
+			points.push_back(p);
+		}
+	}
+
+	/* Pieces: triangles connected through shared points */
+	vector<GLuint> parent(points.size());
+	iota(parent.begin(), parent.end(), 0);
+	size_t triangleCount = indexCount / 3;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		GLuint a = FindRoot(parent, pointOf[data.indices[t * 3]]);
+		for (int c = 1; c < 3; ++c)
+			parent[FindRoot(parent, pointOf[data.indices[t * 3 + c]])] = a;
+	}
+
+	vector<Piece> pieces;
+	map<GLuint, size_t> pieceOf;
+	for (size_t t = 0; t < triangleCount; ++t) {
+		GLuint root = FindRoot(parent, pointOf[data.indices[t * 3]]);
+		auto it = pieceOf.insert(make_pair(root, pieces.size())).first;
+		if (it->second == pieces.size())
+			pieces.push_back(Piece());
+		pieces[it->second].triangles.push_back((GLuint)t);
+	}
+
+	for (Piece& piece : pieces) {
+		map<GLuint, GLuint> local;
+		for (GLuint t : piece.triangles) {
+			for (int c = 0; c < 3; ++c) {
+				GLuint point = pointOf[data.indices[t * 3 + c]];
+				auto it = local.insert(make_pair(point, (GLuint)piece.points.size())).first;
+				if (it->second == piece.points.size())
+					piece.points.push_back(point);
+				piece.corners.push_back(it->second);
+			}
+		}
+		for (size_t t = 0; t < piece.triangles.size(); ++t)
+			piece.shape.push_back(SortedTriangle(piece.corners[t * 3], piece.corners[t * 3 + 1], piece.corners[t * 3 + 2]));
+		sort(piece.shape.begin(), piece.shape.end());
+
+		piece.centroid = glm::vec3(0.0f);
+		for (GLuint point : piece.points)
+			piece.centroid += points[point];
+		piece.centroid /= (float)piece.points.size();
+
+		vector<glm::vec3> offsets;
+		for (GLuint i = 0; i < piece.points.size(); ++i) {
+			offsets.push_back(points[piece.points[i]] - piece.centroid);
+			piece.distances.push_back(glm::length(offsets.back()));
+			piece.grid[CellOf(points[piece.points[i]], tolerance)].push_back(i);
+		}
+		sort(piece.distances.begin(), piece.distances.end());
+		CanonicalFrames(piece, offsets);
+	}
+
+	/* Every piece becomes an instance of the first earlier piece it matches, or a new prototype */
+	// Matching pieces have radii within tolerance, so the neighbouring radius buckets are searched too
+	GLfloat radiusCell = tolerance * SIGNATURE_CELL;
+	map<BucketKey, vector<int>> prototypesByBucket;
+	vector<size_t> prototypePieces;
+	vector<int> candidates;
+	for (size_t i = 0; i < pieces.size(); ++i) {
+		const Piece& piece = pieces[i];
+		SubmeshInstance instance;
+		instance.position = piece.centroid;
+		instance.prototype = -1;
+
+		long long radius = (long long)floor(piece.distances.back() / radiusCell);
+		candidates.clear();
+		for (long long r = radius - 1; r <= radius + 1; ++r) {
+			auto bucket = prototypesByBucket.find(BucketOf(piece, r));
+			if (bucket != prototypesByBucket.end())
+				candidates.insert(candidates.end(), bucket->second.begin(), bucket->second.end());
+		}
+		sort(candidates.begin(), candidates.end());
+
+		for (int prototype : candidates) {
+			const Piece& candidate = pieces[prototypePieces[prototype]];
+			glm::mat3 rotation;
+			GLfloat error;
+			if (SameDistances(candidate, piece, tolerance) && MatchPiece(candidate, piece, points, tolerance, rotation, error)) {
+				instance.prototype = prototype;
+				instance.rotation = glm::normalize(glm::quat_cast(rotation));
+				result.maxError = max(result.maxError, error);
+				break;
+			}
+		}
+		if (instance.prototype < 0) {
+			instance.prototype = (int)prototypePieces.size();
+			prototypesByBucket[BucketOf(piece, radius)].push_back(instance.prototype);
+			prototypePieces.push_back(i);
+			result.prototypes.push_back(PieceMesh(data, piece));
+		}
+		result.instances.push_back(instance);
+	}
+
+	result.bytesAfter = result.instances.size() * 10 * sizeof(float);	// A TransformSoA entry per instance
+	for (const MeshData& prototype : result.prototypes)
+		result.bytesAfter += MeshBytes(prototype);
+}
+
+// Placements of one prototype as an instance list
+void submeshTransforms(const SubmeshInstancing& result, int prototype, TransformSoA& transforms)
+{
+	for (const SubmeshInstance& instance : result.instances)
+		if (instance.prototype == prototype)
+			addTransform(transforms, instance.position, instance.rotation, glm::vec3(1.0f));
+}
+
+// Pieces, shapes and memory before and after instancing
+void printInstancingReport(const char* name, const SubmeshInstancing& result)
+{
+	double saved = result.bytesBefore ? 100.0 * (1.0 - (double)result.bytesAfter / (double)result.bytesBefore) : 0.0;
+	cout << name << ": " << result.instances.size() << " pieces, " << result.prototypes.size() << " shapes, "
+		<< result.bytesBefore << " -> " << result.bytesAfter << " bytes (" << saved << "% saved), max error " << result.maxError << endl;
+
+	vector<int> uses(result.prototypes.size(), 0);
+	for (const SubmeshInstance& instance : result.instances)
+		++uses[instance.prototype];
+	for (size_t k = 0; k < result.prototypes.size(); ++k) {
+		if (uses[k] > 1)
+			cout << "\tshape " << k << ": " << uses[k] << " instances of " << result.prototypes[k].indices.size() / 3 << " triangles" << endl;
+	}
+}
@@ -0,0 +1,60 @@
+/* Description:
+Finds repeated sub-meshes: the connected pieces of a mesh
+(comb dividers, bolts and slats of an imported assembly) that
+are the same geometry under a rigid transform, and turns
+them into one shared mesh per shape plus a list of
+placements, so each shape is stored once and drawn
+instanced.
+
+Pieces are split by positions welded within the
+tolerance, then bucketed by what does not change under
+rotation or translation: point and triangle counts and a
+coarse farthest distance from the centroid, with the
+neighbouring distance buckets searched too. Within them,
+the sorted distances from the centroid must agree within
+the tolerance, and then a piece matches a
+prototype if some rotation maps every prototype point onto
+one of its points within the tolerance and the triangles
+agree. Rotations tried: none, then the principal axes of
+both pieces with every sign; where two axes have the same
+spread (a square bar), the farthest points fix the
+rotation instead. Mirror images are not matched.
+
+Only positions are compared. Instances draw with the
+prototype's colors and texture coordinates, and their
+normals rotate with the placement.
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+#include "Mesh.h"
+#include "TransformKernel.h"
+
+/* Matching settings */
+struct InstancingSettings {
+	GLfloat tolerance = 1.0e-4f;	// Largest point distance of a match, relative to the mesh's bounds diagonal
+};
+
+/* Placement of one sub-mesh */
+struct SubmeshInstance {
+	int prototype = 0;
+	glm::vec3 position = glm::vec3(0.0f);	// Where the prototype's origin goes (the piece's centroid)
+	glm::quat rotation;
+};
+
+/* Mesh split into shared sub-meshes and their placements */
+struct SubmeshInstancing {
+	std::vector<MeshData> prototypes;			// Centered on the centroid of their first piece
+	std::vector<SubmeshInstance> instances;		// One per piece of the input
+	size_t bytesBefore = 0;		// Vertex and index arrays of the input
+	size_t bytesAfter = 0;		// Prototypes plus a TransformSoA entry per instance
+	GLfloat maxError = 0.0f;	// Largest distance between a placed prototype point and the point it replaces
+};
+
+/* Mesh instancing prototypes */
+void findRepeatedSubmeshes(const MeshData& data, const InstancingSettings& settings, SubmeshInstancing& result);
+void submeshTransforms(const SubmeshInstancing& result, int prototype, TransformSoA& transforms);
+void printInstancingReport(const char* name, const SubmeshInstancing& result);
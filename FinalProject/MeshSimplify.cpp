@@ -0,0 +1,337 @@
+#include "MeshSimplify.h"
+
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <queue>
+#include <algorithm>
+
+using namespace std;
+
+/* Constants */
+const size_t MIN_LOD_TRIANGLES = 4;		// Stop the chain before a level gets this small
+const GLfloat LOD_REDUCTION = 0.5f;		// Triangle budget of each level relative to the previous
+const GLfloat MIN_LOD_PROGRESS = 0.75f;	// A level keeping more than this of the previous one is not worth storing
+
+/* Symmetric 4x4 matrix of plane equations, upper triangle only */
+struct Quadric {
+	double a[10] = {};
+};
+
+/* Edge collapse waiting in the queue, stale once either vertex changed */
+struct Collapse {
+	double cost;
+	GLuint from;
+	GLuint to;
+	unsigned int fromVersion;
+	unsigned int toVersion;
+};
+
+struct CollapseOrder {
+	bool operator()(const Collapse& a, const Collapse& b) const { return a.cost > b.cost; }
+};
+
+// Quadric of the plane n.p + d = 0 (n normalized)
+static Quadric PlaneQuadric(const glm::vec3& n, GLfloat d)
+{
+	double p[4] = { n.x, n.y, n.z, d };
+	Quadric q;
+	int k = 0;
+	for (int i = 0; i < 4; ++i)
+		for (int j = i; j < 4; ++j)
+			q.a[k++] = p[i] * p[j];
+	return q;
+}
+
+static void AddQuadric(Quadric& q, const Quadric& other)
+{
+	for (int i = 0; i < 10; ++i)
+		q.a[i] += other.a[i];
+}
+
+// Sum of squared distances from p to the quadric's planes
+static double QuadricError(const Quadric& q, const glm::vec3& p)
+{
+	double x = p.x, y = p.y, z = p.z;
+	return q.a[0] * x * x + 2.0 * q.a[1] * x * y + 2.0 * q.a[2] * x * z + 2.0 * q.a[3] * x
+		+ q.a[4] * y * y + 2.0 * q.a[5] * y * z + 2.0 * q.a[6] * y
+		+ q.a[7] * z * z + 2.0 * q.a[8] * z
+		+ q.a[9];
+}
+
+/* Working state of one simplification */
+struct Simplifier {
+	vector<GLuint> group;				// Vertex -> welded position
+	vector<glm::vec3> positions;		// Per welded position
+	vector<Quadric> quadrics;
+	vector<unsigned int> versions;		// Bumped whenever a position's quadric or neighbourhood changes
+	vector<bool> removed;				// Position was collapsed into another
+	vector<vector<GLuint>> members;		// Vertices per position
+	vector<vector<GLuint>> incident;	// Triangles per position (may include dead ones)
+	vector<GLuint> corners;				// Vertex indices, three per triangle
+	vector<bool> alive;
+	size_t liveTriangles = 0;
+	priority_queue<Collapse, vector<Collapse>, CollapseOrder> queue;
+};
+
+// Unnormalized normal of a triangle, optionally with one position replaced
+static glm::vec3 TriangleNormal(const Simplifier& s, GLuint triangle, GLuint moved, const glm::vec3& position)
+{
+	glm::vec3 p[3];
+	for (int c = 0; c < 3; ++c) {
+		GLuint g = s.group[s.corners[triangle * 3 + c]];
+		p[c] = g == moved ? position : s.positions[g];
+	}
+	return glm::cross(p[1] - p[0], p[2] - p[0]);
+}
+
+// Queue both directions of every edge around a position
+static void QueueEdges(Simplifier& s, GLuint g)
+{
+	for (GLuint t : s.incident[g]) {
+		if (!s.alive[t])
+			continue;
+
+		for (int c = 0; c < 3; ++c) {
+			GLuint other = s.group[s.corners[t * 3 + c]];
+			if (other == g)
+				continue;
+
+			Quadric q = s.quadrics[g];
+			AddQuadric(q, s.quadrics[other]);
+			s.queue.push({ QuadricError(q, s.positions[other]), g, other, s.versions[g], s.versions[other] });
+			s.queue.push({ QuadricError(q, s.positions[g]), other, g, s.versions[other], s.versions[g] });
+		}
+	}
+}
+
+// Moving from onto to would turn a surviving triangle over
+static bool CollapseFlips(const Simplifier& s, GLuint from, GLuint to)
+{
+	for (GLuint t : s.incident[from]) {
+		if (!s.alive[t])
+			continue;
+
+		// Triangles on the collapsed edge disappear
+		bool onEdge = false;
+		for (int c = 0; c < 3; ++c)
+			onEdge |= s.group[s.corners[t * 3 + c]] == to;
+		if (onEdge)
+			continue;
+
+		glm::vec3 before = TriangleNormal(s, t, from, s.positions[from]);
+		glm::vec3 after = TriangleNormal(s, t, from, s.positions[to]);
+		if (glm::dot(before, after) <= 0.0f)
+			return true;
+	}
+	return false;
+}
+
+// Move every vertex at from onto to, dropping the triangles that become degenerate
+static void ApplyCollapse(Simplifier& s, GLuint from, GLuint to)
+{
+	for (GLuint t : s.incident[from]) {
+		if (!s.alive[t])
+			continue;
+
+		bool onEdge = false;
+		for (int c = 0; c < 3; ++c)
+			onEdge |= s.group[s.corners[t * 3 + c]] == to;
+
+		if (onEdge) {
+			s.alive[t] = false;
+			s.liveTriangles--;
+		}
+		else {
+			s.incident[to].push_back(t);
+		}
+	}
+
+	// Vertices keep their attributes, only their position changes
+	for (GLuint v : s.members[from]) {
+		s.group[v] = to;
+		s.members[to].push_back(v);
+	}
+
+	AddQuadric(s.quadrics[to], s.quadrics[from]);
+	s.members[from].clear();
+	s.incident[from].clear();
+	s.removed[from] = true;
+	s.versions[from]++;
+	s.versions[to]++;
+}
+
+// Collapse edges, cheapest first, until at most targetTriangles remain; error is the object-space deviation bound
+MeshData simplifyMesh(const MeshData& data, size_t targetTriangles, GLfloat& error)
+{
+	Simplifier s;
+	size_t vertexCount = data.vertices.size() / data.stride;
+	size_t triangleCount = data.indices.size() / 3;
+	error = 0.0f;
+
+	// Weld vertices by position
+	map<tuple<GLfloat, GLfloat, GLfloat>, GLuint> welded;
+	s.group.resize(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v) {
+		const GLfloat* p = &data.vertices[v * data.stride];
+		auto found = welded.insert(make_pair(make_tuple(p[0], p[1], p[2]), (GLuint)s.positions.size()));
+		if (found.second)
+			s.positions.push_back(glm::vec3(p[0], p[1], p[2]));
+		s.group[v] = found.first->second;
+	}
+
+	size_t groupCount = s.positions.size();
+	s.quadrics.resize(groupCount);
+	s.versions.assign(groupCount, 0);
+	s.removed.assign(groupCount, false);
+	s.members.resize(groupCount);
+	s.incident.resize(groupCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+		s.members[s.group[v]].push_back((GLuint)v);
+
+	s.corners.assign(data.indices.begin(), data.indices.begin() + triangleCount * 3);
+	s.alive.assign(triangleCount, true);
+
+	// Plane of every triangle, and how many triangles use each edge
+	map<pair<GLuint, GLuint>, int> edgeUse;
+	vector<glm::vec3> normals(triangleCount);
+	for (GLuint t = 0; t < triangleCount; ++t) {
+		glm::vec3 n = TriangleNormal(s, t, (GLuint)-1, glm::vec3(0.0f));
+		GLfloat length = glm::length(n);
+		if (length <= 0.0f) {
+			s.alive[t] = false;
+			continue;
+		}
+
+		n /= length;
+		normals[t] = n;
+		s.liveTriangles++;
+
+		GLuint g[3] = { s.group[s.corners[t * 3]], s.group[s.corners[t * 3 + 1]], s.group[s.corners[t * 3 + 2]] };
+		Quadric plane = PlaneQuadric(n, -glm::dot(n, s.positions[g[0]]));
+		for (int c = 0; c < 3; ++c) {
+			AddQuadric(s.quadrics[g[c]], plane);
+			s.incident[g[c]].push_back(t);
+			edgeUse[make_pair(min(g[c], g[(c + 1) % 3]), max(g[c], g[(c + 1) % 3]))]++;
+		}
+	}
+
+	// Border edges: a plane through the edge, perpendicular to its triangle, keeps the outline in place
+	for (GLuint t = 0; t < triangleCount; ++t) {
+		if (!s.alive[t])
+			continue;
+
+		for (int c = 0; c < 3; ++c) {
+			GLuint a = s.group[s.corners[t * 3 + c]];
+			GLuint b = s.group[s.corners[t * 3 + (c + 1) % 3]];
+			if (edgeUse[make_pair(min(a, b), max(a, b))] != 1)
+				continue;
+
+			glm::vec3 n = glm::cross(s.positions[b] - s.positions[a], normals[t]);
+			GLfloat length = glm::length(n);
+			if (length <= 0.0f)
+				continue;
+
+			n /= length;
+			Quadric plane = PlaneQuadric(n, -glm::dot(n, s.positions[a]));
+			AddQuadric(s.quadrics[a], plane);
+			AddQuadric(s.quadrics[b], plane);
+		}
+	}
+
+	for (GLuint g = 0; g < groupCount; ++g)
+		QueueEdges(s, g);
+
+	// Greedy collapse, entries made stale by earlier collapses are skipped
+	double worst = 0.0;
+	while (s.liveTriangles > targetTriangles && !s.queue.empty()) {
+		Collapse collapse = s.queue.top();
+		s.queue.pop();
+
+		if (s.removed[collapse.from] || s.removed[collapse.to] ||
+			collapse.fromVersion != s.versions[collapse.from] || collapse.toVersion != s.versions[collapse.to])
+			continue;
+		if (CollapseFlips(s, collapse.from, collapse.to))
+			continue;
+
+		ApplyCollapse(s, collapse.from, collapse.to);
+		worst = max(worst, collapse.cost);
+		QueueEdges(s, collapse.to);
+	}
+
+	// Distances to several planes add up, so the root of the summed squares bounds the distance to each
+	error = (GLfloat)sqrt(max(worst, 0.0));
+
+	// Copy the surviving triangles, vertices at their (possibly moved) positions
+	MeshData result;
+	result.stride = data.stride;
+	vector<GLuint> remap(vertexCount, (GLuint)-1);
+	for (GLuint t = 0; t < triangleCount; ++t) {
+		if (!s.alive[t])
+			continue;
+
+		for (int c = 0; c < 3; ++c) {
+			GLuint v = s.corners[t * 3 + c];
+			if (remap[v] == (GLuint)-1) {
+				remap[v] = (GLuint)(result.vertices.size() / data.stride);
+				const GLfloat* source = &data.vertices[v * data.stride];
+				result.vertices.insert(result.vertices.end(), source, source + data.stride);
+
+				const glm::vec3& p = s.positions[s.group[v]];
+				GLfloat* moved = &result.vertices[remap[v] * data.stride];
+				moved[0] = p.x;
+				moved[1] = p.y;
+				moved[2] = p.z;
+			}
+			result.indices.push_back(remap[v]);
+		}
+	}
+
+	return result;
+}
+
+// Append simplified levels to the mesh's arrays, each about half the triangles of the one before
+void buildLodChain(MeshData& data)
+{
+	MeshData source = data;
+	source.lods.clear();
+
+	data.lods.clear();
+	MeshLod full;
+	full.indexCount = (GLsizei)data.indices.size();
+	data.lods.push_back(full);
+
+	size_t previous = data.indices.size() / 3;
+	GLfloat previousError = 0.0f;
+	while (data.lods.size() < (size_t)MAX_MESH_LODS) {
+		size_t target = (size_t)(previous * LOD_REDUCTION);
+		if (target < MIN_LOD_TRIANGLES)
+			break;
+
+		// Simplified from full detail so the error is measured against it
+		GLfloat error;
+		MeshData level = simplifyMesh(source, target, error);
+		size_t triangles = level.indices.size() / 3;
+		if (triangles == 0 || triangles > previous * MIN_LOD_PROGRESS)
+			break;
+
+		// Same buffers, indices shifted past the vertices already there
+		GLuint baseVertex = (GLuint)(data.vertices.size() / data.stride);
+		MeshLod lod;
+		lod.firstIndex = (GLuint)data.indices.size();
+		lod.indexCount = (GLsizei)level.indices.size();
+		lod.error = max(error, previousError);
+
+		data.vertices.insert(data.vertices.end(), level.vertices.begin(), level.vertices.end());
+		for (GLuint index : level.indices)
+			data.indices.push_back(index + baseVertex);
+		data.lods.push_back(lod);
+
+		previous = triangles;
+		previousError = lod.error;
+	}
+
+	// Nothing simplified, keep the plain single level layout
+	if (data.lods.size() == 1)
+		data.lods.clear();
+}
@@ -0,0 +1,25 @@
+/* Description:
+Mesh simplification with quadric error metrics (Garland and
+Heckbert). Every vertex accumulates the planes of the
+triangles around it; collapsing an edge moves one vertex
+onto the other and costs the summed squared distance of the
+new position to both sets of planes. The cheapest collapses
+are applied first until the triangle budget is met.
+
+Vertices sharing a position (texture or normal seams) are
+collapsed together so no cracks open, and each keeps its
+own attributes. Open borders get extra planes perpendicular
+to the surface so outlines keep their shape. Collapses that
+would flip a triangle are rejected.
+
+buildLodChain() turns mesh data into a chain of levels of
+detail stored in the same arrays (see MeshLod in Mesh.h).
+It runs once when a mesh is loaded, not per frame.
+*/
+#pragma once
+
+#include "Mesh.h"
+
+/* Mesh simplification prototypes */
+MeshData simplifyMesh(const MeshData& data, size_t targetTriangles, GLfloat& error);
+void buildLodChain(MeshData& data);
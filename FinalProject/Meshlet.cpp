@@ -0,0 +1,260 @@
+#include "Meshlet.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLState.h"
+#include "FrameStats.h"
+
+using namespace std;
+
+/* Constants */
+const GLuint CULL_GROUP_SIZE = 64;			// local_size_x of meshlet_cull.comp
+const GLfloat MIN_CONE_SPREAD = 0.1f;		// Meshlets whose normals spread wider than this (dot with the axis) get no cone
+const GLfloat NO_CONE = 2.0f;				// Cutoff that never culls
+
+/* Layout of glMultiDrawElementsIndirect commands */
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLuint baseVertex;
+	GLuint baseInstance;
+};
+
+/* Module state */
+static bool supported = false;
+static ShaderProgram* cullProgram = nullptr;
+
+// Position of a vertex
+static glm::vec3 VertexPosition(const MeshData& data, GLuint vertex)
+{
+	const GLfloat* p = &data.vertices[vertex * data.stride];
+	return glm::vec3(p[0], p[1], p[2]);
+}
+
+// Append a meshlet of the given triangles: their indices, bounding sphere and normal cone
+static void FinishMeshlet(const MeshData& data, const vector<GLuint>& triangles, vector<GLuint>& ordered, vector<Meshlet>& meshlets)
+{
+	if (triangles.empty())
+		return;
+
+	Meshlet meshlet = {};
+	meshlet.firstIndex = (GLuint)ordered.size();
+	meshlet.indexCount = (GLuint)triangles.size() * 3;
+
+	glm::vec3 low = VertexPosition(data, data.indices[triangles[0] * 3]);
+	glm::vec3 high = low;
+	glm::vec3 normalSum(0.0f);
+	vector<glm::vec3> normals;
+	for (GLuint t : triangles) {
+		glm::vec3 p[3];
+		for (int c = 0; c < 3; ++c) {
+			GLuint vertex = data.indices[t * 3 + c];
+			ordered.push_back(vertex);
+			p[c] = VertexPosition(data, vertex);
+			low = glm::min(low, p[c]);
+			high = glm::max(high, p[c]);
+		}
+
+		// Front faces are counter-clockwise, the normal follows the winding
+		glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+		GLfloat length = glm::length(n);
+		if (length <= 0.0f)
+			continue;
+		n /= length;
+		normals.push_back(n);
+		normalSum += n;
+	}
+
+	glm::vec3 center = (low + high) * 0.5f;
+	GLfloat radius = 0.0f;
+	for (GLuint i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; ++i)
+		radius = max(radius, glm::length(VertexPosition(data, ordered[i]) - center));
+
+	// Cone around the average normal, cutoff is the sine of its widest angle to any normal
+	meshlet.coneCutoff = NO_CONE;
+	GLfloat sumLength = glm::length(normalSum);
+	if (sumLength > 0.0f) {
+		glm::vec3 axis = normalSum / sumLength;
+		GLfloat minDot = 1.0f;
+		for (const glm::vec3& n : normals)
+			minDot = min(minDot, glm::dot(axis, n));
+
+		meshlet.coneAxis[0] = axis.x;
+		meshlet.coneAxis[1] = axis.y;
+		meshlet.coneAxis[2] = axis.z;
+		if (minDot > MIN_CONE_SPREAD)
+			meshlet.coneCutoff = sqrt(1.0f - minDot * minDot);
+	}
+
+	meshlet.center[0] = center.x;
+	meshlet.center[1] = center.y;
+	meshlet.center[2] = center.z;
+	meshlet.radius = radius;
+	meshlets.push_back(meshlet);
+}
+
+// Split the triangles into meshlets, reordering the index array so every meshlet's triangles are contiguous
+void buildMeshlets(MeshData& data, vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+	size_t triangleCount = data.indices.size() / 3;
+
+	// Scan in index order, triangles join the current meshlet until its vertex or triangle budget runs out
+	vector<GLuint> ordered;
+	ordered.reserve(data.indices.size());
+	vector<GLuint> triangles;
+	vector<GLuint> vertices;
+	for (GLuint t = 0; t < triangleCount; ++t) {
+		GLuint added[3];
+		int addedCount = 0;
+		for (int c = 0; c < 3; ++c) {
+			GLuint vertex = data.indices[t * 3 + c];
+			if (find(vertices.begin(), vertices.end(), vertex) == vertices.end() && find(added, added + addedCount, vertex) == added + addedCount)
+				added[addedCount++] = vertex;
+		}
+
+		if (vertices.size() + addedCount > (size_t)MESHLET_MAX_VERTICES || triangles.size() == (size_t)MESHLET_MAX_TRIANGLES) {
+			FinishMeshlet(data, triangles, ordered, meshlets);
+			triangles.clear();
+			vertices.clear();
+			for (int c = 0; c < 3; ++c) {
+				GLuint vertex = data.indices[t * 3 + c];
+				if (find(vertices.begin(), vertices.end(), vertex) == vertices.end())
+					vertices.push_back(vertex);
+			}
+		}
+		else {
+			vertices.insert(vertices.end(), added, added + addedCount);
+		}
+		triangles.push_back(t);
+	}
+	FinishMeshlet(data, triangles, ordered, meshlets);
+
+	// Same triangles in meshlet order
+	copy(ordered.begin(), ordered.end(), data.indices.begin());
+}
+
+// Load the culling shader, false if the driver cannot run it
+bool initMeshletCulling()
+{
+	supported = GLEW_VERSION_4_3 != 0;
+	if (!supported) {
+		cout << "Meshlet culling needs OpenGL 4.3, meshes are drawn whole" << endl;
+		return false;
+	}
+
+	ShaderStage compute;
+	compute.type = GL_COMPUTE_SHADER;
+	compute.path = "shaders/meshlet_cull.comp";
+	cullProgram = loadShaderProgram({ compute });
+	return true;
+}
+
+// Culling shader is linked
+bool meshletCullingReady()
+{
+	return supported && cullProgram->program != 0;
+}
+
+// Upload the meshlets and build the vertex array that draws the compacted indices with per-instance transforms
+void createMeshletMesh(MeshletMesh& meshletMesh, const Mesh& mesh, const vector<Meshlet>& meshlets, GLuint transforms)
+{
+	meshletMesh.meshletCount = (GLuint)meshlets.size();
+	meshletMesh.indexCount = (GLuint)mesh.lods[0].indexCount;
+	meshletMesh.sourceIndices = mesh.ebo;
+
+	glGenBuffers(1, &meshletMesh.meshlets);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletMesh.meshlets);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, meshlets.size() * sizeof(Meshlet), meshlets.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// Output buffers are sized on first use
+	glGenBuffers(1, &meshletMesh.visibleIndices);
+	glGenBuffers(1, &meshletMesh.commands);
+
+	glGenVertexArrays(1, &meshletMesh.vao);
+	glBindVertexArray(meshletMesh.vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+	setVertexLayout(mesh.stride);
+
+	// Model matrix in locations 4-7, normal matrix columns in 8-10, advanced once per draw command
+	glBindBuffer(GL_ARRAY_BUFFER, transforms);
+	for (int i = 0; i < 7; ++i) {
+		glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(MeshletTransform), (GLvoid*)(i * 4 * sizeof(GLfloat)));
+		glVertexAttribDivisor(4 + i, 1);
+		glEnableVertexAttribArray(4 + i);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshletMesh.visibleIndices);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Cull every meshlet of every instance and write the compacted indices and draw commands
+void cullMeshlets(MeshletMesh& meshletMesh, GLuint transforms, size_t transformCount, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos)
+{
+	if (transformCount == 0 || transformCount > MESHLET_MAX_INSTANCES)
+		return;
+
+	// Room for every index of every instance
+	if (transformCount > meshletMesh.capacity) {
+		meshletMesh.capacity = transformCount;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletMesh.visibleIndices);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, transformCount * meshletMesh.indexCount * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletMesh.commands);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, transformCount * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	glm::vec4 planes[6];
+	frustumPlanes(projection * view, planes);
+
+	GLuint program = cullProgram->program;
+	glm::vec3 forward(-view[0][2], -view[1][2], -view[2][2]);
+	stateUseProgram(program);
+	glUniform1ui(glGetUniformLocation(program, "meshletCount"), meshletMesh.meshletCount);
+	glUniform1ui(glGetUniformLocation(program, "indexStride"), meshletMesh.indexCount);
+	glUniform4fv(glGetUniformLocation(program, "frustumPlanes"), 6, glm::value_ptr(planes[0]));
+	glUniform3f(glGetUniformLocation(program, "viewPos"), viewPos.x, viewPos.y, viewPos.z);
+	glUniform3f(glGetUniformLocation(program, "viewForward"), forward.x, forward.y, forward.z);
+	glUniform1i(glGetUniformLocation(program, "orthographic"), projection[2][3] == 0.0f);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, meshletMesh.meshlets);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, meshletMesh.sourceIndices);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, transforms);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, meshletMesh.visibleIndices);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, meshletMesh.commands);
+
+	// One work group per instance, its threads share the meshlets
+	glDispatchCompute((GLuint)transformCount, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+}
+
+// Draw what the culling pass kept, the program and texture must be bound
+void drawMeshlets(const MeshletMesh& meshletMesh, size_t transformCount)
+{
+	if (transformCount == 0 || transformCount > MESHLET_MAX_INSTANCES)
+		return;
+
+	stateBindVertexArray(meshletMesh.vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, meshletMesh.commands);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)transformCount, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	frameStats.drawCalls++;
+}
+
+// Release the meshlet buffers (the source index buffer belongs to the mesh)
+void deleteMeshletMesh(MeshletMesh& meshletMesh)
+{
+	glDeleteBuffers(1, &meshletMesh.meshlets);
+	glDeleteBuffers(1, &meshletMesh.visibleIndices);
+	glDeleteBuffers(1, &meshletMesh.commands);
+	glDeleteVertexArrays(1, &meshletMesh.vao);
+	meshletMesh = MeshletMesh();
+}
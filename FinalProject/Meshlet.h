@@ -0,0 +1,74 @@
+/* Description:
+Meshlet culling. Meshes are split into small clusters of
+triangles (meshlets), each with a bounding sphere and a cone
+bounding its triangle normals. Every frame a compute pass
+tests every meshlet of every instance against the view
+frustum and the normal cone (all triangles facing away from
+the camera), copies the indices of the survivors into a
+compacted index buffer and writes one indirect draw command
+per instance; the mesh is then drawn with a single
+glMultiDrawElementsIndirect call.
+
+Triangle normals come from the winding (counter-clockwise
+front faces, as the generated harmonica parts are built), so
+concave meshes get correct cones. Cone culling assumes
+rotation and uniform scale, other instances are only
+frustum culled.
+
+Needs OpenGL 4.3 (compute shaders, storage buffers and
+multi-draw indirect); without it meshes are drawn whole. So
+are frames with more than MESHLET_MAX_INSTANCES instances,
+the most one dispatch can cull.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Mesh.h"
+#include "DrawList.h"
+#include "ShaderManager.h"
+
+/* Constants */
+const int MESHLET_MAX_VERTICES = 64;
+const int MESHLET_MAX_TRIANGLES = 124;
+const size_t MESHLET_MAX_INSTANCES = 65535;	// Dispatch limit, one work group per instance
+
+/* Cluster bounds, std430 layout of the culling shader */
+struct Meshlet {
+	GLfloat center[3];
+	GLfloat radius;
+	GLfloat coneAxis[3];
+	GLfloat coneCutoff;		// Sine of the cone's half angle, above 1 if it can never be culled
+	GLuint firstIndex;
+	GLuint indexCount;
+	GLuint padding[2];
+};
+
+/* Per-instance transform read by the culling pass and the instanced vertex shader */
+struct MeshletTransform {
+	glm::mat4 model;
+	float normalMatrix[12];		// mat3, each column padded to a vec4
+};
+
+/* GPU buffers of one mesh's meshlets */
+struct MeshletMesh {
+	GLuint meshlets = 0;		// Meshlet array
+	GLuint sourceIndices = 0;	// The mesh's index buffer
+	GLuint visibleIndices = 0;	// Compacted output, indexCount per instance
+	GLuint commands = 0;		// One DrawElementsIndirectCommand per instance
+	GLuint vao = 0;				// Mesh vertices, per-instance transforms, compacted indices
+	GLuint meshletCount = 0;
+	GLuint indexCount = 0;		// Full detail indices of the mesh
+	size_t capacity = 0;		// Instances the output buffers have room for
+};
+
+/* Meshlet prototypes */
+void buildMeshlets(MeshData& data, std::vector<Meshlet>& meshlets);
+bool initMeshletCulling();
+bool meshletCullingReady();
+void createMeshletMesh(MeshletMesh& meshletMesh, const Mesh& mesh, const std::vector<Meshlet>& meshlets, GLuint transforms);
+void cullMeshlets(MeshletMesh& meshletMesh, GLuint transforms, size_t transformCount, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+void drawMeshlets(const MeshletMesh& meshletMesh, size_t transformCount);
+void deleteMeshletMesh(MeshletMesh& meshletMesh);
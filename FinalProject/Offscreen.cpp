@@ -0,0 +1,54 @@
+#include "Offscreen.h"
+
+#include <iostream>
+
+#include "Renderer.h"
+
+using namespace std;
+
+/* Constants */
+const double SHADER_TIMEOUT = 30.0;		// Seconds to wait for the shaders before giving up
+
+// Start the renderer on window's context and bind a width x height target
+bool initOffscreenRenderer(GLFWwindow* window, OffscreenTarget& target, int width, int height)
+{
+	glfwMakeContextCurrent(window);
+	if (glewInit() != GLEW_OK) {
+		cout << "GLEW failed to initalize!" << endl;
+		return false;
+	}
+	if (!initRenderer())
+		return false;
+
+	// Every program is linked before the first frame so all of them take the same path
+	double start = glfwGetTime();
+	while (rendererCompiling() && glfwGetTime() - start < SHADER_TIMEOUT)
+		pollRenderer((GLfloat)glfwGetTime());
+
+	target.width = width;
+	target.height = height;
+	glGenFramebuffers(1, &target.fbo);
+	glGenRenderbuffers(1, &target.color);
+	glGenRenderbuffers(1, &target.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	return true;
+}
+
+// Delete the target and every renderer resource, the context stays current
+void freeOffscreenRenderer(OffscreenTarget& target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &target.fbo);
+	glDeleteRenderbuffers(1, &target.color);
+	glDeleteRenderbuffers(1, &target.depth);
+	target = OffscreenTarget();
+	shutdownRenderer();
+}
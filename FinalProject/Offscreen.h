@@ -0,0 +1,25 @@
+/* Description:
+Renderer without a visible window, for the batch modes
+(thumbnails, the scene sweep). Makes a hidden window's
+context current, creates the renderer, waits for every
+shader program to link so all frames take the same path,
+and draws into a color and depth target of a fixed size
+that is never presented.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <GLFW/glfw3.h>
+
+/* Framebuffer drawn into instead of the window */
+struct OffscreenTarget {
+	GLuint fbo = 0;
+	GLuint color = 0;
+	GLuint depth = 0;
+	int width = 0;
+	int height = 0;
+};
+
+/* Offscreen renderer prototypes */
+bool initOffscreenRenderer(GLFWwindow* window, OffscreenTarget& target, int width, int height);
+void freeOffscreenRenderer(OffscreenTarget& target);
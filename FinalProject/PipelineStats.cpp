@@ -0,0 +1,126 @@
+#include "PipelineStats.h"
+
+#include "FrameArena.h"
+#include "FrameStats.h"
+
+using namespace std;
+
+/* Constants */
+const int STATS_SLOTS = FRAMES_IN_FLIGHT + 1;	// Frames of queries in flight
+
+/* Queries of one frame */
+struct StatsSlot {
+	GLuint queries[STATS_PASS_COUNT] = {};
+	bool used[STATS_PASS_COUNT] = {};	// Pass was measured this frame
+	bool pending = false;				// Results not read yet
+};
+
+/* Module state */
+static StatsSlot slots[STATS_SLOTS];
+static int currentSlot = 0;
+static bool created = false;
+static bool supported = false;
+static bool measuring = false;			// Current frame got a free slot
+static bool passOpen = false;
+static GLuint64 latest[STATS_PASS_COUNT] = {};	// Newest invocation counts read
+
+// Read a slot's results if they are all available
+static bool ReadSlot(StatsSlot& slot)
+{
+	if (!slot.pending)
+		return true;
+
+	for (int pass = 0; pass < STATS_PASS_COUNT; ++pass) {
+		GLint available = GL_TRUE;
+		if (slot.used[pass])
+			glGetQueryObjectiv(slot.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+	}
+
+	for (int pass = 0; pass < STATS_PASS_COUNT; ++pass) {
+		latest[pass] = 0;
+		if (slot.used[pass])
+			glGetQueryObjectui64v(slot.queries[pass], GL_QUERY_RESULT, &latest[pass]);
+	}
+
+	slot.pending = false;
+	return true;
+}
+
+// Pick this frame's query slot, reading every finished one first
+void beginPipelineStatsFrame()
+{
+	if (!created) {
+		supported = GLEW_ARB_pipeline_statistics_query != 0;
+		if (supported)
+			for (StatsSlot& slot : slots)
+				glGenQueries(STATS_PASS_COUNT, slot.queries);
+		created = true;
+	}
+
+	measuring = false;
+	if (!supported)
+		return;
+
+	// Oldest slot first so the newest result wins
+	for (int i = 0; i < STATS_SLOTS; ++i)
+		ReadSlot(slots[(currentSlot + i) % STATS_SLOTS]);
+
+	frameStats.prepassFragments = latest[STATS_PREPASS];
+	frameStats.shadedFragments = latest[STATS_SHADING];
+
+	StatsSlot& slot = slots[currentSlot];
+	measuring = !slot.pending;
+	for (bool& used : slot.used)
+		used = false;
+}
+
+// Count the fragment shader invocations of the draws until endPipelineStatsPass()
+void beginPipelineStatsPass(StatsPass pass)
+{
+	if (!measuring || passOpen)
+		return;
+
+	StatsSlot& slot = slots[currentSlot];
+	glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, slot.queries[pass]);
+	slot.used[pass] = true;
+	passOpen = true;
+}
+
+void endPipelineStatsPass()
+{
+	if (!passOpen)
+		return;
+
+	glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+	passOpen = false;
+}
+
+// Queue the frame's queries for reading
+void endPipelineStatsFrame()
+{
+	if (!measuring)
+		return;
+
+	endPipelineStatsPass();
+	StatsSlot& slot = slots[currentSlot];
+	for (bool used : slot.used)
+		slot.pending |= used;
+	currentSlot = (currentSlot + 1) % STATS_SLOTS;
+	measuring = false;
+}
+
+// Delete the queries, the GL context must still be current
+void freePipelineStats()
+{
+	if (created && supported)
+		for (StatsSlot& slot : slots)
+			glDeleteQueries(STATS_PASS_COUNT, slot.queries);
+
+	for (StatsSlot& slot : slots)
+		slot = StatsSlot();
+	created = false;
+	measuring = false;
+	passOpen = false;
+}
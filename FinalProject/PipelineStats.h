@@ -0,0 +1,29 @@
+/* Description:
+GPU pipeline statistics. The fragment shader invocations of
+each render pass (depth pre-pass, shading) are counted with
+pipeline statistics queries, so the cost of overdraw and the
+saving of a pre-pass can be compared per scene.
+
+Like the frame timings, results are read a few frames late
+and never waited on: a frame whose query slot is still
+busy is simply not measured. The newest results are copied
+into frameStats. Needs ARB_pipeline_statistics_query,
+without it nothing is measured. Render thread only.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+
+/* Passes that are measured */
+enum StatsPass {
+	STATS_PREPASS = 0,		// Depth-only pre-pass
+	STATS_SHADING = 1,		// Everything drawn with the full shaders
+	STATS_PASS_COUNT
+};
+
+/* Pipeline statistics prototypes */
+void beginPipelineStatsFrame();
+void beginPipelineStatsPass(StatsPass pass);
+void endPipelineStatsPass();
+void endPipelineStatsFrame();
+void freePipelineStats();
@@ -0,0 +1,222 @@
+#include "RenderThread.h"
+
+#include <GLEW/glew.h>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+#include <atomic>
+
+#include "Renderer.h"
+#include "FrameTimings.h"
+#include "FrameCapture.h"
+#include "FramePacing.h"
+#include "FrameStats.h"
+
+using namespace std;
+
+/* Constants */
+const double IDLE_POLL_INTERVAL = 0.25;	// Seconds between shader/timer checks while no snapshots arrive
+
+/* Module state */
+static thread renderThread;
+static mutex slotMutex;
+static condition_variable slotReady;		// Render thread waits for a snapshot / main thread for startup
+static condition_variable slotConsumed;		// Main thread waits for the render thread to pick up a snapshot
+
+static FrameSnapshot slots[3];
+static int writeSlot = 0;			// Filled by the main thread
+static int readySlot = 1;			// Latest published snapshot
+static int readSlot = 2;			// Drawn by the render thread
+static bool fresh = false;			// readySlot holds a snapshot the render thread has not taken yet
+static bool quit = false;
+static int startStatus = 0;			// 0 starting, 1 running, -1 failed
+static unsigned long long published = 0;	// Snapshots published so far
+static atomic<bool> redrawRequested{ false };	// Render thread has new content to show (e.g. a reloaded shader)
+
+// Render thread only
+static double latchedInputTime = -1.0;		// Input time of a camera taken from a newer snapshot
+static double presentedInputTime = -1.0;	// Newest input already measured as presented
+static int swapMode = -1;					// Swap mode requested by the last snapshot
+
+// Late latching: take the camera of a snapshot published after the one being drawn
+static bool LatchCamera(CameraSnapshot& camera)
+{
+	lock_guard<mutex> lock(slotMutex);
+	if (!fresh)
+		return false;
+
+	camera = slots[readySlot].camera;
+	latchedInputTime = slots[readySlot].inputTime;
+	return true;
+}
+
+// Render thread: own the context, draw the newest snapshot, repeat
+static void RenderLoop(GLFWwindow* window)
+{
+	/* Make the window's context current */
+	glfwMakeContextCurrent(window);
+
+	// Initialize GLEW
+	bool ok = glewInit() == GLEW_OK;
+	if (!ok)
+		cout << "GLEW failed to initalize!" << endl;
+	else
+		ok = initRenderer();
+
+	{
+		lock_guard<mutex> lock(slotMutex);
+		startStatus = ok ? 1 : -1;
+	}
+	slotReady.notify_all();
+
+	if (!ok) {
+		glfwMakeContextCurrent(nullptr);
+		return;
+	}
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(slotMutex);
+			bool ready = slotReady.wait_for(lock, chrono::duration<double>(IDLE_POLL_INTERVAL), [] { return fresh || quit; });
+			if (quit && !fresh)
+				break;
+
+			// No new frame, keep shader compiles and GPU timers moving while idle
+			if (!ready) {
+				lock.unlock();
+				pollFrameTimings();
+				pollFrameCapture();
+				if (pollRenderer((GLfloat)glfwGetTime()))
+					requestRedraw();
+				continue;
+			}
+
+			swap(readSlot, readySlot);
+			fresh = false;
+		}
+		slotConsumed.notify_all();
+
+		const FrameSnapshot& snapshot = slots[readSlot];
+		double start = glfwGetTime();
+		beginFrameTiming();
+
+		// Swap interval can only be set with the context current
+		if (snapshot.swapMode != swapMode) {
+			swapMode = snapshot.swapMode;
+			SwapMode applied = applySwapMode(snapshot.swapMode);
+			cout << "Vsync: " << swapModeName(applied) << endl;
+		}
+
+		// Renderer wants another frame of the same snapshot (progressive refinement)
+		latchedInputTime = -1.0;
+		if (renderFrame(snapshot, LatchCamera))
+			requestRedraw();
+		stopGpuTiming();
+		if (snapshot.capture)
+			captureFrame(snapshot.frame, snapshot.width, snapshot.height);
+		double submitted = glfwGetTime();
+
+		/* Swap front and back buffers */
+		glfwSwapBuffers(window);
+
+		double swapped = glfwGetTime();
+
+		// Input to present latency, each input is measured the first time it reaches the screen
+		double inputTime = latchedInputTime >= 0.0 ? latchedInputTime : snapshot.inputTime;
+		double latency = -1.0;
+		if (inputTime >= 0.0 && inputTime > presentedInputTime) {
+			latency = swapped - inputTime;
+			presentedInputTime = inputTime;
+			frameStats.inputLatencyMs = (float)(latency * 1000.0);
+			addLatencySample(latency);
+		}
+
+		float scale = frameStats.resolutionScale > 0.0f ? frameStats.resolutionScale : 1.0f;
+		endFrameTiming(snapshot.frame, snapshot.buildMs, (submitted - start) * 1000.0, (swapped - submitted) * 1000.0, latency * 1000.0, scale);
+	}
+
+	closeFrameTimings();
+	closeFrameCapture();
+	shutdownRenderer();
+	glfwMakeContextCurrent(nullptr);
+}
+
+// Start the render thread, false if the renderer failed to initialize
+bool startRenderThread(GLFWwindow* window)
+{
+	quit = false;
+	fresh = false;
+	startStatus = 0;
+
+	// Context may only be current on one thread
+	glfwMakeContextCurrent(nullptr);
+	renderThread = thread(RenderLoop, window);
+
+	unique_lock<mutex> lock(slotMutex);
+	slotReady.wait(lock, [] { return startStatus != 0; });
+	if (startStatus > 0)
+		return true;
+
+	lock.unlock();
+	renderThread.join();
+	return false;
+}
+
+// Snapshot for the main thread to fill, private until published
+FrameSnapshot& beginSnapshot()
+{
+	return slots[writeSlot];
+}
+
+// Hand the filled snapshot to the render thread, replacing one it has not taken yet
+void publishSnapshot()
+{
+	{
+		lock_guard<mutex> lock(slotMutex);
+		slots[writeSlot].frame = ++published;
+		swap(writeSlot, readySlot);
+		fresh = true;
+	}
+	slotReady.notify_one();
+}
+
+// Wait (at most timeout seconds, no limit if negative) until the render thread has taken the last published snapshot
+bool waitSnapshotConsumed(double timeout)
+{
+	unique_lock<mutex> lock(slotMutex);
+	if (timeout < 0.0) {
+		slotConsumed.wait(lock, [] { return !fresh; });
+		return true;
+	}
+	return slotConsumed.wait_for(lock, chrono::duration<double>(timeout), [] { return !fresh; });
+}
+
+// Ask the main thread for a new frame, wakes it if it is waiting for events (any thread)
+void requestRedraw()
+{
+	redrawRequested.store(true);
+	glfwPostEmptyEvent();
+}
+
+// True (once) if a redraw was requested since the last call
+bool consumeRedrawRequest()
+{
+	return redrawRequested.exchange(false);
+}
+
+// Stop the render thread after it has drawn the last published snapshot and release the GL resources
+void stopRenderThread()
+{
+	if (!renderThread.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(slotMutex);
+		quit = true;
+	}
+	slotReady.notify_all();
+	renderThread.join();
+}
@@ -0,0 +1,28 @@
+/* Description:
+Runs the renderer on its own thread. The main thread owns the
+window and handles events and simulation; each frame it fills
+a snapshot and publishes it, the render thread draws the most
+recent published snapshot and swaps buffers.
+
+Snapshots live in three slots (being written, ready, being
+drawn) so neither side ever waits for the other to finish a
+frame: when the main thread runs ahead, unread snapshots are
+replaced by newer ones; when the renderer runs ahead it waits
+for the next snapshot. While waiting it keeps background
+shader compiles moving and asks the main thread for a new
+frame (requestRedraw) when something finished.
+*/
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include "FrameSnapshot.h"
+
+/* Render thread prototypes */
+bool startRenderThread(GLFWwindow* window);
+FrameSnapshot& beginSnapshot();
+void publishSnapshot();
+bool waitSnapshotConsumed(double timeout);
+void requestRedraw();
+bool consumeRedrawRequest();
+void stopRenderThread();
@@ -0,0 +1,1011 @@
+#include "Renderer.h"
+
+#include <GLEW/glew.h>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <SOIL2\SOIL2.h>
+
+#include "ShaderManager.h"
+#include "GLState.h"
+#include "FrameStats.h"
+#include "DrawList.h"
+#include "Harmonica.h"
+#include "HarmonicaGenerator.h"
+#include "IrradianceVolume.h"
+#include "MeshSimplify.h"
+#include "Impostor.h"
+#include "Accumulation.h"
+#include "DynamicResolution.h"
+#include "Meshlet.h"
+#include "PipelineStats.h"
+
+using namespace std;
+
+/* Constants */
+const size_t FRAME_ARENA_SIZE = 1 << 20;	// Bytes of transient CPU memory per frame
+const size_t UNIFORM_RING_SIZE = 1 << 20;	// Bytes of per-draw uniforms per frame
+const size_t DRAW_LIST_CAPACITY = 256;		// Initial draw list size, grows inside the arena
+const GLfloat LOD_PIXEL_ERROR = 1.0f;		// Largest simplification error allowed on screen, in pixels
+const size_t INSTANCE_RING_SIZE = 1 << 20;	// Bytes of impostor instance attributes per frame
+const GLfloat IMPOSTOR_PIXELS = 48.0f;		// Instances whose bounding sphere is smaller on screen (radius in pixels) become impostors
+const GLfloat IMPOSTOR_HYSTERESIS = 0.75f;	// ... once they shrink this far below it, so they do not flicker at the threshold
+const GLfloat WIREFRAME_LINE_WIDTH = 1.5f;	// Edge width of the wireframe modes, in pixels
+const int MULTIVIEW_PROGRAMS = 2;			// View counts the multiview shader is compiled for
+
+// Sort ids, draws sharing an id share that piece of GL state
+const GLuint PROGRAM_HARMONICA = 0, PROGRAM_LAMP = 1;
+
+/* Lamp cube planes */
+static const glm::vec3 lampPlanePositions[] = {
+	glm::vec3(0.0f,  0.0f,  0.5f),
+	glm::vec3(0.5f,  0.0f,  0.0f),
+	glm::vec3(0.0f,  0.0f,  -0.5f),
+	glm::vec3(-0.5f, 0.0f,  0.0f),
+	glm::vec3(0.0f, 0.5f,  0.0f),
+	glm::vec3(0.0f, -0.5f,  0.0f)
+};
+
+static const GLfloat lampPlaneRotations[] = {
+	0.0f, 90.0f, 180.0f, -90.0f, -90.f, 90.f
+};
+
+// Harmonica parts, drawn once per instance and half
+static const HarmonicaMesh harmonicaParts[] = { MESH_REED, MESH_COVER, MESH_COMB };
+const size_t PART_COUNT = sizeof(harmonicaParts) / sizeof(harmonicaParts[0]);
+
+// Light uniforms of the primary shader
+static const char* lightColorNames[LIGHT_COUNT] = { "light1Color", "light2Color", "light3Color" };
+static const char* lightPosNames[LIGHT_COUNT] = { "light1Pos", "light2Pos", "light3Pos" };
+
+/* Module state */
+static Mesh meshes[MESH_COUNT];
+static GLuint textures[MESH_COUNT];
+static vector<SceneMaterial> sceneMaterials;	// Materials 1 and up, empty files keep the built-in texture
+static vector<GLuint> materialTextures;	// PART_COUNT per material, material 0 the built-in textures
+static vector<GLuint> sceneTextures;	// Textures loaded for scene materials, each file once
+static HarmonicaParams harmonicaShape;
+static bool customShape = false;			// Generate the parts at startup instead of using the built-in model
+static IrradianceVolume bakedLighting;
+static bool bakedDiffuse = false;			// Lit programs read diffuse light from the baked volume
+static GLuint irradianceTexture = 0;
+static ShaderProgram* shaderProgram = nullptr;
+static ShaderProgram* lampShaderProgram = nullptr;
+static ShaderProgram* depthProgram = nullptr;		// Position only, no fragment shader
+static ShaderProgram* overdrawProgram = nullptr;	// Adds one heat map layer per fragment
+static ShaderProgram* wireframeProgram = nullptr;	// Primary shader with edges from barycentric distances
+static ShaderProgram* multiviewPrograms[MULTIVIEW_PROGRAMS] = {};	// Primary shader projecting every triangle into several viewports
+static const int multiviewCounts[MULTIVIEW_PROGRAMS] = { QUAD_VIEWS, MAX_VIEWS };	// Views (geometry shader invocations) of each
+static DrawList drawList;
+static GpuRingBuffer uniformRing;
+static Accumulation accumulation;
+static DynamicResolution dynamicResolution;
+static Impostor impostor;				// Whole harmonica, drawn for instances far from the camera
+static GpuRingBuffer instanceRing;		// Impostor instance attributes
+static ShaderProgram* meshletProgram = nullptr;	// Primary shader reading its transform from instance attributes
+static MeshletMesh meshletMeshes[MESH_COUNT];	// Meshlets of the harmonica parts
+static GLuint meshletTransforms = 0;	// Part transforms that are not impostors, shared by every part
+static bool meshletCulling = false;		// Driver can run the culling pass
+
+static TransformSoA halfTransforms;		// The two halves of every part
+static TransformSoA partTransforms;		// Every instance times every half
+static shared_ptr<const TransformSoA> partSource;	// Instance list partTransforms was expanded from
+static shared_ptr<const vector<uint16_t>> materialSource;	// Material list partMaterials was expanded from
+static vector<uint16_t> partMaterials;	// Material of every part transform
+static int sharedMaterial = 0;			// Material of every instance, -1 if they use several
+static vector<unsigned char> partLods[MESH_COUNT];	// Level of detail each part transform used last frame
+static vector<unsigned char> partHidden;	// Part transforms whose instance is an impostor this frame
+static vector<unsigned char> instanceImpostors;	// Instances drawn as impostors last frame
+static TransformSoA lampTransforms;		// Six planes per lamp, refilled every frame
+static unsigned long long lastSnapshot = 0;	// Sequence number of the previous snapshot drawn
+static unsigned int lastInputDropped = 0;	// Input events dropped as of the previous snapshot drawn
+
+// Load an image file into a mipmapped texture, 0 if the file has no texture
+static GLuint LoadTexture(const char* file)
+{
+	if (!file)
+		return 0;
+
+	int texW, texH;
+	unsigned char* image = SOIL_load_image(file, &texW, &texH, 0, SOIL_LOAD_RGB);
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texW, texH, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	SOIL_free_image_data(image);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texture;
+}
+
+// Material of instance i, 0 (the built-in textures) without a list or for a material that was never loaded
+static uint16_t InstanceMaterial(const vector<uint16_t>* materials, size_t i)
+{
+	if (!materials || i >= materials->size() || (*materials)[i] >= materialTextures.size() / PART_COUNT)
+		return 0;
+	return (*materials)[i];
+}
+
+// Next holds every transform and material of previous at the same index, more may follow
+static bool ExtendsList(const TransformSoA& previous, const TransformSoA& next, const vector<uint16_t>* previousMaterials, const vector<uint16_t>* nextMaterials)
+{
+	size_t count = transformCount(previous);
+	if (transformCount(next) < count)
+		return false;
+
+	const vector<float>* before[] = { &previous.px, &previous.py, &previous.pz, &previous.qx, &previous.qy, &previous.qz, &previous.qw, &previous.sx, &previous.sy, &previous.sz };
+	const vector<float>* after[] = { &next.px, &next.py, &next.pz, &next.qx, &next.qy, &next.qz, &next.qw, &next.sx, &next.sy, &next.sz };
+	for (size_t c = 0; c < sizeof(before) / sizeof(before[0]); ++c)
+		if (count && memcmp(before[c]->data(), after[c]->data(), count * sizeof(float)) != 0)
+			return false;
+	for (size_t i = 0; i < count; ++i)
+		if (InstanceMaterial(previousMaterials, i) != InstanceMaterial(nextMaterials, i))
+			return false;
+	return true;
+}
+
+// Combine every harmonica instance with both halves. A list that only appends to the previous one (a scene
+// streaming in) expands just the new instances, the others keep their level of detail and impostor state
+static void ExpandInstances(const shared_ptr<const TransformSoA>& instances, const shared_ptr<const vector<uint16_t>>& materials)
+{
+	size_t kept = partSource && instances && ExtendsList(*partSource, *instances, materialSource.get(), materials.get()) ? transformCount(*partSource) : 0;
+	partSource = instances;
+	materialSource = materials;
+	if (kept == 0) {
+		clearTransforms(partTransforms);
+		for (vector<unsigned char>& lods : partLods)
+			lods.clear();
+		partHidden.clear();
+		partMaterials.clear();
+		instanceImpostors.clear();
+		sharedMaterial = 0;
+	}
+	if (!instances)
+		return;
+
+	size_t halfCount = transformCount(halfTransforms);
+	for (size_t i = kept; i < transformCount(*instances); ++i) {
+		glm::vec3 position(instances->px[i], instances->py[i], instances->pz[i]);
+		glm::quat rotation(instances->qw[i], instances->qx[i], instances->qy[i], instances->qz[i]);
+		glm::vec3 scale(instances->sx[i], instances->sy[i], instances->sz[i]);
+		uint16_t material = InstanceMaterial(materials.get(), i);
+		if (i == 0)
+			sharedMaterial = material;
+		else if (sharedMaterial != material)
+			sharedMaterial = -1;
+
+		// Halves only rotate about Z by 180 degrees, which commutes with an axis aligned scale
+		for (size_t h = 0; h < halfCount; ++h) {
+			glm::quat half(halfTransforms.qw[h], halfTransforms.qx[h], halfTransforms.qy[h], halfTransforms.qz[h]);
+			addTransform(partTransforms, position, rotation * half, scale);
+			partMaterials.push_back(material);
+		}
+	}
+
+	// New instances start at full detail
+	for (vector<unsigned char>& lods : partLods)
+		lods.resize(transformCount(partTransforms), 0);
+	partHidden.resize(transformCount(partTransforms), 0);
+	instanceImpostors.resize(transformCount(*instances), 0);
+}
+
+// Bounding sphere of the whole harmonica (both halves) around which the impostor views are taken
+static void InitImpostor(const vector<glm::vec3>& partPoints)
+{
+	vector<glm::vec3> points;
+	for (size_t h = 0; h < transformCount(halfTransforms); ++h) {
+		glm::mat3 rotation = glm::mat3_cast(glm::quat(halfTransforms.qw[h], halfTransforms.qx[h], halfTransforms.qy[h], halfTransforms.qz[h]));
+		for (const glm::vec3& p : partPoints)
+			points.push_back(rotation * p);
+	}
+
+	glm::vec3 low = points[0], high = points[0];
+	for (const glm::vec3& p : points) {
+		low = glm::min(low, p);
+		high = glm::max(high, p);
+	}
+
+	glm::vec3 center = (low + high) * 0.5f;
+	GLfloat radius = 0.0f;
+	for (const glm::vec3& p : points)
+		radius = glm::max(radius, glm::length(p - center));
+
+	initImpostor(impostor, center, radius);
+}
+
+// Render every part and half into the impostor atlas
+static void BakeImpostor()
+{
+	size_t halfCount = transformCount(halfTransforms);
+	vector<float> world(halfCount * WORLD_FLOATS);
+	vector<float> normal(halfCount * NORMAL_FLOATS);
+	transformInstances(halfTransforms, 0, halfCount, world.data(), normal.data());
+
+	vector<ImpostorPart> parts;
+	for (HarmonicaMesh part : harmonicaParts) {
+		for (size_t h = 0; h < halfCount; ++h) {
+			ImpostorPart piece;
+			piece.vao = meshes[part].vao;
+			piece.texture = textures[part];
+			piece.indexCount = meshes[part].lods[0].indexCount;
+			piece.uniforms.model = glm::make_mat4(&world[h * WORLD_FLOATS]);
+			memcpy(piece.uniforms.normalMatrix, &normal[h * NORMAL_FLOATS], sizeof(piece.uniforms.normalMatrix));
+			parts.push_back(piece);
+		}
+	}
+
+	bakeImpostor(impostor, parts.data(), parts.size());
+}
+
+// Pixels on screen per world unit at a point (works for ortho and perspective)
+static GLfloat PixelsPerUnitAt(const CameraSnapshot& camera, const glm::vec3& point, int height)
+{
+	glm::vec4 clip = camera.projection * camera.view * glm::vec4(point, 1.0f);
+	GLfloat w = glm::max(clip.w, camera.zNear);
+	return fabs(camera.projection[1][1]) * 0.5f * height / w;
+}
+
+// Pixels on screen per object-space unit at the mesh center
+static GLfloat PixelsPerUnit(const CameraSnapshot& camera, const glm::mat4& model, const glm::vec3& center, int height)
+{
+	// Largest axis scale of the model matrix
+	GLfloat scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	return scale * PixelsPerUnitAt(camera, glm::vec3(model * glm::vec4(center, 1.0f)), height);
+}
+
+// Switch instances that are small on screen to impostors and write their attributes, returns how many
+static size_t SelectImpostors(const FrameSnapshot& snapshot, GpuAllocation& allocation)
+{
+	fill(partHidden.begin(), partHidden.end(), 0);
+	allocation = { nullptr, 0 };
+
+	size_t instanceCount = partSource ? transformCount(*partSource) : 0;
+	if (instanceCount == 0 || !impostorReady(impostor))
+		return 0;
+
+	// Pick the impostors first, the ring only needs room for them
+	const TransformSoA& instances = *partSource;
+	size_t count = 0;
+	for (size_t i = 0; i < instanceCount; ++i) {
+		glm::quat rotation(instances.qw[i], instances.qx[i], instances.qy[i], instances.qz[i]);
+		GLfloat scale = glm::max(instances.sx[i], glm::max(instances.sy[i], instances.sz[i]));
+		glm::vec3 center = glm::vec3(instances.px[i], instances.py[i], instances.pz[i]) + glm::mat3_cast(rotation) * (impostor.center * scale);
+		GLfloat pixels = impostor.radius * scale * PixelsPerUnitAt(snapshot.camera, center, snapshot.height);
+
+		// Become an impostor well under the limit, return to geometry once over it
+		bool distant = pixels < IMPOSTOR_PIXELS * (instanceImpostors[i] ? 1.0f : IMPOSTOR_HYSTERESIS);
+		instanceImpostors[i] = distant;
+		count += distant;
+	}
+	if (count == 0)
+		return 0;
+
+	// The only allocation of the instance ring this frame, so it can grow to fit
+	reserveGpuRing(instanceRing, 1, count * sizeof(ImpostorInstance));
+	allocation = gpuRingAlloc(instanceRing, count * sizeof(ImpostorInstance));
+	if (!allocation.data)
+		return 0;	// Every instance stays geometry
+
+	ImpostorInstance* attributes = static_cast<ImpostorInstance*>(allocation.data);
+	size_t halfCount = transformCount(halfTransforms);
+	size_t written = 0;
+	for (size_t i = 0; i < instanceCount; ++i) {
+		if (!instanceImpostors[i])
+			continue;
+
+		for (size_t h = 0; h < halfCount; ++h)
+			partHidden[i * halfCount + h] = 1;
+
+		ImpostorInstance& attribute = attributes[written++];
+		attribute.position[0] = instances.px[i];
+		attribute.position[1] = instances.py[i];
+		attribute.position[2] = instances.pz[i];
+		attribute.scale = glm::max(instances.sx[i], glm::max(instances.sy[i], instances.sz[i]));
+		attribute.rotation[0] = instances.qx[i];
+		attribute.rotation[1] = instances.qy[i];
+		attribute.rotation[2] = instances.qz[i];
+		attribute.rotation[3] = instances.qw[i];
+	}
+
+	return count;
+}
+
+// Part transforms not hidden this frame, each is drawn once per part
+static size_t VisibleParts()
+{
+	return (size_t)count(partHidden.begin(), partHidden.end(), (unsigned char)0);
+}
+
+// Hide the parts of instances whose bounding sphere is outside every camera's frustum
+static void CullToViews(LinearArena& arena, const CameraSnapshot* cameras, int count)
+{
+	fill(partHidden.begin(), partHidden.end(), 0);
+
+	size_t instanceCount = partSource ? transformCount(*partSource) : 0;
+	glm::vec4* planes = arenaAllocArray<glm::vec4>(arena, count * 6);
+	for (int v = 0; v < count; ++v)
+		frustumPlanes(cameras[v].projection * cameras[v].view, &planes[v * 6]);
+
+	const TransformSoA& instances = *partSource;
+	size_t halfCount = transformCount(halfTransforms);
+	for (size_t i = 0; i < instanceCount; ++i) {
+		glm::vec3 position(instances.px[i], instances.py[i], instances.pz[i]);
+		glm::quat rotation(instances.qw[i], instances.qx[i], instances.qy[i], instances.qz[i]);
+		GLfloat scale = glm::max(instances.sx[i], glm::max(instances.sy[i], instances.sz[i]));
+		glm::vec3 center = position + glm::mat3_cast(rotation) * (impostor.center * scale);
+		GLfloat radius = impostor.radius * scale;
+
+		bool visible = false;
+		for (int v = 0; v < count && !visible; ++v)
+			visible = sphereInFrustum(&planes[v * 6], center, radius);
+		if (visible)
+			continue;
+
+		for (size_t h = 0; h < halfCount; ++h)
+			partHidden[i * halfCount + h] = 1;
+	}
+}
+
+// Upload the transforms of the parts that are not impostors, returns how many
+static size_t UploadMeshletTransforms(LinearArena& arena)
+{
+	size_t count = transformCount(partTransforms);
+	float* world = arenaAllocArray<float>(arena, count * WORLD_FLOATS);
+	float* normal = arenaAllocArray<float>(arena, count * NORMAL_FLOATS);
+	transformInstances(partTransforms, 0, count, world, normal);
+
+	MeshletTransform* visible = arenaAllocArray<MeshletTransform>(arena, count);
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (partHidden[i])
+			continue;
+
+		MeshletTransform& transform = visible[visibleCount++];
+		transform.model = glm::make_mat4(world + i * WORLD_FLOATS);
+		memcpy(transform.normalMatrix, normal + i * NORMAL_FLOATS, sizeof(transform.normalMatrix));
+	}
+
+	// Orphaned every frame, the previous frame's draws may still read it
+	glBindBuffer(GL_ARRAY_BUFFER, meshletTransforms);
+	glBufferData(GL_ARRAY_BUFFER, visibleCount * sizeof(MeshletTransform), visible, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return visibleCount;
+}
+
+// Add the six planes of a lamp cube
+static void AddLampCube(const glm::vec3& position)
+{
+	for (GLuint i = 0; i < 6; i++) {
+		glm::quat rotation = glm::angleAxis(glm::radians(lampPlaneRotations[i]), glm::vec3(0.0f, 1.0f, 0.0f));
+		if (i >= 4)
+			rotation = rotation * glm::angleAxis(glm::radians(lampPlaneRotations[i]), glm::vec3(1.0f, 0.0f, 0.0f));
+		addTransform(lampTransforms, lampPlanePositions[i] / glm::vec3(8.0f, 8.0f, 8.0f) + position, rotation, glm::vec3(.125f, .125f, .125f));
+	}
+}
+
+// Place a cube of six planes around every light, or every lamp of a scene with more lights than the shader
+static void BuildLampTransforms(const FrameSnapshot& snapshot)
+{
+	clearTransforms(lampTransforms);
+
+	if (snapshot.lamps) {
+		for (const glm::vec3& position : *snapshot.lamps)
+			AddLampCube(position);
+		return;
+	}
+
+	for (const LightSnapshot& light : snapshot.lights)
+		AddLampCube(light.position);
+}
+
+// Expand transforms into per-draw uniforms and add one draw per transform, picking a level of detail per transform if lods is set
+// and skipping the transforms marked in hidden. With materials set, materialId is a harmonica part and each transform draws with
+// the texture of that part in its own material
+static void AddDraws(LinearArena& arena, const FrameSnapshot& snapshot, const TransformSoA& transforms, DrawCommand command, DrawPass pass, GLuint programId, GLuint materialId, GLuint meshId, const Mesh& mesh, unsigned char* lods, const unsigned char* hidden, const uint16_t* materials)
+{
+	const glm::vec3& center = mesh.center;
+
+	size_t count = transformCount(transforms);
+	float* world = arenaAllocArray<float>(arena, count * WORLD_FLOATS);
+	float* normal = arenaAllocArray<float>(arena, count * NORMAL_FLOATS);
+	transformInstances(transforms, 0, count, world, normal);
+
+	for (size_t i = 0; i < count; ++i) {
+		if (hidden && hidden[i])
+			continue;
+
+		PerDrawUniforms uniforms;
+		uniforms.model = glm::make_mat4(world + i * WORLD_FLOATS);
+		memcpy(uniforms.normalMatrix, normal + i * NORMAL_FLOATS, sizeof(uniforms.normalMatrix));
+		// Only fails if the frame staged more than it reserved, counted as a ring overflow and grown for the next frame
+		if (!stageDrawUniforms(uniformRing, uniforms, command))
+			continue;
+
+		if (lods && mesh.lodCount > 1) {
+			lods[i] = (unsigned char)selectMeshLod(mesh, lods[i], PixelsPerUnit(snapshot.camera, uniforms.model, center, snapshot.height), LOD_PIXEL_ERROR);
+			command.firstIndex = mesh.lods[lods[i]].firstIndex;
+			command.indexCount = mesh.lods[lods[i]].indexCount;
+		}
+
+		GLuint material = materialId;
+		if (materials) {
+			material = materials[i] * (GLuint)PART_COUNT + materialId;
+			command.texture = materialTextures[material];
+		}
+
+		GLfloat depth = quantizeDepth(snapshot.camera.view, uniforms.model, center, snapshot.camera.zNear, snapshot.camera.zFar);
+		command.key = makeSortKey(pass, programId, material, meshId, depth);
+		addDraw(drawList, command);
+	}
+}
+
+// Set the camera and light uniforms of a lit program
+static void SetLitUniforms(GLuint program, const FrameSnapshot& snapshot, const CameraSnapshot& camera, const glm::mat4& projection)
+{
+	stateUseProgram(program);
+
+	// Select uniform variable and shader
+	GLint viewLoc = glGetUniformLocation(program, "view");
+	GLint projectionLoc = glGetUniformLocation(program, "projection");
+
+	// Get light and object color, and light position location
+	GLint objectColorLoc = glGetUniformLocation(program, "objectColor");
+	GLint viewPosLoc = glGetUniformLocation(program, "viewPos");
+
+	// Assign Object Color
+	glUniform3f(objectColorLoc, 1.0f, 1.0f, 1.0f);
+
+	// Set light colors and positions
+	for (int i = 0; i < LIGHT_COUNT; ++i) {
+		const LightSnapshot& lamp = snapshot.lights[i];
+		glUniform3f(glGetUniformLocation(program, lightColorNames[i]), lamp.color.x, lamp.color.y, lamp.color.z);
+		glUniform3f(glGetUniformLocation(program, lightPosNames[i]), lamp.position.x, lamp.position.y, lamp.position.z);
+	}
+
+	// Set view position
+	glUniform3f(viewPosLoc, camera.position.x, camera.position.y, camera.position.z);
+
+	// Baked diffuse light, only programs compiled with BAKED_DIFFUSE read it
+	GLint volumeLoc = glGetUniformLocation(program, "irradianceVolume");
+	if (volumeLoc >= 0) {
+		glm::vec3 size = bakedLighting.high - bakedLighting.low;
+		glUniform1i(volumeLoc, IRRADIANCE_UNIT);
+		glUniform3f(glGetUniformLocation(program, "volumeLow"), bakedLighting.low.x, bakedLighting.low.y, bakedLighting.low.z);
+		glUniform3f(glGetUniformLocation(program, "volumeSize"), size.x, size.y, size.z);
+		glUniform3f(glGetUniformLocation(program, "volumeProbes"), (GLfloat)bakedLighting.probes[0], (GLfloat)bakedLighting.probes[1], (GLfloat)bakedLighting.probes[2]);
+		stateBindTexture(IRRADIANCE_UNIT, GL_TEXTURE_3D, irradianceTexture);
+	}
+
+	// Pass transform to Shader
+	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(camera.view));
+	glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+}
+
+// Set the camera matrices of an unlit program
+static void SetViewUniforms(GLuint program, const CameraSnapshot& camera, const glm::mat4& projection)
+{
+	stateUseProgram(program);
+
+	// Get matrix's uniform location and set matrix
+	GLint viewLoc = glGetUniformLocation(program, "view");
+	GLint projLoc = glGetUniformLocation(program, "projection");
+
+	glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(camera.view));
+	glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+}
+
+// Set the per-frame uniforms of every program
+static void SetFrameUniforms(const FrameSnapshot& snapshot, const CameraSnapshot& camera, const glm::mat4& projection)
+{
+	/* START PRIMARY SHADER PROGRAM */
+	SetLitUniforms(shaderProgram->program, snapshot, camera, projection);
+
+	// Impostors are lit like the geometry they replace
+	if (impostor.draw->program)
+		SetLitUniforms(impostor.draw->program, snapshot, camera, projection);
+	if (wireframeProgram->program)
+		SetLitUniforms(wireframeProgram->program, snapshot, camera, projection);
+
+	/* LAUNCH LIGHT SHADER PROGRAM */
+	SetViewUniforms(lampShaderProgram->program, camera, projection);
+
+	// Debug and pre-pass programs
+	if (depthProgram->program)
+		SetViewUniforms(depthProgram->program, camera, projection);
+	if (overdrawProgram->program)
+		SetViewUniforms(overdrawProgram->program, camera, projection);
+}
+
+// Materials 1 and up, in the order of the scene's list, must be called before initRenderer()
+void setSceneMaterials(const vector<SceneMaterial>& materials)
+{
+	sceneMaterials = materials;
+	if (sceneMaterials.size() >= MAX_MATERIALS) {
+		cout << "Scene has " << sceneMaterials.size() << " materials, only the first " << MAX_MATERIALS - 1 << " are loaded" << endl;
+		sceneMaterials.resize(MAX_MATERIALS - 1);
+	}
+}
+
+// Replace the built-in harmonica with a generated shape, must be called before initRenderer()
+void setHarmonicaShape(const HarmonicaParams& params)
+{
+	harmonicaShape = params;
+	customShape = true;
+}
+
+// Replace the live diffuse term of the harmonica with a baked volume, must be called before initRenderer()
+void setBakedLighting(const IrradianceVolume& volume)
+{
+	bakedLighting = volume;
+	bakedDiffuse = true;
+}
+
+// Create every GL resource, the context must be current
+bool initRenderer()
+{
+	// Start state cache from a known state
+	stateReset();
+
+	// Enable Depth Buffer
+	stateEnable(GL_DEPTH_TEST, true);
+
+	/* Meshes and textures */
+	vector<glm::vec3> partPoints;	// Vertex positions of every part, bounds of the impostor
+	vector<Meshlet> partMeshlets[MESH_COUNT];
+	for (int i = 0; i < MESH_COUNT; ++i) {
+		// Harmonica parts get meshlets and a level of detail chain, the lamp planes are already minimal
+		MeshData data = customShape && i != MESH_LAMP ? generateHarmonicaMesh(harmonicaShape, (HarmonicaMesh)i) : harmonicaMeshData((HarmonicaMesh)i);
+		if (i != MESH_LAMP) {
+			for (size_t v = 0; v + 2 < data.vertices.size(); v += data.stride)
+				partPoints.push_back(glm::vec3(data.vertices[v], data.vertices[v + 1], data.vertices[v + 2]));
+
+			// Meshlets reorder the full detail indices, so they are built before the chain is appended
+			buildMeshlets(data, partMeshlets[i]);
+			buildLodChain(data);
+		}
+		meshes[i] = createMesh(data);
+		textures[i] = LoadTexture(harmonicaTexture((HarmonicaMesh)i));
+	}
+
+	// Material textures, a file shared by several materials (or with the built-in ones) is loaded once
+	map<string, GLuint> loaded;
+	for (HarmonicaMesh part : harmonicaParts) {
+		loaded[harmonicaTexture(part)] = textures[part];
+		materialTextures.push_back(textures[part]);
+	}
+	for (const SceneMaterial& material : sceneMaterials) {
+		for (HarmonicaMesh part : harmonicaParts) {
+			const string& file = material.textures[part];
+			if (file.empty()) {
+				materialTextures.push_back(textures[part]);
+				continue;
+			}
+
+			auto it = loaded.find(file);
+			if (it == loaded.end()) {
+				it = loaded.insert(make_pair(file, LoadTexture(file.c_str()))).first;
+				sceneTextures.push_back(it->second);
+			}
+			materialTextures.push_back(it->second);
+		}
+	}
+
+	/* Instance transforms, expanded to matrices each frame by the batched kernel */
+	// The second half is rotated on Z to create a complete object
+	addTransform(halfTransforms, glm::vec3(0.0f), glm::quat(), glm::vec3(1.0f));
+	addTransform(halfTransforms, glm::vec3(0.0f), glm::angleAxis(glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(1.0f));
+
+	/* Transient per-frame memory */
+	initFrameArenas(FRAME_ARENA_SIZE);
+	initGpuRing(uniformRing, GL_UNIFORM_BUFFER, UNIFORM_RING_SIZE);
+	initGpuRing(instanceRing, GL_ARRAY_BUFFER, INSTANCE_RING_SIZE);
+
+	/* Baked lighting, every program shading the harmonica reads it */
+	string litDefines;
+	if (bakedDiffuse) {
+		irradianceTexture = createIrradianceTexture(bakedLighting);
+		litDefines = "#define BAKED_DIFFUSE\n";
+	}
+
+	/* Load shader programs (compiled in the background, reloaded on change) */
+	initShaderManager();
+	setUniformBlockBinding("PerDraw", PER_DRAW_BINDING);
+	shaderProgram = loadShaderProgram("shaders/harmonica.vert", "shaders/harmonica.frag", litDefines);
+	lampShaderProgram = loadShaderProgram("shaders/lamp.vert", "shaders/lamp.frag");
+
+	// Depth pre-pass has no fragment shader, the overdraw view reuses the primary vertex shader
+	ShaderStage depthVertex;
+	depthVertex.type = GL_VERTEX_SHADER;
+	depthVertex.path = "shaders/depth.vert";
+	depthProgram = loadShaderProgram({ depthVertex });
+	overdrawProgram = loadShaderProgram("shaders/harmonica.vert", "shaders/overdraw.frag");
+
+	// Wireframe modes draw edges in the shading pass, a geometry shader adds the distances to each edge
+	ShaderStage wireStages[3];
+	wireStages[0].type = GL_VERTEX_SHADER;
+	wireStages[0].path = "shaders/harmonica.vert";
+	wireStages[1].type = GL_GEOMETRY_SHADER;
+	wireStages[1].path = "shaders/wireframe.geom";
+	wireStages[2].type = GL_FRAGMENT_SHADER;
+	wireStages[2].path = "shaders/harmonica.frag";
+	wireframeProgram = loadShaderProgram({ wireStages[0], wireStages[1], wireStages[2] }, "#define WIREFRAME\n" + litDefines);
+
+	// Several views in one pass need a viewport array (GL 4.1), otherwise they are drawn one by one
+	if (GLEW_ARB_viewport_array) {
+		// Compiled for the quad view and for full thumbnail batches, so no invocation is launched only to return
+		wireStages[1].path = "shaders/multiview.geom";
+		for (int i = 0; i < MULTIVIEW_PROGRAMS; ++i) {
+			string defines = "#define MULTIVIEW\n#define VIEW_COUNT " + to_string(multiviewCounts[i]) + "\n" + litDefines;
+			multiviewPrograms[i] = loadShaderProgram({ wireStages[0], wireStages[1], wireStages[2] }, defines);
+		}
+	}
+	initAccumulation(accumulation);
+	initDynamicResolution(dynamicResolution);
+	InitImpostor(partPoints);
+
+	/* Meshlet culling, when the driver supports compute */
+	meshletCulling = initMeshletCulling();
+	if (meshletCulling) {
+		meshletProgram = loadShaderProgram("shaders/harmonica.vert", "shaders/harmonica.frag", "#define INSTANCED_MODEL\n" + litDefines);
+		glGenBuffers(1, &meshletTransforms);
+		for (HarmonicaMesh part : harmonicaParts)
+			createMeshletMesh(meshletMeshes[part], meshes[part], partMeshlets[part], meshletTransforms);
+	}
+
+	return true;
+}
+
+// Between frames: finish background work, true if the next frame would look different
+bool pollRenderer(GLfloat time)
+{
+	return pollShaderPrograms(time);
+}
+
+// Shader compiles are still in flight
+bool rendererCompiling()
+{
+	return shaderProgramsPending();
+}
+
+// Draw the harmonica at full detail from several cameras into tiles of the bound framebuffer, columns tiles per row
+// starting at the bottom left; false while the shaders are not ready. Culling, sorting and the per-draw uniforms
+// are shared by every view
+bool renderViews(const FrameSnapshot& snapshot, const CameraSnapshot* cameras, int count, int columns, int tileWidth, int tileHeight)
+{
+	pollShaderPrograms(snapshot.time);
+	if (shaderProgram->program == 0 || count <= 0)
+		return false;
+
+	// Fewest invocations that cover every view
+	ShaderProgram* multiviewProgram = nullptr;
+	for (int i = 0; i < MULTIVIEW_PROGRAMS && !multiviewProgram; ++i)
+		if (multiviewPrograms[i] && count <= multiviewCounts[i])
+			multiviewProgram = multiviewPrograms[i];
+	bool multiview = multiviewProgram && multiviewProgram->program;
+	GLuint program = multiview ? multiviewProgram->program : shaderProgram->program;
+
+	/* BUILD DRAW LIST */
+	LinearArena& arena = beginFrameArena();
+	beginGpuRingFrame(uniformRing);
+	beginDrawList(drawList, arena, DRAW_LIST_CAPACITY);
+
+	if (snapshot.instances != partSource || snapshot.materials != materialSource)
+		ExpandInstances(snapshot.instances, snapshot.materials);
+
+	// Instances outside every view are dropped, the union of the frusta
+	CullToViews(arena, cameras, count);
+	reserveGpuRing(uniformRing, VisibleParts() * PART_COUNT, sizeof(PerDrawUniforms));
+
+	// Sorted for the first view, the others share its order
+	FrameSnapshot sortView = snapshot;
+	sortView.camera = cameras[0];
+	for (HarmonicaMesh part : harmonicaParts) {
+		DrawCommand command;
+		command.program = program;
+		command.vao = meshes[part].vao;
+		command.depthVao = meshes[part].depthVao;
+		command.texture = textures[part];
+		command.firstIndex = 0;
+		command.indexCount = meshes[part].indexCount;
+
+		AddDraws(arena, sortView, partTransforms, command, PASS_OPAQUE, PROGRAM_HARMONICA, part, part, meshes[part], nullptr, partHidden.data(), partMaterials.data());
+	}
+
+	sortDrawList(drawList);
+	flushGpuRing(uniformRing);
+
+	statePolygonMode(GL_FILL);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	if (multiview) {
+		// Lights are shared, each view gets its own matrix, position and viewport
+		SetLitUniforms(program, snapshot, cameras[0], cameras[0].projection);
+		glm::mat4 viewProjections[MAX_VIEWS];
+		glm::vec3 viewPositions[MAX_VIEWS];
+		for (int i = 0; i < count; ++i) {
+			viewProjections[i] = cameras[i].projection * cameras[i].view;
+			viewPositions[i] = cameras[i].position;
+			glViewportIndexedf(i, (GLfloat)(i % columns * tileWidth), (GLfloat)(i / columns * tileHeight), (GLfloat)tileWidth, (GLfloat)tileHeight);
+		}
+		glUniform1i(glGetUniformLocation(program, "viewCount"), count);
+		glUniformMatrix4fv(glGetUniformLocation(program, "viewProjections"), count, GL_FALSE, glm::value_ptr(viewProjections[0]));
+		glUniform3fv(glGetUniformLocation(program, "viewPositions"), count, glm::value_ptr(viewPositions[0]));
+
+		submitDrawList(drawList, uniformRing);
+
+		// Indexed viewports bypass the state cache
+		stateReset();
+		stateEnable(GL_DEPTH_TEST, true);
+	}
+	else {
+		for (int i = 0; i < count; ++i) {
+			stateViewport(i % columns * tileWidth, i / columns * tileHeight, tileWidth, tileHeight);
+			SetLitUniforms(program, snapshot, cameras[i], cameras[i].projection);
+			submitDrawList(drawList, uniformRing);
+		}
+	}
+
+	endGpuRingFrame(uniformRing);
+	return true;
+}
+
+// Draw one snapshot into the back buffer, true if drawing it again would improve the image
+bool renderFrame(const FrameSnapshot& snapshot, CameraLatch latch)
+{
+	// Finish background compiles and pick up edited shader files
+	pollShaderPrograms(snapshot.time);
+
+	// Start collecting this frame's statistics
+	beginFrameStats();
+	printStats = snapshot.printStats;
+	printFrameStats(snapshot.time);
+
+	// Snapshots the main thread published while the previous frame was drawn
+	if (lastSnapshot && snapshot.frame > lastSnapshot + 1)
+		frameStats.snapshotsDropped = (unsigned int)(snapshot.frame - lastSnapshot - 1);
+	lastSnapshot = snapshot.frame;
+	if (snapshot.inputDropped > lastInputDropped)
+		frameStats.inputDropped = snapshot.inputDropped - lastInputDropped;
+	lastInputDropped = snapshot.inputDropped;
+
+	// Impostor atlas is rendered once its shader links, and again whenever it is reloaded
+	if (impostor.bake->generation != impostor.bakedGeneration)
+		BakeImpostor();
+
+	// Wireframe modes use the edge shader, line rasterization only while it is still compiling
+	bool wireframe = snapshot.wireFrame != WIREFRAME_OFF;
+	bool wireShader = wireframe && wireframeProgram->program;
+	statePolygonMode(wireframe && !wireShader ? GL_LINE : GL_FILL);
+
+	// Resize graphics to the window
+	stateViewport(0, 0, snapshot.width, snapshot.height);
+
+	// Shaders are still compiling, present a cleared frame instead of blocking
+	if (shaderProgram->program == 0 || lampShaderProgram->program == 0) {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		return false;
+	}
+
+	// Quad view shares one culled, sorted draw list between its four tiles
+	if (snapshot.quadView) {
+		renderViews(snapshot, snapshot.views, QUAD_VIEWS, 2, snapshot.width / 2, snapshot.height / 2);
+		return false;
+	}
+
+	CameraSnapshot camera = snapshot.camera;
+	glm::mat4 projection = camera.projection;
+
+	// Progressive mode renders offscreen with a jittered projection, or only presents once converged
+	if (snapshot.progressive) {
+		unsigned int sceneVersion = shaderProgram->generation + lampShaderProgram->generation + wireframeProgram->generation + impostor.draw->generation + impostor.bakedGeneration;
+		projection = beginAccumulation(accumulation, snapshot, sceneVersion);
+		if (accumulationConverged(accumulation))
+			return endAccumulation(accumulation);
+	}
+
+	// Dynamic resolution draws into a scaled offscreen target (progressive mode already renders offscreen)
+	bool scaled = snapshot.frameTargetMs > 0.0f && !snapshot.progressive;
+	if (scaled)
+		beginDynamicResolution(dynamicResolution, snapshot);
+
+	/* Render here */
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	/* BUILD DRAW LIST */
+	LinearArena& arena = beginFrameArena();
+	beginGpuRingFrame(uniformRing);
+	beginGpuRingFrame(instanceRing);
+	beginDrawList(drawList, arena, DRAW_LIST_CAPACITY);
+
+	// Instance list only changes when the main thread publishes a new one
+	if (snapshot.instances != partSource || snapshot.materials != materialSource)
+		ExpandInstances(snapshot.instances, snapshot.materials);
+
+	// Overdraw and wireframe views only cover the draw list, every part is drawn as geometry
+	bool overdraw = snapshot.overdraw && overdrawProgram->program;
+	bool geometryOnly = overdraw || wireframe;
+
+	// Instances small on screen are drawn as impostors instead of their parts
+	GpuAllocation impostorAttributes = { nullptr, 0 };
+	size_t impostorCount = 0;
+	if (geometryOnly)
+		fill(partHidden.begin(), partHidden.end(), 0);
+	else
+		impostorCount = SelectImpostors(snapshot, impostorAttributes);
+
+	// Meshlet path culls and draws the parts on the GPU, at full detail, with one material's textures; more parts
+	// than one dispatch can cull, or instances of several materials, go through the draw list instead
+	bool culled = !geometryOnly && snapshot.meshletCulling && meshletCulling && meshletProgram->program && meshletCullingReady() &&
+		VisibleParts() <= MESHLET_MAX_INSTANCES && sharedMaterial >= 0;
+	size_t meshletInstances = culled ? UploadMeshletTransforms(arena) : 0;
+
+	// Room in the ring for the uniforms of every draw, before the first is staged
+	if (snapshot.lightDraw)
+		BuildLampTransforms(snapshot);
+	size_t draws = (culled ? 0 : VisibleParts() * PART_COUNT) + (snapshot.lightDraw ? transformCount(lampTransforms) : 0);
+	reserveGpuRing(uniformRing, draws, sizeof(PerDrawUniforms));
+
+	// Harmonica parts, each drawn once per instance and half, unless the meshlet path draws them
+	if (!culled) {
+		for (HarmonicaMesh part : harmonicaParts) {
+			DrawCommand command;
+			command.program = wireShader ? wireframeProgram->program : shaderProgram->program;
+			command.vao = meshes[part].vao;
+			command.depthVao = meshes[part].depthVao;
+			command.texture = textures[part];
+			command.firstIndex = 0;
+			command.indexCount = meshes[part].indexCount;
+
+			AddDraws(arena, snapshot, partTransforms, command, PASS_OPAQUE, PROGRAM_HARMONICA, part, part, meshes[part], partLods[part].data(), partHidden.data(), partMaterials.data());
+		}
+	}
+
+	/* DRAW LAMPS */
+	if (snapshot.lightDraw) {
+		DrawCommand command;
+		command.program = lampShaderProgram->program;
+		command.vao = meshes[MESH_LAMP].vao;
+		command.depthVao = meshes[MESH_LAMP].depthVao;
+		command.texture = 0;
+		command.firstIndex = 0;
+		command.indexCount = meshes[MESH_LAMP].indexCount;
+
+		AddDraws(arena, snapshot, lampTransforms, command, PASS_LIGHTS, PROGRAM_LAMP, 0, MESH_LAMP, meshes[MESH_LAMP], nullptr, nullptr, nullptr);
+	}
+
+	// Sort by key
+	sortDrawList(drawList);
+	flushGpuRing(uniformRing);
+	flushGpuRing(instanceRing);
+
+	// Late latch: swap in a newer camera published while this frame was being built
+	if (latch && snapshot.lateLatch && !snapshot.progressive && latch(camera))
+		projection = camera.projection;
+
+	// Per-frame uniforms are set once per program, per-draw uniforms by the draw list
+	SetFrameUniforms(snapshot, camera, projection);
+
+	// Edge widths are in pixels of the target drawn into
+	if (wireShader) {
+		GLuint program = wireframeProgram->program;
+		GLfloat targetWidth = (GLfloat)(scaled ? dynamicResolution.renderWidth : snapshot.width);
+		GLfloat targetHeight = (GLfloat)(scaled ? dynamicResolution.renderHeight : snapshot.height);
+		stateUseProgram(program);
+		glUniform2f(glGetUniformLocation(program, "viewportSize"), targetWidth, targetHeight);
+		glUniform1i(glGetUniformLocation(program, "wireMode"), snapshot.wireFrame - WIREFRAME_OVERLAY);
+		glUniform1f(glGetUniformLocation(program, "lineWidth"), WIREFRAME_LINE_WIDTH);
+		glUniform3f(glGetUniformLocation(program, "lineColor"), 1.0f, 1.0f, 1.0f);
+	}
+
+	// Fragment shader work of each pass, measured while statistics are printed
+	if (snapshot.printStats)
+		beginPipelineStatsFrame();
+
+	// Depth pre-pass: opaque depth first without color, so the shading pass only runs for visible fragments
+	// Showing every edge needs the fragments the pre-pass would hide
+	bool prepass = snapshot.depthPrepass && depthProgram->program && snapshot.wireFrame != WIREFRAME_ALL_EDGES;
+	if (prepass) {
+		beginPipelineStatsPass(STATS_PREPASS);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		submitDrawPasses(drawList, uniformRing, PASS_OPAQUE, PASS_OPAQUE, depthProgram->program, true);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		endPipelineStatsPass();
+
+		stateDepthFunc(GL_EQUAL);
+		stateDepthMask(GL_FALSE);
+	}
+
+	// Overdraw view adds a layer color for every fragment that passes the depth test
+	beginPipelineStatsPass(STATS_SHADING);
+	GLuint overrideProgram = 0;
+	if (overdraw) {
+		overrideProgram = overdrawProgram->program;
+		stateEnable(GL_BLEND, true);
+		stateBlendFunc(GL_ONE, GL_ONE);
+	}
+
+	// Issue every draw, opaque geometry against the pre-pass depth
+	submitDrawPasses(drawList, uniformRing, PASS_OPAQUE, PASS_OPAQUE, overrideProgram, false);
+	if (prepass) {
+		stateDepthFunc(GL_LESS);
+		stateDepthMask(GL_TRUE);
+	}
+	submitDrawPasses(drawList, uniformRing, PASS_LIGHTS, PASS_TRANSPARENT, overrideProgram, false);
+	if (overdraw)
+		stateEnable(GL_BLEND, false);
+
+	// Each part in one indirect draw of the meshlets that survived culling
+	if (culled) {
+		SetLitUniforms(meshletProgram->program, snapshot, camera, projection);
+		for (HarmonicaMesh part : harmonicaParts) {
+			cullMeshlets(meshletMeshes[part], meshletTransforms, meshletInstances, camera.view, projection, camera.position);
+			stateUseProgram(meshletProgram->program);
+			stateBindTexture(0, GL_TEXTURE_2D, materialTextures[sharedMaterial * PART_COUNT + part]);
+			drawMeshlets(meshletMeshes[part], meshletInstances);
+		}
+	}
+
+	// Every far instance in one instanced draw
+	drawImpostors(impostor, camera.view, projection, instanceRing.buffer, impostorAttributes.offset, impostorCount);
+	endPipelineStatsPass();
+	endPipelineStatsFrame();
+
+	// Ring segment may be reused once the GPU has passed this point
+	endGpuRingFrame(uniformRing);
+	endGpuRingFrame(instanceRing);
+
+	if (snapshot.progressive)
+		return endAccumulation(accumulation);
+	if (scaled)
+		endDynamicResolution(dynamicResolution, snapshot);
+
+	return false;
+}
+
+// Release every GL resource, the context must still be current
+void shutdownRenderer()
+{
+	/* MAINTENANCE BEFORE SHUTDOWN */
+	for (int i = 0; i < MESH_COUNT; ++i) {
+		deleteMesh(meshes[i]);
+		if (textures[i])
+			glDeleteTextures(1, &textures[i]);
+		textures[i] = 0;
+	}
+	for (GLuint texture : sceneTextures)
+		glDeleteTextures(1, &texture);
+	sceneTextures.clear();
+	materialTextures.clear();
+
+	partSource.reset();
+	materialSource.reset();
+	partMaterials.clear();
+	sharedMaterial = 0;
+
+	freeGpuRing(uniformRing);
+	freeGpuRing(instanceRing);
+	freeImpostor(impostor);
+	freePipelineStats();
+	for (MeshletMesh& meshletMesh : meshletMeshes)
+		deleteMeshletMesh(meshletMesh);
+	if (meshletTransforms)
+		glDeleteBuffers(1, &meshletTransforms);
+	meshletTransforms = 0;
+	if (irradianceTexture)
+		glDeleteTextures(1, &irradianceTexture);
+	irradianceTexture = 0;
+	freeFrameArenas();
+	freeAccumulation(accumulation);
+	freeDynamicResolution(dynamicResolution);
+
+	deleteShaderPrograms();
+}
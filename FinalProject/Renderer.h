@@ -0,0 +1,38 @@
+/* Description:
+Draws frame snapshots. Owns every GL resource of the scene
+(meshes, textures, shaders, uniform ring, draw list) and must
+only be called from the thread that owns the GL context.
+
+Material 0 is the built-in textures, materials 1 and up are
+a scene's (setSceneMaterials). Draws sort by material, so
+instances sharing one bind its textures once. Impostors are
+baked with material 0, and the meshlet path only runs while
+every instance uses the same material.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <string>
+
+#include "FrameSnapshot.h"
+#include "Scene.h"
+#include "HarmonicaGenerator.h"
+#include "IrradianceVolume.h"
+
+/* Constants */
+const int MAX_VIEWS = 16;	// Views renderViews() draws in a single pass through the viewport array
+const size_t MAX_MATERIALS = 1024;	// Materials the sort key can tell apart, the built-in one included
+
+/* Returns a newer camera than the snapshot's, if one exists (late latching) */
+typedef bool (*CameraLatch)(CameraSnapshot& camera);
+
+/* Renderer prototypes */
+void setSceneMaterials(const std::vector<SceneMaterial>& materials);
+void setHarmonicaShape(const HarmonicaParams& params);
+void setBakedLighting(const IrradianceVolume& volume);
+bool initRenderer();
+bool renderFrame(const FrameSnapshot& snapshot, CameraLatch latch = nullptr);
+bool pollRenderer(GLfloat time);
+bool rendererCompiling();
+bool renderViews(const FrameSnapshot& snapshot, const CameraSnapshot* cameras, int count, int columns, int tileWidth, int tileHeight);
+void shutdownRenderer();
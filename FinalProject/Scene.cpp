@@ -0,0 +1,644 @@
+#include "Scene.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "BinaryIO.h"
+
+using namespace std;
+
+/* Constants */
+const char SCENE_MAGIC[4] = { 'H', 'R', 'S', 'C' };
+const size_t INSTANCE_BYTES = sizeof(uint32_t) + 10 * sizeof(float);	// Binary instance record
+const char* PART_KEYS[SCENE_PART_COUNT] = { "reed", "cover", "comb" };
+
+/* Parsed JSON value */
+enum JsonType { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+struct JsonValue {
+	JsonType type = JSON_NULL;
+	bool boolean = false;
+	double number = 0.0;
+	string text;
+	vector<JsonValue> items;					// Array elements
+	vector<pair<string, JsonValue>> members;	// Object members in file order
+};
+
+/* Position in the text being parsed */
+struct JsonParser {
+	const char* p;
+	const char* end;
+	int line = 1;
+	string error;
+};
+
+static bool ParseValue(JsonParser& parser, JsonValue& value);
+
+// Skip white space and comments
+static void SkipSpace(JsonParser& parser)
+{
+	while (parser.p < parser.end) {
+		char c = *parser.p;
+		if (c == '\n') {
+			parser.line++;
+			parser.p++;
+		}
+		else if (c == ' ' || c == '\t' || c == '\r') {
+			parser.p++;
+		}
+		else if (c == '/' && parser.p + 1 < parser.end && parser.p[1] == '/') {
+			while (parser.p < parser.end && *parser.p != '\n')
+				parser.p++;
+		}
+		else if (c == '/' && parser.p + 1 < parser.end && parser.p[1] == '*') {
+			parser.p += 2;
+			while (parser.p + 1 < parser.end && !(parser.p[0] == '*' && parser.p[1] == '/')) {
+				if (*parser.p == '\n')
+					parser.line++;
+				parser.p++;
+			}
+			parser.p = min(parser.p + 2, parser.end);
+		}
+		else {
+			return;
+		}
+	}
+}
+
+// Record the first error, always false
+static bool Fail(JsonParser& parser, const string& message)
+{
+	if (parser.error.empty())
+		parser.error = "line " + to_string(parser.line) + ": " + message;
+	return false;
+}
+
+// Quoted string, escapes other than \uXXXX
+static bool ParseString(JsonParser& parser, string& text)
+{
+	parser.p++;
+	while (parser.p < parser.end && *parser.p != '"') {
+		char c = *parser.p++;
+		if (c == '\n')
+			return Fail(parser, "unterminated string");
+		if (c != '\\') {
+			text += c;
+			continue;
+		}
+
+		if (parser.p == parser.end)
+			break;
+		char escape = *parser.p++;
+		switch (escape) {
+		case 'n': text += '\n'; break;
+		case 't': text += '\t'; break;
+		case 'r': text += '\r'; break;
+		case 'b': text += '\b'; break;
+		case 'f': text += '\f'; break;
+		case '"': case '\\': case '/': text += escape; break;
+		default: return Fail(parser, string("unsupported escape \\") + escape);
+		}
+	}
+
+	if (parser.p == parser.end)
+		return Fail(parser, "unterminated string");
+	parser.p++;
+	return true;
+}
+
+// Elements or members up to the closing bracket, a trailing comma is allowed
+static bool ParseList(JsonParser& parser, JsonValue& value, char close)
+{
+	parser.p++;
+	for (;;) {
+		SkipSpace(parser);
+		if (parser.p < parser.end && *parser.p == close) {
+			parser.p++;
+			return true;
+		}
+
+		if (close == '}') {
+			string name;
+			if (parser.p == parser.end || *parser.p != '"' || !ParseString(parser, name))
+				return Fail(parser, "expected a member name");
+			SkipSpace(parser);
+			if (parser.p == parser.end || *parser.p++ != ':')
+				return Fail(parser, "expected ':' after \"" + name + "\"");
+			value.members.emplace_back(name, JsonValue());
+			if (!ParseValue(parser, value.members.back().second))
+				return false;
+		}
+		else {
+			value.items.emplace_back();
+			if (!ParseValue(parser, value.items.back()))
+				return false;
+		}
+
+		SkipSpace(parser);
+		if (parser.p < parser.end && *parser.p == ',')
+			parser.p++;
+		else if (parser.p == parser.end || *parser.p != close)
+			return Fail(parser, string("expected ',' or '") + close + "'");
+	}
+}
+
+// Any value
+static bool ParseValue(JsonParser& parser, JsonValue& value)
+{
+	SkipSpace(parser);
+	if (parser.p == parser.end)
+		return Fail(parser, "unexpected end of file");
+
+	char c = *parser.p;
+	if (c == '{') {
+		value.type = JSON_OBJECT;
+		return ParseList(parser, value, '}');
+	}
+	if (c == '[') {
+		value.type = JSON_ARRAY;
+		return ParseList(parser, value, ']');
+	}
+	if (c == '"') {
+		value.type = JSON_STRING;
+		return ParseString(parser, value.text);
+	}
+
+	// Literals
+	const char* words[] = { "true", "false", "null" };
+	for (const char* word : words) {
+		size_t length = strlen(word);
+		if ((size_t)(parser.end - parser.p) >= length && strncmp(parser.p, word, length) == 0) {
+			parser.p += length;
+			value.type = word[0] == 'n' ? JSON_NULL : JSON_BOOL;
+			value.boolean = word[0] == 't';
+			return true;
+		}
+	}
+
+	// Numbers; the text is null terminated, strtod stops at the first character that is not part of one
+	char* numberEnd = nullptr;
+	value.number = strtod(parser.p, &numberEnd);
+	if (numberEnd == parser.p)
+		return Fail(parser, string("unexpected '") + c + "'");
+	value.type = JSON_NUMBER;
+	parser.p = numberEnd;
+	return true;
+}
+
+// Member of an object, nullptr if missing
+static const JsonValue* Member(const JsonValue& object, const char* name)
+{
+	for (const pair<string, JsonValue>& member : object.members)
+		if (member.first == name)
+			return &member.second;
+	return nullptr;
+}
+
+// Array of N numbers
+static bool ReadFloats(const JsonValue* value, float* out, size_t count)
+{
+	if (!value || value->type != JSON_ARRAY || value->items.size() != count)
+		return false;
+	for (size_t i = 0; i < count; ++i) {
+		if (value->items[i].type != JSON_NUMBER)
+			return false;
+		out[i] = (float)value->items[i].number;
+	}
+	return true;
+}
+
+// Optional vector member, false if present but malformed
+static bool ReadVec3(const JsonValue& object, const char* name, glm::vec3& out)
+{
+	const JsonValue* value = Member(object, name);
+	return !value || ReadFloats(value, &out.x, 3);
+}
+
+// Optional string member
+static void ReadString(const JsonValue& object, const char* name, string& out)
+{
+	const JsonValue* value = Member(object, name);
+	if (value && value->type == JSON_STRING)
+		out = value->text;
+}
+
+// Optional number member
+static void ReadNumber(const JsonValue& object, const char* name, float& out)
+{
+	const JsonValue* value = Member(object, name);
+	if (value && value->type == JSON_NUMBER)
+		out = (float)value->number;
+}
+
+// Elements of an optional array member
+static const vector<JsonValue>& Items(const JsonValue& object, const char* name)
+{
+	static const vector<JsonValue> none;
+	const JsonValue* value = Member(object, name);
+	return value && value->type == JSON_ARRAY ? value->items : none;
+}
+
+// Fill the scene from a parsed document, instances in file order
+static bool SceneFromJson(Scene& scene, const JsonValue& root)
+{
+	if (root.type != JSON_OBJECT) {
+		cout << scene.path << ": expected an object" << endl;
+		return false;
+	}
+
+	ReadNumber(root, "chunkSize", scene.chunkSize);
+	if (!(scene.chunkSize > 0.0f)) {
+		cout << scene.path << ": chunkSize must be positive" << endl;
+		return false;
+	}
+
+	for (const JsonValue& item : Items(root, "materials")) {
+		SceneMaterial material;
+		ReadString(item, "name", material.name);
+		for (int i = 0; i < SCENE_PART_COUNT; ++i)
+			ReadString(item, PART_KEYS[i], material.textures[i]);
+		scene.materials.push_back(material);
+	}
+
+	for (const JsonValue& item : Items(root, "meshes")) {
+		SceneMesh mesh;
+		ReadString(item, "name", mesh.name);
+		ReadString(item, "material", mesh.material);
+		scene.meshes.push_back(mesh);
+	}
+
+	// A scene without a mesh table places harmonicas
+	if (scene.meshes.empty()) {
+		SceneMesh harmonica;
+		harmonica.name = "harmonica";
+		scene.meshes.push_back(harmonica);
+	}
+
+	for (const JsonValue& item : Items(root, "lights")) {
+		SceneLight light = { glm::vec3(0.0f), glm::vec3(1.0f) };
+		if (!ReadVec3(item, "position", light.position) || !ReadVec3(item, "color", light.color)) {
+			cout << scene.path << ": light " << scene.lights.size() << " needs [x, y, z] position and [r, g, b] color" << endl;
+			return false;
+		}
+		scene.lights.push_back(light);
+	}
+
+	for (const JsonValue& item : Items(root, "cameras")) {
+		SceneCamera camera;
+		ReadString(item, "name", camera.name);
+		ReadNumber(item, "fov", camera.fov);
+		const JsonValue* ortho = Member(item, "ortho");
+		camera.ortho = ortho && ortho->type == JSON_BOOL && ortho->boolean;
+		if (!ReadVec3(item, "position", camera.position) || !ReadVec3(item, "target", camera.target)) {
+			cout << scene.path << ": camera " << scene.cameras.size() << " needs [x, y, z] position and target" << endl;
+			return false;
+		}
+		scene.cameras.push_back(camera);
+	}
+
+	const vector<JsonValue>& instances = Items(root, "instances");
+	scene.instances.reserve(instances.size());
+	for (const JsonValue& item : instances) {
+		SceneInstance instance;
+		float mesh = 0.0f;
+		ReadNumber(item, "mesh", mesh);
+		instance.mesh = mesh >= 0.0f ? (uint32_t)mesh : UINT32_MAX;
+
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		const JsonValue* rotationValue = Member(item, "rotation");
+		bool valid = instance.mesh < scene.meshes.size() &&
+			ReadVec3(item, "position", instance.position) && ReadVec3(item, "scale", instance.scale) &&
+			(!rotationValue || ReadFloats(rotationValue, rotation, 4));
+		if (!valid) {
+			cout << scene.path << ": instance " << scene.instances.size() << " has an unknown mesh or a malformed transform" << endl;
+			return false;
+		}
+
+		instance.rotation = glm::normalize(glm::quat(rotation[3], rotation[0], rotation[1], rotation[2]));
+		scene.instances.push_back(instance);
+	}
+
+	return true;
+}
+
+// Sort the instances into grid cells and describe every non-empty cell as a chunk
+void chunkScene(Scene& scene)
+{
+	size_t count = scene.instances.size();
+	vector<glm::ivec3> cells(count);
+	vector<uint32_t> order(count);
+	for (size_t i = 0; i < count; ++i) {
+		cells[i] = glm::ivec3(glm::floor(scene.instances[i].position / scene.chunkSize));
+		order[i] = (uint32_t)i;
+	}
+
+	// Stable, instances keep their file order within a chunk
+	stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		const glm::ivec3& ca = cells[a];
+		const glm::ivec3& cb = cells[b];
+		return ca.x != cb.x ? ca.x < cb.x : ca.y != cb.y ? ca.y < cb.y : ca.z < cb.z;
+	});
+
+	vector<SceneInstance> sorted(count);
+	scene.chunks.clear();
+	for (size_t i = 0; i < count; ++i) {
+		const SceneInstance& instance = scene.instances[order[i]];
+		sorted[i] = instance;
+
+		const glm::ivec3& cell = cells[order[i]];
+		if (scene.chunks.empty() || cell != glm::ivec3(scene.chunks.back().cell[0], scene.chunks.back().cell[1], scene.chunks.back().cell[2])) {
+			SceneChunk chunk;
+			chunk.cell[0] = cell.x;
+			chunk.cell[1] = cell.y;
+			chunk.cell[2] = cell.z;
+			chunk.low = chunk.high = instance.position;
+			chunk.first = (uint32_t)i;
+			scene.chunks.push_back(chunk);
+		}
+
+		SceneChunk& chunk = scene.chunks.back();
+		chunk.low = glm::min(chunk.low, instance.position);
+		chunk.high = glm::max(chunk.high, instance.position);
+		chunk.count++;
+	}
+
+	scene.instances.swap(sorted);
+	scene.instanceCount = (uint32_t)count;
+}
+
+// Parse a JSON scene
+static bool LoadJsonScene(Scene& scene, const string& path)
+{
+	ifstream file(path, ios::binary);
+	stringstream contents;
+	contents << file.rdbuf();
+	string text = contents.str();
+
+	JsonParser parser;
+	parser.p = text.c_str();
+	parser.end = parser.p + text.size();
+	JsonValue root;
+	if (!ParseValue(parser, root)) {
+		cout << path << ": " << parser.error << endl;
+		return false;
+	}
+
+	SkipSpace(parser);
+	if (parser.p != parser.end) {
+		Fail(parser, "unexpected text after the scene");
+		cout << path << ": " << parser.error << endl;
+		return false;
+	}
+
+	if (!SceneFromJson(scene, root))
+		return false;
+	chunkScene(scene);
+	return true;
+}
+
+// Length-prefixed string
+static void WriteString(FILE* file, const string& text)
+{
+	uint16_t length = (uint16_t)min(text.size(), (size_t)UINT16_MAX);
+	writeField(file, length);
+	fwrite(text.data(), 1, length, file);
+}
+
+static bool ReadString(FILE* file, string& text)
+{
+	uint16_t length = 0;
+	if (!readField(file, length))
+		return false;
+	text.resize(length);
+	return length == 0 || fread(&text[0], 1, length, file) == length;
+}
+
+static void WriteVec3(FILE* file, const glm::vec3& v)
+{
+	fwrite(&v.x, sizeof(float), 3, file);
+}
+
+static bool ReadVec3(FILE* file, glm::vec3& v)
+{
+	return fread(&v.x, sizeof(float), 3, file) == 3;
+}
+
+// Read the tables of a binary scene, the instances stay in the file
+static bool LoadBinaryScene(Scene& scene, FILE* file)
+{
+	uint32_t version = 0, materialCount = 0, meshCount = 0, lightCount = 0, cameraCount = 0, chunkCount = 0;
+	bool valid = readField(file, version) && version == SCENE_FILE_VERSION && readField(file, scene.chunkSize) &&
+		readField(file, materialCount) && readField(file, meshCount) && readField(file, lightCount) && readField(file, cameraCount) &&
+		readField(file, chunkCount) && readField(file, scene.instanceCount);
+
+	scene.materials.resize(valid ? materialCount : 0);
+	for (SceneMaterial& material : scene.materials) {
+		valid = valid && ReadString(file, material.name);
+		for (string& texture : material.textures)
+			valid = valid && ReadString(file, texture);
+	}
+
+	scene.meshes.resize(valid ? meshCount : 0);
+	for (SceneMesh& mesh : scene.meshes)
+		valid = valid && ReadString(file, mesh.name) && ReadString(file, mesh.material);
+
+	scene.lights.resize(valid ? lightCount : 0);
+	for (SceneLight& light : scene.lights)
+		valid = valid && ReadVec3(file, light.position) && ReadVec3(file, light.color);
+
+	scene.cameras.resize(valid ? cameraCount : 0);
+	for (SceneCamera& camera : scene.cameras) {
+		uint8_t ortho = 0;
+		valid = valid && ReadString(file, camera.name) && ReadVec3(file, camera.position) && ReadVec3(file, camera.target) &&
+			readField(file, camera.fov) && readField(file, ortho);
+		camera.ortho = ortho != 0;
+	}
+
+	scene.chunks.resize(valid ? chunkCount : 0);
+	for (SceneChunk& chunk : scene.chunks) {
+		valid = valid && fread(chunk.cell, sizeof(int32_t), 3, file) == 3 && ReadVec3(file, chunk.low) && ReadVec3(file, chunk.high) &&
+			readField(file, chunk.first) && readField(file, chunk.count);
+		valid = valid && (uint64_t)chunk.first + chunk.count <= scene.instanceCount;
+	}
+
+	if (!valid) {
+		cout << scene.path << " is not a scene file (or has an unsupported version)" << endl;
+		return false;
+	}
+
+	scene.instanceOffset = ftell(file);
+	scene.binary = true;
+	return true;
+}
+
+// Load a scene, binary or JSON (told apart by the binary header)
+bool loadScene(Scene& scene, const string& path)
+{
+	scene = Scene();
+	scene.path = path;
+
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		cout << "Could not open scene " << path << endl;
+		return false;
+	}
+
+	char magic[4] = {};
+	bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, SCENE_MAGIC, sizeof(magic)) == 0;
+	bool ok = binary ? LoadBinaryScene(scene, file) : false;
+	fclose(file);
+
+	if (!binary)
+		ok = LoadJsonScene(scene, path);
+	if (ok)
+		cout << "Scene " << path << ": " << scene.instanceCount << " instances in " << scene.chunks.size() << " chunks" << endl;
+	return ok;
+}
+
+// Write the scene in binary form, reading the instances of a binary scene back from its own file
+bool saveSceneBinary(const Scene& scene, const string& path)
+{
+	FILE* source = nullptr;
+	if (scene.binary && !(source = fopen(scene.path.c_str(), "rb"))) {
+		cout << "Could not reopen scene " << scene.path << endl;
+		return false;
+	}
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		cout << "Could not create scene " << path << endl;
+		if (source)
+			fclose(source);
+		return false;
+	}
+
+	fwrite(SCENE_MAGIC, 1, sizeof(SCENE_MAGIC), file);
+	writeField<uint32_t>(file, SCENE_FILE_VERSION);
+	writeField<float>(file, scene.chunkSize);
+	writeField<uint32_t>(file, (uint32_t)scene.materials.size());
+	writeField<uint32_t>(file, (uint32_t)scene.meshes.size());
+	writeField<uint32_t>(file, (uint32_t)scene.lights.size());
+	writeField<uint32_t>(file, (uint32_t)scene.cameras.size());
+	writeField<uint32_t>(file, (uint32_t)scene.chunks.size());
+	writeField<uint32_t>(file, scene.instanceCount);
+
+	for (const SceneMaterial& material : scene.materials) {
+		WriteString(file, material.name);
+		for (const string& texture : material.textures)
+			WriteString(file, texture);
+	}
+	for (const SceneMesh& mesh : scene.meshes) {
+		WriteString(file, mesh.name);
+		WriteString(file, mesh.material);
+	}
+	for (const SceneLight& light : scene.lights) {
+		WriteVec3(file, light.position);
+		WriteVec3(file, light.color);
+	}
+	for (const SceneCamera& camera : scene.cameras) {
+		WriteString(file, camera.name);
+		WriteVec3(file, camera.position);
+		WriteVec3(file, camera.target);
+		writeField<float>(file, camera.fov);
+		writeField<uint8_t>(file, camera.ortho ? 1 : 0);
+	}
+	for (const SceneChunk& chunk : scene.chunks) {
+		fwrite(chunk.cell, sizeof(int32_t), 3, file);
+		WriteVec3(file, chunk.low);
+		WriteVec3(file, chunk.high);
+		writeField<uint32_t>(file, chunk.first);
+		writeField<uint32_t>(file, chunk.count);
+	}
+
+	// Instances one chunk at a time, chunks are contiguous and in order
+	vector<SceneInstance> instances;
+	bool ok = true;
+	for (const SceneChunk& chunk : scene.chunks) {
+		if (!readSceneChunk(scene, source, chunk, instances)) {
+			ok = false;
+			break;
+		}
+		for (const SceneInstance& instance : instances) {
+			writeField<uint32_t>(file, instance.mesh);
+			WriteVec3(file, instance.position);
+			writeField<float>(file, instance.rotation.x);
+			writeField<float>(file, instance.rotation.y);
+			writeField<float>(file, instance.rotation.z);
+			writeField<float>(file, instance.rotation.w);
+			WriteVec3(file, instance.scale);
+		}
+	}
+
+	ok = ok && !ferror(file);
+	fclose(file);
+	if (source)
+		fclose(source);
+	if (!ok)
+		cout << "Could not write scene " << path << endl;
+	return ok;
+}
+
+// Instances of one chunk; binary scenes read them from file, an open handle to the scene's file
+bool readSceneChunk(const Scene& scene, FILE* file, const SceneChunk& chunk, vector<SceneInstance>& instances)
+{
+	instances.resize(chunk.count);
+	if (!scene.binary) {
+		copy(scene.instances.begin() + chunk.first, scene.instances.begin() + chunk.first + chunk.count, instances.begin());
+		return true;
+	}
+
+	// One read for the whole chunk, then unpacked
+	vector<unsigned char> records(chunk.count * INSTANCE_BYTES);
+	if (!file || fseek(file, scene.instanceOffset + (long)(chunk.first * INSTANCE_BYTES), SEEK_SET) != 0 ||
+		fread(records.data(), 1, records.size(), file) != records.size())
+		return false;
+
+	for (uint32_t i = 0; i < chunk.count; ++i) {
+		const unsigned char* record = &records[i * INSTANCE_BYTES];
+		float values[10];
+		SceneInstance& instance = instances[i];
+		memcpy(&instance.mesh, record, sizeof(uint32_t));
+		memcpy(values, record + sizeof(uint32_t), sizeof(values));
+		instance.position = glm::vec3(values[0], values[1], values[2]);
+		instance.rotation = glm::quat(values[6], values[3], values[4], values[5]);
+		instance.scale = glm::vec3(values[7], values[8], values[9]);
+	}
+	return true;
+}
+
+// Material of a mesh, nullptr for the built-in textures
+const SceneMaterial* sceneMeshMaterial(const Scene& scene, uint32_t mesh)
+{
+	if (mesh >= scene.meshes.size() || scene.meshes[mesh].material.empty())
+		return nullptr;
+
+	for (const SceneMaterial& material : scene.materials)
+		if (material.name == scene.meshes[mesh].material)
+			return &material;
+	return nullptr;
+}
+
+// Renderer material of a mesh: 0 for the built-in textures, else 1 + the index of its material
+uint16_t sceneMeshMaterialId(const Scene& scene, uint32_t mesh)
+{
+	const SceneMaterial* material = sceneMeshMaterial(scene, mesh);
+	return material ? (uint16_t)(material - scene.materials.data() + 1) : 0;
+}
+
+// Bounds of every instance position, false for an empty scene
+bool sceneBounds(const Scene& scene, glm::vec3& low, glm::vec3& high)
+{
+	if (scene.chunks.empty())
+		return false;
+
+	low = scene.chunks[0].low;
+	high = scene.chunks[0].high;
+	for (const SceneChunk& chunk : scene.chunks) {
+		low = glm::min(low, chunk.low);
+		high = glm::max(high, chunk.high);
+	}
+	return true;
+}
@@ -0,0 +1,119 @@
+/* Description:
+Scene description files: the meshes, materials, instances,
+lights and cameras the application starts with, instead of
+the single harmonica built into main().
+
+Two forms hold the same scene:
+	.json	Human-readable. Plain JSON, plus // comments and
+			trailing commas. Parsed whole on load.
+	binary	Tables up front, then the instances grouped by
+			chunk. Loading reads only the tables; instances are
+			read a chunk at a time (see SceneStream.h).
+
+JSON layout (every section optional):
+	{
+		"chunkSize": 32,
+		"materials": [ { "name": "brass", "reed": "brass1024.jpg", "cover": "silver.jpg", "comb": "burl2.jpg" } ],
+		"meshes": [ { "name": "harmonica", "material": "brass" } ],
+		"lights": [ { "position": [0, 0, 5], "color": [0, 0, 1] } ],
+		"cameras": [ { "name": "front", "position": [0, 0, 10], "target": [0, 0, 0], "fov": 45, "ortho": false } ],
+		"instances": [ { "mesh": 0, "position": [0, 0, 0], "rotation": [0, 0, 0, 1], "scale": [1, 1, 1] } ]
+	}
+Rotations are quaternions x, y, z, w; "mesh" indexes
+"meshes". The only mesh the renderer can draw is
+"harmonica", instances of other meshes are skipped. Each
+instance is drawn with the material of its mesh.
+
+Instances are split into chunks, the cells of a grid of
+chunkSize world units, so the parts of a large scene near
+the camera can be loaded first.
+
+Binary layout (native byte order, strings are u16 length + bytes):
+	header:		"HRSC" | version u32 | chunkSize f32 | materials u32 | meshes u32 | lights u32 | cameras u32 | chunks u32 | instances u32
+	material:	name str | reed str | cover str | comb str
+	mesh:		name str | material str
+	light:		position 3*f32 | color 3*f32
+	camera:		name str | position 3*f32 | target 3*f32 | fov f32 | ortho u8
+	chunk:		cell 3*i32 | low 3*f32 | high 3*f32 | first u32 | count u32
+	instance:	mesh u32 | position 3*f32 | rotation 4*f32 | scale 3*f32	(chunk order)
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* Constants */
+const uint32_t SCENE_FILE_VERSION = 1;
+const float SCENE_CHUNK_SIZE = 32.0f;	// Default chunk edge in world units
+const int SCENE_PART_COUNT = 3;			// Textured harmonica parts: reed, cover, comb
+
+/* Textures of the harmonica parts */
+struct SceneMaterial {
+	std::string name;
+	std::string textures[SCENE_PART_COUNT];	// Reed, cover, comb; empty keeps the built-in texture
+};
+
+/* Mesh an instance draws */
+struct SceneMesh {
+	std::string name;
+	std::string material;		// Empty for the built-in textures
+};
+
+/* One placed mesh */
+struct SceneInstance {
+	uint32_t mesh = 0;
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::quat rotation;
+	glm::vec3 scale = glm::vec3(1.0f);
+};
+
+/* Point light */
+struct SceneLight {
+	glm::vec3 position;
+	glm::vec3 color;
+};
+
+/* Orbit camera looking at a target */
+struct SceneCamera {
+	std::string name;
+	glm::vec3 position = glm::vec3(0.0f, 0.0f, 10.0f);
+	glm::vec3 target = glm::vec3(0.0f);
+	float fov = 45.0f;
+	bool ortho = false;
+};
+
+/* Instances of one grid cell */
+struct SceneChunk {
+	int32_t cell[3];
+	glm::vec3 low, high;		// Bounds of the instance positions
+	uint32_t first = 0;			// Index of the chunk's first instance
+	uint32_t count = 0;
+};
+
+/* Whole scene; instances stay in the file for binary scenes */
+struct Scene {
+	float chunkSize = SCENE_CHUNK_SIZE;
+	std::vector<SceneMaterial> materials;
+	std::vector<SceneMesh> meshes;
+	std::vector<SceneLight> lights;
+	std::vector<SceneCamera> cameras;
+	std::vector<SceneChunk> chunks;
+	std::vector<SceneInstance> instances;	// Chunk order, empty when streamed from a binary file
+	uint32_t instanceCount = 0;
+	std::string path;
+	bool binary = false;
+	long instanceOffset = 0;	// Binary: file offset of the first instance
+};
+
+/* Scene prototypes */
+bool loadScene(Scene& scene, const std::string& path);
+void chunkScene(Scene& scene);
+bool saveSceneBinary(const Scene& scene, const std::string& path);
+bool readSceneChunk(const Scene& scene, FILE* file, const SceneChunk& chunk, std::vector<SceneInstance>& instances);
+const SceneMaterial* sceneMeshMaterial(const Scene& scene, uint32_t mesh);
+uint16_t sceneMeshMaterialId(const Scene& scene, uint32_t mesh);
+bool sceneBounds(const Scene& scene, glm::vec3& low, glm::vec3& high);
@@ -0,0 +1,147 @@
+#include "SceneGenerator.h"
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+/* Constants */
+const char* GENERATOR_TEXTURES[] = { "brass1024.jpg", "silver.jpg", "burl2.jpg", "wood1024.jpg" };
+const uint32_t TEXTURE_COUNT = 4;
+const char* DISTRIBUTION_NAMES[DISTRIBUTION_COUNT] = { "uniform", "grid", "clusters", "floor" };
+const float MIN_SCALE = 0.75f;			// Random uniform scale range of the scattered distributions
+const float MAX_SCALE = 1.25f;
+const float CAMERA_FOV = 45.0f;
+
+// Uniformly distributed rotation (Shoemake)
+static glm::quat RandomRotation(mt19937& random)
+{
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float u1 = unit(random), u2 = unit(random) * glm::two_pi<float>(), u3 = unit(random) * glm::two_pi<float>();
+	float a = sqrtf(1.0f - u1), b = sqrtf(u1);
+	return glm::quat(b * cosf(u3), a * sinf(u2), a * cosf(u2), b * sinf(u3));
+}
+
+// Place the instances, each picking one of the meshes (one per material)
+static void PlaceInstances(Scene& scene, const SceneGeneratorSettings& settings, mt19937& random)
+{
+	uint32_t count = settings.instances;
+	float half = 0.5f * cbrtf((float)count) * GENERATOR_SPACING;
+	uniform_real_distribution<float> side(-half, half);
+	uniform_real_distribution<float> scale(MIN_SCALE, MAX_SCALE);
+	uniform_int_distribution<uint32_t> mesh(0, (uint32_t)scene.meshes.size() - 1);
+
+	// Cluster centers share the cube, each cluster is about as dense as the uniform scene
+	vector<glm::vec3> centers;
+	float spread = 0.5f * cbrtf((float)CLUSTER_SIZE) * GENERATOR_SPACING;
+	if (settings.distribution == DISTRIBUTION_CLUSTERS) {
+		centers.resize(max(1u, count / CLUSTER_SIZE));
+		for (glm::vec3& center : centers)
+			center = glm::vec3(side(random), side(random), side(random));
+	}
+	normal_distribution<float> offset(0.0f, spread * 0.5f);
+	uniform_int_distribution<size_t> cluster(0, max((size_t)1, centers.size()) - 1);
+
+	// Lattice and floor are sized for their own dimensions
+	uint32_t lattice = (uint32_t)ceilf(cbrtf((float)count));
+	float floorHalf = 0.5f * sqrtf((float)count) * GENERATOR_SPACING;
+	uniform_real_distribution<float> floorSide(-floorHalf, floorHalf);
+	uniform_real_distribution<float> yaw(0.0f, glm::two_pi<float>());
+
+	scene.instances.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		SceneInstance& instance = scene.instances[i];
+		instance.mesh = mesh(random);
+
+		switch (settings.distribution) {
+		case DISTRIBUTION_GRID:
+			instance.position = (glm::vec3((float)(i % lattice), (float)(i / lattice % lattice), (float)(i / (lattice * lattice))) -
+				glm::vec3((lattice - 1) * 0.5f)) * GENERATOR_SPACING;
+			continue;
+		case DISTRIBUTION_CLUSTERS:
+			instance.position = centers[cluster(random)] + glm::vec3(offset(random), offset(random), offset(random));
+			break;
+		case DISTRIBUTION_FLOOR:
+			instance.position = glm::vec3(floorSide(random), 0.0f, floorSide(random));
+			instance.rotation = glm::angleAxis(yaw(random), glm::vec3(0.0f, 1.0f, 0.0f));
+			instance.scale = glm::vec3(scale(random));
+			continue;
+		default:
+			instance.position = glm::vec3(side(random), side(random), side(random));
+			break;
+		}
+
+		instance.rotation = RandomRotation(random);
+		instance.scale = glm::vec3(scale(random));
+	}
+}
+
+// Fill scene with a generated one, instances in memory and split into chunks
+void generateScene(Scene& scene, const SceneGeneratorSettings& settings)
+{
+	scene = Scene();
+	scene.chunkSize = settings.chunkSize;
+	scene.path = "generated";
+	mt19937 random(settings.seed);
+
+	// Every material is a mix of the project's textures, the first is the built-in mix
+	uint32_t materials = max(1u, settings.materials);
+	for (uint32_t k = 0; k < materials; ++k) {
+		SceneMaterial material;
+		material.name = "material" + to_string(k);
+		material.textures[0] = GENERATOR_TEXTURES[k % TEXTURE_COUNT];
+		material.textures[1] = GENERATOR_TEXTURES[(1 + k / TEXTURE_COUNT) % TEXTURE_COUNT];
+		material.textures[2] = GENERATOR_TEXTURES[(2 + k / (TEXTURE_COUNT * TEXTURE_COUNT)) % TEXTURE_COUNT];
+		scene.materials.push_back(material);
+
+		SceneMesh mesh;
+		mesh.name = "harmonica";
+		mesh.material = material.name;
+		scene.meshes.push_back(mesh);
+	}
+
+	PlaceInstances(scene, settings, random);
+	chunkScene(scene);
+
+	glm::vec3 low(0.0f), high(0.0f);
+	sceneBounds(scene, low, high);
+	glm::vec3 center = (low + high) * 0.5f;
+	float radius = max(glm::length(high - low) * 0.5f, GENERATOR_SPACING);
+
+	// Lights scattered through the volume and a little above it, saturated random colors
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (uint32_t i = 0; i < settings.lights; ++i) {
+		SceneLight light;
+		light.position = low + (high - low) * glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, GENERATOR_SPACING, 0.0f);
+		light.color = glm::vec3(unit(random), unit(random), unit(random));
+		light.color /= max(light.color.x, max(light.color.y, max(light.color.z, 0.001f)));
+		scene.lights.push_back(light);
+	}
+
+	// Whole bounding sphere in view, from the front and a little above
+	SceneCamera camera;
+	camera.name = "overview";
+	camera.fov = CAMERA_FOV;
+	camera.target = center;
+	camera.position = center + glm::normalize(glm::vec3(0.0f, 0.35f, 1.0f)) * (radius / sinf(glm::radians(CAMERA_FOV) * 0.5f));
+	scene.cameras.push_back(camera);
+}
+
+// Distribution from its name
+bool parseSceneDistribution(const string& name, SceneDistribution& distribution)
+{
+	for (int i = 0; i < DISTRIBUTION_COUNT; ++i) {
+		if (name == DISTRIBUTION_NAMES[i]) {
+			distribution = (SceneDistribution)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Name of a distribution
+const char* sceneDistributionName(SceneDistribution distribution)
+{
+	return distribution >= 0 && distribution < DISTRIBUTION_COUNT ? DISTRIBUTION_NAMES[distribution] : "unknown";
+}
@@ -0,0 +1,53 @@
+/* Description:
+Synthetic scenes for scaling benchmarks: N harmonica
+instances filling a volume, M lights and a number of
+materials, reproducible from a seed.
+
+Distributions:
+	uniform		Random positions in a cube
+	grid		Regular lattice, no rotation or scale (the
+				friendliest case for sorting and culling)
+	clusters	Gaussian blobs around random centers, about
+				CLUSTER_SIZE instances each
+	floor		Random positions on a plane, like a showroom
+
+Density is constant: the volume grows with N so instances
+stay about GENERATOR_SPACING apart. Materials combine the
+four textures in the project folder on the reed, cover and
+comb, material 0 being the built-in one. The scene's camera
+looks at the whole volume from outside it.
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Scene.h"
+
+/* Constants */
+const float GENERATOR_SPACING = 6.0f;		// Average distance between neighbouring instances
+const uint32_t CLUSTER_SIZE = 1000;			// Instances per cluster of the clusters distribution
+
+/* Placement of the instances */
+enum SceneDistribution {
+	DISTRIBUTION_UNIFORM = 0,
+	DISTRIBUTION_GRID,
+	DISTRIBUTION_CLUSTERS,
+	DISTRIBUTION_FLOOR,
+	DISTRIBUTION_COUNT
+};
+
+/* What to generate */
+struct SceneGeneratorSettings {
+	uint32_t instances = 1000;
+	uint32_t lights = 3;
+	uint32_t materials = 1;
+	SceneDistribution distribution = DISTRIBUTION_UNIFORM;
+	uint32_t seed = 1;
+	float chunkSize = SCENE_CHUNK_SIZE;
+};
+
+/* Scene generator prototypes */
+void generateScene(Scene& scene, const SceneGeneratorSettings& settings);
+bool parseSceneDistribution(const std::string& name, SceneDistribution& distribution);
+const char* sceneDistributionName(SceneDistribution distribution);
@@ -0,0 +1,198 @@
+#include "SceneStream.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+/* Constants */
+const float REFOCUS_FRACTION = 0.25f;	// Camera moves under this fraction of a chunk don't wake the thread
+
+// Distance from a point to the bounds of a chunk's instances, 0 inside
+static float ChunkDistance(const SceneChunk& chunk, const glm::vec3& point)
+{
+	glm::vec3 nearest = glm::clamp(point, chunk.low, chunk.high);
+	return glm::length(point - nearest);
+}
+
+// Collect the drawable instances of every resident chunk into a new list and hand it to the main thread
+static void Publish(SceneStream& stream)
+{
+	size_t count = 0;
+	for (size_t c : stream.loadOrder)
+		count += stream.resident[c].size();
+
+	shared_ptr<TransformSoA> list = make_shared<TransformSoA>();
+	shared_ptr<vector<uint16_t>> materials = make_shared<vector<uint16_t>>();
+	for (vector<float>* component : { &list->px, &list->py, &list->pz, &list->qx, &list->qy, &list->qz, &list->qw, &list->sx, &list->sy, &list->sz })
+		component->reserve(count);
+	materials->reserve(count);
+
+	for (size_t c : stream.loadOrder) {
+		for (const SceneInstance& instance : stream.resident[c]) {
+			if (instance.mesh < stream.drawable.size() && stream.drawable[instance.mesh]) {
+				addTransform(*list, instance.position, instance.rotation, instance.scale);
+				materials->push_back(stream.meshMaterials[instance.mesh]);
+			}
+		}
+	}
+
+	lock_guard<mutex> lock(stream.mutex);
+	stream.published = list;
+	stream.publishedMaterials = materials;
+}
+
+// Load and drop chunks as the camera moves, until asked to quit
+static void StreamThread(SceneStream* stream)
+{
+	const Scene& scene = *stream->scene;
+	FILE* file = nullptr;
+	if (scene.binary && !(file = fopen(scene.path.c_str(), "rb"))) {
+		cout << "Could not reopen scene " << scene.path << " for streaming" << endl;
+		return;
+	}
+
+	auto start = chrono::steady_clock::now();
+	bool first = true;
+	bool pending = true;	// Chunks in range are still waiting to be loaded
+	vector<pair<float, size_t>> wanted;
+	for (;;) {
+		glm::vec3 focus;
+		{
+			// Sleep until the camera moves once everything in range is loaded
+			unique_lock<mutex> lock(stream->mutex);
+			stream->wake.wait(lock, [&] { return stream->quit || stream->moved || pending; });
+			if (stream->quit)
+				break;
+			focus = stream->focus;
+			stream->moved = false;
+		}
+
+		// Drop chunks well out of range, queue the missing ones in range nearest first
+		bool changed = false;
+		float unloadRadius = stream->loadRadius * SCENE_UNLOAD_FACTOR;
+		wanted.clear();
+		for (size_t c = 0; c < scene.chunks.size(); ++c) {
+			float distance = ChunkDistance(scene.chunks[c], focus);
+			if (stream->loaded[c] && distance > unloadRadius) {
+				vector<SceneInstance>().swap(stream->resident[c]);
+				stream->loaded[c] = 0;
+				stream->loadOrder.erase(find(stream->loadOrder.begin(), stream->loadOrder.end(), c));
+				changed = true;
+			}
+			else if (!stream->loaded[c] && distance <= stream->loadRadius) {
+				wanted.emplace_back(distance, c);
+			}
+		}
+		sort(wanted.begin(), wanted.end());
+
+		// One batch, then publish and look at the camera again
+		uint32_t batch = 0;
+		size_t next = 0;
+		for (; next < wanted.size() && batch < STREAM_BATCH_INSTANCES; ++next) {
+			size_t c = wanted[next].second;
+			if (!readSceneChunk(scene, file, scene.chunks[c], stream->resident[c])) {
+				cout << "Could not read chunk " << c << " of " << scene.path << endl;
+				stream->resident[c].clear();
+			}
+			stream->loaded[c] = 1;
+			stream->loadOrder.push_back(c);
+			batch += scene.chunks[c].count;
+			changed = true;
+		}
+		pending = next < wanted.size();
+
+		if (changed) {
+			Publish(*stream);
+			if (first) {
+				first = false;
+				double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+				cout << "First " << batch << " scene instances streamed in " << ms << "ms" << endl;
+			}
+		}
+	}
+
+	if (file)
+		fclose(file);
+}
+
+// Start loading the chunks around focus
+bool startSceneStream(SceneStream& stream, const Scene& scene, const glm::vec3& focus, float loadRadius)
+{
+	stream.scene = &scene;
+	stream.loadRadius = loadRadius;
+	stream.focus = focus;
+	stream.moved = false;
+	stream.quit = false;
+	stream.published = nullptr;
+	stream.publishedMaterials = nullptr;
+	stream.resident.assign(scene.chunks.size(), vector<SceneInstance>());
+	stream.loaded.assign(scene.chunks.size(), 0);
+	stream.loadOrder.clear();
+
+	// The renderer only has the harmonica
+	stream.drawable.assign(scene.meshes.size(), 0);
+	stream.meshMaterials.assign(scene.meshes.size(), 0);
+	for (size_t i = 0; i < scene.meshes.size(); ++i) {
+		stream.drawable[i] = scene.meshes[i].name == "harmonica";
+		stream.meshMaterials[i] = sceneMeshMaterialId(scene, (uint32_t)i);
+		if (!stream.drawable[i])
+			cout << "Scene mesh " << scene.meshes[i].name << " is not drawable, its instances are skipped" << endl;
+	}
+
+	stream.thread = thread(StreamThread, &stream);
+	return true;
+}
+
+// Report the camera position, wakes the thread once it moved a fraction of a chunk
+void updateSceneStream(SceneStream& stream, const glm::vec3& focus)
+{
+	if (!stream.scene)
+		return;
+
+	lock_guard<mutex> lock(stream.mutex);
+	if (glm::length(focus - stream.focus) < stream.scene->chunkSize * REFOCUS_FRACTION)
+		return;
+	stream.focus = focus;
+	stream.moved = true;
+	stream.wake.notify_one();
+}
+
+// Take the newest published list and its materials, false if nothing changed since the last call
+bool pollSceneStream(SceneStream& stream, shared_ptr<const TransformSoA>& instances, shared_ptr<const vector<uint16_t>>& materials)
+{
+	if (!stream.scene)
+		return false;
+
+	lock_guard<mutex> lock(stream.mutex);
+	if (!stream.published)
+		return false;
+	instances = stream.published;
+	materials = stream.publishedMaterials;
+	stream.published = nullptr;
+	stream.publishedMaterials = nullptr;
+	return true;
+}
+
+// Stop the thread and free the loaded chunks
+void stopSceneStream(SceneStream& stream)
+{
+	if (!stream.scene)
+		return;
+
+	{
+		lock_guard<mutex> lock(stream.mutex);
+		stream.quit = true;
+	}
+	stream.wake.notify_one();
+	if (stream.thread.joinable())
+		stream.thread.join();
+
+	stream.resident.clear();
+	stream.loaded.clear();
+	stream.loadOrder.clear();
+	stream.published = nullptr;
+	stream.publishedMaterials = nullptr;
+	stream.scene = nullptr;
+}
@@ -0,0 +1,64 @@
+/* Description:
+Loads the chunks of a scene around the camera on a background
+thread. Every frame the main thread reports where the camera
+is; the thread loads the chunks within the load radius, the
+nearest first, drops chunks that moved beyond the unload
+radius and after every batch publishes a new instance list
+holding the harmonicas of all loaded chunks, with the
+material of each. Lists are never modified once published,
+like every list a snapshot shares.
+
+Chunks are listed in the order they were loaded, so while a
+scene streams in each list only appends to the previous one
+and the renderer keeps the state of the instances it already
+has; only unloading a chunk reorders the list.
+
+Batches are small, so the instances nearest the camera are
+drawn a frame or two after the scene's tables are read,
+while the rest of a large scene keeps arriving.
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Scene.h"
+#include "TransformKernel.h"
+
+/* Constants */
+const float SCENE_LOAD_RADIUS = 200.0f;		// Default distance from the camera within which chunks are loaded
+const float SCENE_UNLOAD_FACTOR = 1.25f;	// Chunks are dropped beyond this times the load radius
+const uint32_t STREAM_BATCH_INSTANCES = 16384;	// Instances loaded between published lists
+
+/* Background loader of one scene */
+struct SceneStream {
+	const Scene* scene = nullptr;
+	float loadRadius = SCENE_LOAD_RADIUS;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+
+	// Guarded by mutex
+	glm::vec3 focus;			// Camera position the chunks are loaded around
+	bool moved = false;			// Focus changed since the thread last looked
+	bool quit = false;
+	std::shared_ptr<const TransformSoA> published;	// Newest list, nullptr once taken
+	std::shared_ptr<const std::vector<uint16_t>> publishedMaterials;	// Material of every instance of the newest list
+
+	// Stream thread only
+	std::vector<std::vector<SceneInstance>> resident;	// Instances of every loaded chunk
+	std::vector<unsigned char> loaded;					// Chunk is resident
+	std::vector<size_t> loadOrder;						// Resident chunks in the order they were loaded
+	std::vector<unsigned char> drawable;				// Mesh is one the renderer draws
+	std::vector<uint16_t> meshMaterials;				// Renderer material of every mesh
+};
+
+/* Scene stream prototypes */
+bool startSceneStream(SceneStream& stream, const Scene& scene, const glm::vec3& focus, float loadRadius = SCENE_LOAD_RADIUS);
+void updateSceneStream(SceneStream& stream, const glm::vec3& focus);
+bool pollSceneStream(SceneStream& stream, std::shared_ptr<const TransformSoA>& instances, std::shared_ptr<const std::vector<uint16_t>>& materials);
+void stopSceneStream(SceneStream& stream);
@@ -0,0 +1,204 @@
+#include "SceneSweep.h"
+
+#include <GLEW/glew.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Renderer.h"
+#include "Offscreen.h"
+#include "FrameStats.h"
+#include "LoadMonitor.h"
+
+using namespace std;
+
+/* Constants */
+const float NEAR_FRACTION = 1.0e-4f;	// Near plane as a fraction of the far plane
+const float MIN_NEAR = 0.1f;
+
+// Comma separated counts, e.g. 1000,10000,100000
+bool parseCountList(const string& text, vector<uint32_t>& counts)
+{
+	counts.clear();
+	istringstream fields(text);
+	string field;
+	while (getline(fields, field, ',')) {
+		char* end = nullptr;
+		unsigned long count = strtoul(field.c_str(), &end, 10);
+		if (field.empty() || *end != '\0') {
+			cout << "Expected a comma separated list of counts, got " << text << endl;
+			return false;
+		}
+		counts.push_back((uint32_t)count);
+	}
+	return !counts.empty();
+}
+
+// Instance list of every harmonica in the scene, and the material of each
+static void SceneInstances(const Scene& scene, FrameSnapshot& snapshot)
+{
+	shared_ptr<TransformSoA> list = make_shared<TransformSoA>();
+	for (vector<float>* component : { &list->px, &list->py, &list->pz, &list->qx, &list->qy, &list->qz, &list->qw, &list->sx, &list->sy, &list->sz })
+		component->reserve(scene.instances.size());
+
+	vector<uint16_t> meshMaterials;
+	for (uint32_t mesh = 0; mesh < scene.meshes.size(); ++mesh)
+		meshMaterials.push_back(sceneMeshMaterialId(scene, mesh));
+	shared_ptr<vector<uint16_t>> materials = make_shared<vector<uint16_t>>();
+	materials->reserve(scene.instances.size());
+
+	for (const SceneInstance& instance : scene.instances) {
+		addTransform(*list, instance.position, instance.rotation, instance.scale);
+		materials->push_back(meshMaterials[instance.mesh]);
+	}
+	snapshot.instances = list;
+	snapshot.materials = materials;
+}
+
+// Snapshot of a generated scene seen from its overview camera
+static FrameSnapshot SceneSnapshot(const Scene& scene, const FrameSnapshot& base, int width, int height)
+{
+	FrameSnapshot snapshot = base;
+	snapshot.width = width;
+	snapshot.height = height;
+	SceneInstances(scene, snapshot);
+	snapshot.lightDraw = true;
+
+	// First lights shade, every light is drawn
+	shared_ptr<vector<glm::vec3>> lamps = make_shared<vector<glm::vec3>>();
+	for (const SceneLight& light : scene.lights)
+		lamps->push_back(light.position);
+	snapshot.lamps = lamps;
+	for (int i = 0; i < LIGHT_COUNT; ++i) {
+		if ((size_t)i < scene.lights.size())
+			snapshot.lights[i] = { scene.lights[i].position, scene.lights[i].color };
+		else
+			snapshot.lights[i].color = glm::vec3(0.0f);
+	}
+
+	// Far plane reaches the back of the volume
+	const SceneCamera& camera = scene.cameras[0];
+	glm::vec3 low(0.0f), high(0.0f);
+	sceneBounds(scene, low, high);
+	float zFar = glm::length(camera.position - (low + high) * 0.5f) + glm::length(high - low) * 0.5f + GENERATOR_SPACING;
+	float zNear = max(MIN_NEAR, zFar * NEAR_FRACTION);
+
+	snapshot.camera.view = glm::lookAt(camera.position, camera.target, glm::vec3(0.0f, 1.0f, 0.0f));
+	snapshot.camera.projection = glm::perspective(camera.fov, (float)width / (float)height, zNear, zFar);
+	snapshot.camera.position = camera.position;
+	snapshot.camera.zNear = zNear;
+	snapshot.camera.zFar = zFar;
+	return snapshot;
+}
+
+// Render every combination of counts and write a CSV row for each
+bool runSceneSweep(GLFWwindow* window, const FrameSnapshot& base, const SweepSettings& settings, const string& csvPath)
+{
+	ofstream csv(csvPath);
+	if (!csv) {
+		cout << "Could not create sweep file " << csvPath << endl;
+		return false;
+	}
+	csv << "instances,lights,materials,distribution,cpu_ms,gpu_ms,frame_ms,frame_ms_max,draw_calls,triangles,impostors,ring_overflows,instance_mb,process_mb\n";
+
+	// Generated materials only depend on their index, so the renderer loads those of the largest count once
+	SceneGeneratorSettings palette = settings.scene;
+	palette.instances = 0;
+	palette.lights = 0;
+	palette.materials = *max_element(settings.materialCounts.begin(), settings.materialCounts.end());
+	Scene paletteScene;
+	generateScene(paletteScene, palette);
+	setSceneMaterials(paletteScene.materials);
+
+	// The window's framebuffer is never shown
+	OffscreenTarget target;
+	if (!initOffscreenRenderer(window, target, settings.width, settings.height))
+		return false;
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	bool ok = true;
+	unsigned long long frame = 0;
+	for (uint32_t instances : settings.instanceCounts) {
+		for (uint32_t lights : settings.lightCounts) {
+			for (uint32_t materials : settings.materialCounts) {
+				SceneGeneratorSettings generator = settings.scene;
+				generator.instances = instances;
+				generator.lights = lights;
+				generator.materials = materials;
+				Scene scene;
+				generateScene(scene, generator);
+				FrameSnapshot snapshot = SceneSnapshot(scene, base, settings.width, settings.height);
+
+				double cpuMs = 0.0, gpuMs = 0.0, frameMs = 0.0, worstMs = 0.0;
+				unsigned int overflows = 0;
+				for (int f = 0; f < settings.warmupFrames + settings.measuredFrames; ++f) {
+					snapshot.frame = ++frame;
+					snapshot.time = (float)glfwGetTime();
+
+					// Impostor baking and accumulation bind the default framebuffer when they finish
+					glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+					double frameStart = glfwGetTime();
+					glBeginQuery(GL_TIME_ELAPSED, query);
+					renderFrame(snapshot);
+					glEndQuery(GL_TIME_ELAPSED);
+					double submitted = glfwGetTime();
+					glFinish();
+					double finished = glfwGetTime();
+
+					GLuint64 gpuNs = 0;
+					glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNs);
+					if (f < settings.warmupFrames)
+						continue;
+					if (frameStats.drawCalls == 0) {
+						cout << "Nothing was drawn, the shaders did not compile" << endl;
+						ok = false;
+						break;
+					}
+
+					overflows += frameStats.ringOverflows;
+					cpuMs += (submitted - frameStart) * 1000.0;
+					gpuMs += gpuNs * 1.0e-6;
+					frameMs += (finished - frameStart) * 1000.0;
+					worstMs = max(worstMs, (finished - frameStart) * 1000.0);
+				}
+				if (!ok)
+					break;
+
+				double frames = max(1, settings.measuredFrames);
+				double instanceMb = (transformCount(*snapshot.instances) * 10 * sizeof(float) + snapshot.materials->size() * sizeof(uint16_t)) / (1024.0 * 1024.0);
+				double processMb = processMemoryBytes() / (1024.0 * 1024.0);
+				csv << instances << "," << lights << "," << scene.materials.size() << "," << sceneDistributionName(generator.distribution) << ",";
+
+				// A measured frame that dropped draws did less work than the scene asks for, its times are left out
+				if (overflows == 0)
+					csv << cpuMs / frames << "," << gpuMs / frames << "," << frameMs / frames << "," << worstMs << ",";
+				else
+					csv << ",,,,";
+				csv << frameStats.drawCalls << "," << frameStats.trianglesDrawn << "," << frameStats.impostorsDrawn << "," << overflows << ","
+					<< instanceMb << "," << processMb << "\n";
+				csv.flush();
+
+				cout << instances << " instances, " << lights << " lights, " << scene.materials.size() << " materials: ";
+				if (overflows == 0)
+					cout << frameMs / frames << "ms per frame, " << frameStats.drawCalls << " draw calls" << endl;
+				else
+					cout << overflows << " ring overflows while measuring, times not recorded" << endl;
+			}
+			if (!ok)
+				break;
+		}
+		if (!ok)
+			break;
+	}
+
+	glDeleteQueries(1, &query);
+	freeOffscreenRenderer(target);
+	return ok;
+}
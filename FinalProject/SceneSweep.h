@@ -0,0 +1,49 @@
+/* Description:
+Scaling sweep. Generates a scene (see SceneGenerator.h) for
+every combination of instance, light and material counts,
+renders a fixed number of frames of each from the scene's
+overview camera into an offscreen target and writes one CSV
+row per combination, so scaling shows up as curves:
+	instances, lights, materials, distribution
+	cpu_ms			Time to build and submit a frame
+	gpu_ms			GPU time of a frame (timer query)
+	frame_ms		Wall time of a frame, waiting for the GPU to finish
+	frame_ms_max	Slowest measured frame
+	draw_calls, triangles, impostors	Of the last measured frame
+	ring_overflows	Over the measured frames; any drop draws, so the times are left empty
+	instance_mb		Size of the instance and material lists
+	process_mb		Resident memory after the combination ran
+Times are averages over the measured frames; warm-up frames
+(impostor bake, first uploads) are not counted. Every light
+is drawn as a lamp, the first LIGHT_COUNT also shade. Each
+instance draws with its mesh's material; the textures of
+every material are loaded before the first combination.
+
+Runs on the calling thread with a hidden window's context,
+like thumbnails; frames are never presented.
+*/
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FrameSnapshot.h"
+#include "SceneGenerator.h"
+
+/* What to sweep */
+struct SweepSettings {
+	std::vector<uint32_t> instanceCounts = { 1000, 10000, 100000 };
+	std::vector<uint32_t> lightCounts = { 3 };
+	std::vector<uint32_t> materialCounts = { 1 };
+	SceneGeneratorSettings scene;	// Instance, light and material counts are replaced by every combination
+	int width = 1280;
+	int height = 720;
+	int warmupFrames = 10;
+	int measuredFrames = 60;
+};
+
+/* Scene sweep prototypes */
+bool parseCountList(const std::string& text, std::vector<uint32_t>& counts);
+bool runSceneSweep(GLFWwindow* window, const FrameSnapshot& base, const SweepSettings& settings, const std::string& csvPath);
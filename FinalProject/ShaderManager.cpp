@@ -0,0 +1,296 @@
+#include "ShaderManager.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace std;
+
+/* Constants */
+const GLfloat RELOAD_INTERVAL = 0.5f;	// Seconds between checks for modified shader files
+
+/* Module state */
+static vector<ShaderProgram*> programs;	// Every program created by the manager
+static bool parallelCompile = false;	// Driver supports polling completion status
+static GLfloat lastReloadCheck = 0.0f;	// Time of last modification check
+static vector<pair<string, GLuint>> blockBindings;	// Uniform block name -> binding point
+
+// Returns the modification time of a file, 0 if it does not exist
+static time_t FileModified(const string& path)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return 0;
+
+	return info.st_mtime;
+}
+
+// Read entire file into a string
+static bool ReadFile(const string& path, string& out)
+{
+	ifstream file(path);
+	if (!file)
+		return false;
+
+	stringstream buffer;
+	buffer << file.rdbuf();
+	out = buffer.str();
+	return true;
+}
+
+// Insert preprocessor defines after the #version line
+static string InjectDefines(const string& source, const string& defines)
+{
+	if (defines.empty())
+		return source;
+
+	size_t lineEnd = source.find('\n');
+	if (lineEnd == string::npos || source.compare(0, 8, "#version") != 0)
+		return defines + source;
+
+	return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+// Create and Compile Shaders (status is not queried so the driver may compile in the background)
+static GLuint CompileShader(const string& source, GLenum shaderType)
+{
+	// Create Shader object
+	GLuint shaderID = glCreateShader(shaderType);
+	const char* src = source.c_str();
+
+	// Attach source code to Shader object
+	glShaderSource(shaderID, 1, &src, nullptr);
+
+	// Compile Shader
+	glCompileShader(shaderID);
+
+	// Return ID of Compiled shader
+	return shaderID;
+}
+
+// Print the info log of a failed shader stage
+static void PrintShaderLog(const ShaderStage& stage)
+{
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(stage.pending, GL_COMPILE_STATUS, &compiled);
+	if (compiled)
+		return;
+
+	GLint logLength = 0;
+	glGetShaderiv(stage.pending, GL_INFO_LOG_LENGTH, &logLength);
+	string log(logLength > 1 ? logLength : 1, '\0');
+	glGetShaderInfoLog(stage.pending, logLength, nullptr, &log[0]);
+	cout << stage.path << ": " << log.c_str() << endl;
+}
+
+// Release the in-flight program and its shader objects
+static void DiscardPending(ShaderProgram* shader)
+{
+	for (ShaderStage& stage : shader->stages) {
+		if (stage.pending) {
+			glDeleteShader(stage.pending);
+			stage.pending = 0;
+		}
+	}
+
+	if (shader->pending) {
+		glDeleteProgram(shader->pending);
+		shader->pending = 0;
+	}
+}
+
+// Read sources from disk and start compiling and linking a new program
+static void SubmitProgram(ShaderProgram* shader)
+{
+	vector<string> sources;
+	for (const ShaderStage& stage : shader->stages) {
+		string source;
+		if (!ReadFile(stage.path, source)) {
+			cout << "Failed to read shader " << stage.path << endl;
+			return;
+		}
+		sources.push_back(InjectDefines(source, shader->defines));
+	}
+
+	// Supersede any compile that is still running
+	DiscardPending(shader);
+
+	// Create program object
+	shader->pending = glCreateProgram();
+
+	// Compile and attach every stage
+	for (size_t i = 0; i < shader->stages.size(); ++i) {
+		shader->stages[i].pending = CompileShader(sources[i], shader->stages[i].type);
+		glAttachShader(shader->pending, shader->stages[i].pending);
+	}
+
+	// Link shaders to create executable
+	glLinkProgram(shader->pending);
+	shader->pendingFrames = 0;
+}
+
+// Swap in a finished program or report why it failed
+static void FinishPending(ShaderProgram* shader)
+{
+	GLint linked = GL_FALSE;
+	glGetProgramiv(shader->pending, GL_LINK_STATUS, &linked);
+
+	if (linked) {
+		// Keep old program until the new one is known good
+		if (shader->program)
+			glDeleteProgram(shader->program);
+
+		shader->program = shader->pending;
+		shader->pending = 0;
+		shader->generation++;
+
+		// GLSL 330 has no binding layout qualifier, assign uniform blocks here
+		for (const auto& block : blockBindings) {
+			GLuint index = glGetUniformBlockIndex(shader->program, block.first.c_str());
+			if (index != GL_INVALID_INDEX)
+				glUniformBlockBinding(shader->program, index, block.second);
+		}
+
+		if (shader->generation > 1)
+			cout << "Reloaded shader " << shader->stages.back().path << endl;
+	}
+	else {
+		for (const ShaderStage& stage : shader->stages)
+			PrintShaderLog(stage);
+
+		GLint logLength = 0;
+		glGetProgramiv(shader->pending, GL_INFO_LOG_LENGTH, &logLength);
+		string log(logLength > 1 ? logLength : 1, '\0');
+		glGetProgramInfoLog(shader->pending, logLength, nullptr, &log[0]);
+		cout << "Shader link failed, keeping previous program: " << log.c_str() << endl;
+	}
+
+	// Shader objects are no longer needed once linked (or rejected)
+	for (ShaderStage& stage : shader->stages) {
+		if (shader->pending)
+			glDetachShader(shader->pending, stage.pending);
+		else if (shader->program)
+			glDetachShader(shader->program, stage.pending);
+		glDeleteShader(stage.pending);
+		stage.pending = 0;
+	}
+
+	if (shader->pending) {
+		glDeleteProgram(shader->pending);
+		shader->pending = 0;
+	}
+}
+
+// Enable background compilation on the driver if available
+void initShaderManager()
+{
+	if (GLEW_KHR_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // let the driver pick the thread count
+		parallelCompile = true;
+	}
+	else if (GLEW_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		parallelCompile = true;
+	}
+}
+
+// Every program that declares the block gets it bound to binding when linked
+void setUniformBlockBinding(const string& blockName, GLuint binding)
+{
+	blockBindings.push_back(make_pair(blockName, binding));
+}
+
+// Create a program from a list of stages, compilation starts immediately
+ShaderProgram* loadShaderProgram(const vector<ShaderStage>& stages, const string& defines)
+{
+	ShaderProgram* shader = new ShaderProgram();
+	shader->stages = stages;
+	shader->defines = defines;
+
+	for (ShaderStage& stage : shader->stages)
+		stage.modified = FileModified(stage.path);
+
+	SubmitProgram(shader);
+	programs.push_back(shader);
+	return shader;
+}
+
+// Create a vertex + fragment program
+ShaderProgram* loadShaderProgram(const string& vertexPath, const string& fragmentPath, const string& defines)
+{
+	ShaderStage vertex, fragment;
+	vertex.type = GL_VERTEX_SHADER;
+	vertex.path = vertexPath;
+	fragment.type = GL_FRAGMENT_SHADER;
+	fragment.path = fragmentPath;
+
+	return loadShaderProgram({ vertex, fragment }, defines);
+}
+
+// Per-frame: finish compiles that are done and restart changed ones, true if a program was replaced
+bool pollShaderPrograms(GLfloat currentTime)
+{
+	bool replaced = false;
+	for (ShaderProgram* shader : programs) {
+		if (!shader->pending)
+			continue;
+
+		if (parallelCompile) {
+			GLint done = GL_FALSE;
+			glGetProgramiv(shader->pending, GL_COMPLETION_STATUS_KHR, &done);
+			if (!done)
+				continue;
+		}
+		else if (shader->pendingFrames++ < 1) {
+			// Give the driver one frame before a (blocking) status query
+			continue;
+		}
+
+		unsigned int generation = shader->generation;
+		FinishPending(shader);
+		replaced |= shader->generation != generation;
+	}
+
+	// Look for edited files
+	if (currentTime >= lastReloadCheck && currentTime - lastReloadCheck < RELOAD_INTERVAL)
+		return replaced;
+	lastReloadCheck = currentTime;
+
+	for (ShaderProgram* shader : programs) {
+		bool changed = false;
+		for (ShaderStage& stage : shader->stages) {
+			time_t modified = FileModified(stage.path);
+			if (modified != 0 && modified != stage.modified) {
+				stage.modified = modified;
+				changed = true;
+			}
+		}
+
+		if (changed)
+			SubmitProgram(shader);
+	}
+
+	return replaced;
+}
+
+// A compile or link is still in flight
+bool shaderProgramsPending()
+{
+	for (ShaderProgram* shader : programs)
+		if (shader->pending)
+			return true;
+	return false;
+}
+
+// Delete every program and in-flight compile
+void deleteShaderPrograms()
+{
+	for (ShaderProgram* shader : programs) {
+		DiscardPending(shader);
+		if (shader->program)
+			glDeleteProgram(shader->program);
+		delete shader;
+	}
+	programs.clear();
+}
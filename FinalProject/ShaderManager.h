@@ -0,0 +1,43 @@
+/* Description:
+Loads shader programs from files on disk, compiles them
+without blocking the render loop and recompiles them in
+the background whenever a source file changes.
+
+Compilation uses KHR/ARB_parallel_shader_compile when the
+driver exposes it, so completion can be polled instead of
+waited on. The previously linked program stays in use until
+a replacement links cleanly.
+*/
+#pragma once
+
+#include <GLEW/glew.h>
+#include <string>
+#include <vector>
+#include <ctime>
+
+/* Single shader stage of a program */
+struct ShaderStage {
+	GLenum type;				// GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, ...
+	std::string path;			// Source file, relative to the working directory
+	time_t modified = 0;		// Last modification time seen on disk
+	GLuint pending = 0;			// Shader object of the in-flight compile
+};
+
+/* Hot reloadable shader program */
+struct ShaderProgram {
+	std::vector<ShaderStage> stages;
+	std::string defines;		// Lines inserted after #version (e.g. "#define FOO 1\n")
+	GLuint program = 0;			// Linked program in use, 0 until the first link succeeds
+	GLuint pending = 0;			// Program currently compiling/linking in the background
+	int pendingFrames = 0;		// Frames since the pending program was submitted
+	unsigned int generation = 0;	// Incremented every time program is replaced
+};
+
+/* Shader manager prototypes */
+void initShaderManager();
+void setUniformBlockBinding(const std::string& blockName, GLuint binding);
+ShaderProgram* loadShaderProgram(const std::vector<ShaderStage>& stages, const std::string& defines = "");
+ShaderProgram* loadShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
+bool pollShaderPrograms(GLfloat currentTime);
+bool shaderProgramsPending();
+void deleteShaderPrograms();
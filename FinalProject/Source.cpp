@@ -6,6 +6,13 @@ Creates a perspective OpenGL view and renders
 a 3D low-poly harmonica. The user can navigate 
 around the object by using the controls listed below.
 
+Shaders are loaded from the shaders folder and are
+recompiled automatically when a file is saved.
+
+The main thread handles input and builds a snapshot of
+each frame; drawing happens on a separate render thread
+(see RenderThread.h).
+
 WARNING: Don't hover over glfwCreateWindow function!!!!!
 Long function descriptions cause VS2017 to lock up.
 */
@@ -13,22 +20,89 @@ Long function descriptions cause VS2017 to lock up.
 	F:			Resets view to starting position
 	O:			Toggles orthographic viewing
 	L:			Toggles drawing of light objects
-	Space:		Toggles wireframe mode
+	I:			Toggles printing of frame statistics
+	P:			Toggles progressive anti-aliasing while the camera is still
+	V:			Cycles vsync between off, on and adaptive
+	Z:			Toggles the depth pre-pass
+	H:			Toggles the overdraw heat map
+	Q:			Toggles the quad view (top, perspective, front and side)
+	Space:		Cycles wireframe between off, edges over shading, hidden-line and all edges
 
 	ALT + Left Mouse Button:	Orbits the camera, clamped at +-90degrees
 	Scroll Wheel:				Zooms the camera in and out (changes FOV)
 */
+/* Command line:
+	--bench-transforms [count]	Compares glm and batched SIMD instance transforms
+	--bench-harmonica [count]	Times generating random harmonica shapes (see HarmonicaGenerator.h)
+	--record <file>				Records input events and camera state to a binary log
+	--replay <file>				Replays a recorded log at a fixed timestep, then exits
+	--headless					Hides the window (replay only)
+	--timings <file>			Writes per-frame CPU/GPU timings to a CSV file
+	--capture <folder>			Saves every rendered frame as a PNG (read back asynchronously)
+	--capture-video <file>		Writes every rendered frame to a raw Y4M video
+	--capture-fps <fps>			Frame rate stored in the video header (default 60)
+	--on-demand					Only renders when input, a resize or a reloaded shader changed the frame
+	--vsync <off|on|adaptive>	Selects the swap interval (default on)
+	--fps-limit <fps>			Limits the frame rate (sleep, then spin for the last 2ms)
+	--late-latch				Renderer picks up the newest camera just before drawing
+	--dynamic-res <ms>			Scales the render resolution to keep GPU frame time under ms
+	--upscale <bilinear|sharpen>	Filter used to scale dynamic resolution frames to the window
+	--meshlets					Culls harmonica meshlets on the GPU (OpenGL 4.3)
+	--depth-prepass				Starts with the depth pre-pass enabled
+	--overdraw					Starts with the overdraw heat map shown
+	--quad-view					Starts in the quad view
+	--thumbnails <poses> <folder>	Renders a PNG per camera pose without a window, then exits (see Thumbnails.h)
+	--thumbnail-size <px>		Size of the square thumbnails (default 256)
+	--scene <file>				Loads instances, materials, lights and cameras from a scene file (see Scene.h)
+	--scene-convert <in> <out>	Writes a scene file in binary form, then exits
+	--stream-radius <units>		Distance from the camera within which scene chunks are loaded (default 200)
+	--generate-scene <file>		Writes a synthetic benchmark scene (see SceneGenerator.h) in binary form, then exits
+	--sweep <csv>				Renders generated scenes of every instance, light and material count, one CSV row each (see SceneSweep.h)
+	--sweep-instances <list>	Instance counts of the sweep, comma separated (default 1000,10000,100000)
+	--sweep-lights <list>		Light counts of the sweep, comma separated (default 3)
+	--sweep-materials <list>	Material counts of the sweep, comma separated (default 1)
+	--gen-instances <count>		Harmonicas in a generated scene (default 1000)
+	--gen-lights <count>		Lights in a generated scene (default 3)
+	--gen-materials <count>		Materials in a generated scene (default 1)
+	--gen-distribution <name>	uniform, grid, clusters or floor (default uniform)
+	--gen-seed <seed>			Random seed of a generated scene (default 1)
+	--harmonica <params>		Draws a generated harmonica, e.g. holes=12,length=12,combChamfer=0.05 (see HarmonicaGenerator.h)
+	--find-instances			Reports the repeated pieces of each part (see MeshInstancing.h), then exits
+	--bake-lighting <file>		Bakes the diffuse light of the scene's lights (see IrradianceVolume.h), then exits
+	--lighting <file>			Shades the harmonica with baked diffuse light, specular stays live
+*/
 
 #include <GLEW/glew.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <memory>
 
 // GLM libraries
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-
-#include <SOIL2\SOIL2.h>
+#include <glm/gtc/quaternion.hpp>
+
+#include "TransformKernel.h"
+#include "RenderThread.h"
+#include "InputQueue.h"
+#include "InputActions.h"
+#include "InputRecording.h"
+#include "FrameTimings.h"
+#include "FrameCapture.h"
+#include "Thumbnails.h"
+#include "Renderer.h"
+#include "LoadMonitor.h"
+#include "FramePacing.h"
+#include "Scene.h"
+#include "SceneStream.h"
+#include "SceneGenerator.h"
+#include "SceneSweep.h"
+#include "HarmonicaGenerator.h"
+#include "MeshInstancing.h"
+#include "IrradianceVolume.h"
 
 using namespace std;
 
@@ -36,17 +110,52 @@ using namespace std;
 const GLfloat FOV_MAX = 46.0f;
 const GLfloat FOV_MIN = 44.25f;
 const GLfloat SCROLL_SPEED = 0.05f;
+const GLfloat Z_NEAR = 0.1f;
+const GLfloat Z_FAR = 100.0f;
+const double REPLAY_TIMESTEP = 1.0 / 60.0;	// Simulation seconds per replayed frame
+const double IDLE_TIMEOUT = 0.5;			// Longest on-demand wait for events, keeps load reports current
 
 /* Global Variables */
 int width, height;			// Screen dimensions
 
-bool keys[1024];			// Key press array
-bool mouseButton[3];		// Mouse button press array
+InputQueue inputQueue;		// Events from the GLFW callbacks, drained once per frame
+InputState input;			// Action bindings and state
 bool isOrbiting = false;	// Sets mouse movement to orbiting
-bool wireFrame = false;		// Toggles wireframe mode
-bool firstMouseMove = true;	// Detect initial mouse movement
+WireframeMode wireFrame = WIREFRAME_OFF;	// Cycled with Space
 bool ortho = false;			// Sets orthographic projection
 bool lightDraw = false;		// Disable drawing of light objects
+bool showStats = false;		// Print frame statistics (read by the render thread through snapshots)
+bool progressive = false;	// Accumulate jittered frames while the camera is still
+
+// On-demand rendering
+bool onDemand = false;		// Render only when something changed
+bool frameInvalid = true;	// Window contents were damaged or the scene changed
+CameraState renderedCamera;	// State shown by the last rendered frame
+int renderedWidth = 0, renderedHeight = 0;
+bool renderedStats = false;
+
+// Frame pacing
+SwapMode swapMode = SWAP_ON;	// Swap interval, applied by the render thread
+bool lateLatch = false;			// Let the renderer use a newer camera than its snapshot
+double pendingInputTime = -1.0;	// Time of the first input that changed the view since the last snapshot
+
+// Dynamic resolution
+float frameTargetMs = 0.0f;		// GPU frame time target, 0 renders at window resolution
+bool sharpenUpscale = false;	// Sharpen instead of plain bilinear upscaling
+
+// Meshlet culling
+bool meshletCulling = false;	// Cull and draw the harmonica parts with the compute pass
+
+// Overdraw
+bool depthPrepass = false;		// Depth-only pass before shading
+bool overdraw = false;			// Heat map of shaded fragments per pixel
+
+// Quad view
+bool quadView = false;			// Top, perspective, front and side views in one window
+
+// Recording and replay
+InputRecorder recorder;		// Open while recording
+uint32_t frameIndex = 0;	// Frames simulated so far
 
 // Zoom
 GLfloat fov = 45.0f;		// Initial fov value
@@ -59,10 +168,6 @@ GLfloat rawPitch = 0.0f;	// raw value of Pitch
 GLfloat deltaTime = 0.0f;	// deltaTime for consistent performance
 GLfloat lastFrame = 0.0f;	// Last frame accessed for deltaTime calculation
 
-GLfloat xChange, yChange;	// Difference in X,Y coordinates
-GLfloat lastX;		// last X mouse position
-GLfloat lastY;		// last Y mouse position
-
 // Define camera attributes
 glm::vec3 cameraPosition = glm::vec3(0.0f, 0.0f, 10.0f);
 glm::vec3 target = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -75,79 +180,306 @@ glm::vec3 cameraFront = glm::normalize(glm::vec3(0.0f, 0.0f, -1.0f));
 // Declare View Matrix
 glm::mat4 viewMatrix;
 
-// Lamp position
-glm::vec3 lamp1Position(0.0f, 0.0f, 5.0f);
-glm::vec3 lamp2Position(-3.0f, 1.0f, 6.0f);
-glm::vec3 lamp3Position(3.0f, 1.0f, 6.0f);
+// Lamp positions and colors (replaced by a scene's lights)
+LightSnapshot lights[LIGHT_COUNT] = {
+	{ glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 1.0f) },	// Primary blue light
+	{ glm::vec3(-3.0f, 1.0f, 6.0f), glm::vec3(1.0f, 0.0f, 0.5f) },	// Secondary purple light
+	{ glm::vec3(3.0f, 1.0f, 6.0f), glm::vec3(1.0f, 0.0f, 0.5f) },	// Secondary purple light
+};
+
+// Scene file
+Scene scene;					// Tables of the loaded scene, instances stream in through sceneStream
+SceneStream sceneStream;		// Loads the scene's chunks around the camera
+SceneCamera homeCamera;			// Camera F returns to, the scene's first camera if it has one
+GLfloat farPlane = Z_FAR;		// Far clip distance, pushed back to fit a large scene
+shared_ptr<const vector<glm::vec3>> sceneLamps;	// Every light of a scene with more lights than the shader
+float streamRadius = SCENE_LOAD_RADIUS;
 
 /* Input Callback prototypes */
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
+
+/* Input processing prototypes */
+void BindActions();
+void ProcessInput(const InputEvent* replayEvents, size_t replayCount);
+bool ApplyInput(const InputEvent& event);
+void ReportStats();
+CameraState CurrentCameraState();
+bool FrameInvalidated(const CameraState& camera);
 
 /* Camera transformation prototypes */
+void OrbitCamera(GLfloat xChange, GLfloat yChange);
+void ZoomCamera(GLfloat offset);
 void TransformCamera();
 void initCamera();
+void ApplyScene();
 
-// Draw Primitive(s)
-void draw(GLsizei indices)
-{
-	GLenum mode = GL_TRIANGLES;	
-	glDrawElements(mode, indices, GL_UNSIGNED_BYTE, nullptr);
-}
+/* Frame snapshot prototypes */
+void BuildSnapshot(FrameSnapshot& snapshot, GLfloat time, const shared_ptr<const TransformSoA>& instances);
+void BuildQuadViews(FrameSnapshot& snapshot);
+MeshData WholePart(const MeshData& half);
 
-// Create and Compile Shaders
-static GLuint CompileShader(const string& source, GLuint shaderType)
+/* Baked lighting prototypes */
+vector<BakeLight> BakeLights();
+void LightingBounds(const HarmonicaParams& shape, glm::vec3& low, glm::vec3& high);
+
+int main(int argc, char** argv)
 {
-	// Create Shader object
-	GLuint shaderID = glCreateShader(shaderType);
-	const char* src = source.c_str();
+	string recordPath, replayPath, timingsPath, captureDirectory, capturePath;
+	int captureFps = 60;
+	string posesPath, thumbnailDirectory;
+	string scenePath, sceneConvertPath, generatePath, sweepPath;
+	string bakePath, lightingPath;
+	SweepSettings sweep;
+	SceneGeneratorSettings generator;
+	HarmonicaParams harmonicaShape;
+	int thumbnailSize = 256;
+	bool headless = false;
+	bool findInstances = false;
+	double fpsLimit = 0.0;
+
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		// Command line modes that run without a window
+		if (arg == "--bench-transforms") {
+			size_t count = hasValue ? (size_t)atoi(argv[i + 1]) : 50000;
+			runTransformBenchmark(count, 20);
+			return 0;
+		}
+		else if (arg == "--bench-harmonica") {
+			runHarmonicaBenchmark(hasValue ? atoi(argv[i + 1]) : 10000);
+			return 0;
+		}
+		else if (arg == "--record" && hasValue) {
+			recordPath = argv[++i];
+		}
+		else if (arg == "--replay" && hasValue) {
+			replayPath = argv[++i];
+		}
+		else if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--timings" && hasValue) {
+			timingsPath = argv[++i];
+		}
+		else if (arg == "--capture" && hasValue) {
+			captureDirectory = argv[++i];
+		}
+		else if (arg == "--capture-video" && hasValue) {
+			capturePath = argv[++i];
+		}
+		else if (arg == "--capture-fps" && hasValue) {
+			captureFps = atoi(argv[++i]);
+		}
+		else if (arg == "--on-demand") {
+			onDemand = true;
+		}
+		else if (arg == "--vsync" && hasValue) {
+			if (!parseSwapMode(argv[++i], swapMode))
+				cout << "Unknown vsync mode " << argv[i] << ", expected off, on or adaptive" << endl;
+		}
+		else if (arg == "--fps-limit" && hasValue) {
+			fpsLimit = atof(argv[++i]);
+		}
+		else if (arg == "--late-latch") {
+			lateLatch = true;
+		}
+		else if (arg == "--dynamic-res" && hasValue) {
+			frameTargetMs = (float)atof(argv[++i]);
+		}
+		else if (arg == "--upscale" && hasValue) {
+			string filter = argv[++i];
+			if (filter == "sharpen" || filter == "bilinear")
+				sharpenUpscale = filter == "sharpen";
+			else
+				cout << "Unknown upscale filter " << filter << ", expected bilinear or sharpen" << endl;
+		}
+		else if (arg == "--meshlets") {
+			meshletCulling = true;
+		}
+		else if (arg == "--depth-prepass") {
+			depthPrepass = true;
+		}
+		else if (arg == "--overdraw") {
+			overdraw = true;
+		}
+		else if (arg == "--quad-view") {
+			quadView = true;
+		}
+		else if (arg == "--thumbnails" && i + 2 < argc) {
+			posesPath = argv[++i];
+			thumbnailDirectory = argv[++i];
+		}
+		else if (arg == "--thumbnail-size" && hasValue) {
+			thumbnailSize = atoi(argv[++i]);
+		}
+		else if (arg == "--scene" && hasValue) {
+			scenePath = argv[++i];
+		}
+		else if (arg == "--scene-convert" && i + 2 < argc) {
+			scenePath = argv[++i];
+			sceneConvertPath = argv[++i];
+		}
+		else if (arg == "--stream-radius" && hasValue) {
+			streamRadius = (float)atof(argv[++i]);
+		}
+		else if (arg == "--generate-scene" && hasValue) {
+			generatePath = argv[++i];
+		}
+		else if (arg == "--sweep" && hasValue) {
+			sweepPath = argv[++i];
+		}
+		else if (arg == "--sweep-instances" && hasValue) {
+			if (!parseCountList(argv[++i], sweep.instanceCounts))
+				return -1;
+		}
+		else if (arg == "--sweep-lights" && hasValue) {
+			if (!parseCountList(argv[++i], sweep.lightCounts))
+				return -1;
+		}
+		else if (arg == "--sweep-materials" && hasValue) {
+			if (!parseCountList(argv[++i], sweep.materialCounts))
+				return -1;
+		}
+		else if (arg == "--gen-instances" && hasValue) {
+			generator.instances = (uint32_t)atoi(argv[++i]);
+		}
+		else if (arg == "--gen-lights" && hasValue) {
+			generator.lights = (uint32_t)atoi(argv[++i]);
+		}
+		else if (arg == "--gen-materials" && hasValue) {
+			generator.materials = (uint32_t)atoi(argv[++i]);
+		}
+		else if (arg == "--gen-distribution" && hasValue) {
+			if (!parseSceneDistribution(argv[++i], generator.distribution))
+				cout << "Unknown distribution " << argv[i] << ", expected uniform, grid, clusters or floor" << endl;
+		}
+		else if (arg == "--gen-seed" && hasValue) {
+			generator.seed = (uint32_t)atoi(argv[++i]);
+		}
+		else if (arg == "--harmonica" && hasValue) {
+			if (!parseHarmonicaParams(argv[++i], harmonicaShape))
+				return -1;
+			setHarmonicaShape(harmonicaShape);
+		}
+		else if (arg == "--find-instances") {
+			findInstances = true;
+		}
+		else if (arg == "--bake-lighting" && hasValue) {
+			bakePath = argv[++i];
+		}
+		else if (arg == "--lighting" && hasValue) {
+			lightingPath = argv[++i];
+		}
+	}
 
-	// Attach source code to Shader object
-	glShaderSource(shaderID, 1, &src, nullptr);
+	// Repeated pieces of each part, with both halves as they are drawn
+	if (findInstances) {
+		const char* names[] = { "reed", "cover", "comb" };
+		for (int part = MESH_REED; part <= MESH_COMB; ++part) {
+			SubmeshInstancing result;
+			findRepeatedSubmeshes(WholePart(generateHarmonicaMesh(harmonicaShape, (HarmonicaMesh)part)), InstancingSettings(), result);
+			printInstancingReport(names[part], result);
+		}
+		return 0;
+	}
 
-	// Compile Shader
-	glCompileShader(shaderID);
+	// Scene tables are read up front, a binary scene's instances stay in the file until streamed
+	bool sceneLoaded = !scenePath.empty();
+	if (sceneLoaded && !loadScene(scene, scenePath))
+		return -1;
+	if (!sceneConvertPath.empty())
+		return saveSceneBinary(scene, sceneConvertPath) ? 0 : -1;
+
+	// Generated scenes are written like converted ones, load them with --scene
+	if (!generatePath.empty()) {
+		Scene generated;
+		generateScene(generated, generator);
+		return saveSceneBinary(generated, generatePath) ? 0 : -1;
+	}
+	if (sceneLoaded)
+		ApplyScene();
+
+	// Lighting is baked for the lights and bounds of the scene as loaded
+	if (!bakePath.empty()) {
+		glm::vec3 low, high;
+		LightingBounds(harmonicaShape, low, high);
+		IrradianceVolume volume;
+		bakeIrradianceVolume(volume, low, high, BakeLights(), BakeSettings());
+		cout << "Baked " << volume.probes[0] << "x" << volume.probes[1] << "x" << volume.probes[2] << " probes" << endl;
+		return saveIrradianceVolume(volume, bakePath) ? 0 : -1;
+	}
+	if (!lightingPath.empty()) {
+		IrradianceVolume volume;
+		if (!loadIrradianceVolume(volume, lightingPath))
+			return -1;
+		if (!sameBakeLights(volume, BakeLights()))
+			cout << "Lighting file " << lightingPath << " was baked for other lights, bake it again with --bake-lighting" << endl;
+		setBakedLighting(volume);
+	}
 
-	// Return ID of Compiled shader
-	return shaderID;
-}
+	// Replay logs are loaded before the window so its size can match the recording
+	InputReplay replay;
+	bool replaying = !replayPath.empty();
+	if (replaying && !loadInputReplay(replay, replayPath))
+		return -1;
 
-// Create Program Object
-static GLuint CreateShaderProgram(const string& vertexShader, const string& fragmentShader)
-{
-	// Compile vertex shader
-	GLuint vertexShaderComp = CompileShader(vertexShader, GL_VERTEX_SHADER);
+	GLFWwindow* window;
 
-	// Compile fragment shader
-	GLuint fragmentShaderComp = CompileShader(fragmentShader, GL_FRAGMENT_SHADER);
+	/* Initialize the library */
+	if (!glfwInit())
+		return -1;
 
-	// Create program object
-	GLuint shaderProgram = glCreateProgram();
+	// Thumbnails render offscreen on this thread, the window only provides a context
+	if (!posesPath.empty()) {
+		vector<ThumbnailPose> poses;
+		if (!loadThumbnailPoses(posesPath, poses) || thumbnailSize <= 0) {
+			glfwTerminate();
+			return -1;
+		}
 
-	// Attach vertex and fragment shaders to program object
-	glAttachShader(shaderProgram, vertexShaderComp);
-	glAttachShader(shaderProgram, fragmentShaderComp);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(64, 64, "Thumbnails", NULL, NULL);
+		if (!window) {
+			glfwTerminate();
+			return -1;
+		}
 
-	// Link shaders to create executable
-	glLinkProgram(shaderProgram);
+		width = height = thumbnailSize;
+		shared_ptr<TransformSoA> harmonica = make_shared<TransformSoA>();
+		addTransform(*harmonica, glm::vec3(0.0f), glm::quat(), glm::vec3(1.0f));
+		FrameSnapshot snapshot;
+		BuildSnapshot(snapshot, 0.0f, harmonica);
 
-	// Delete compiled vertex and fragment shaders
-	glDeleteShader(vertexShaderComp);
-	glDeleteShader(fragmentShaderComp);
+		bool ok = renderThumbnails(window, snapshot, poses, thumbnailDirectory, thumbnailSize);
+		glfwTerminate();
+		return ok ? 0 : -1;
+	}
 
-	// Return Shader Program
-	return shaderProgram;
-}
+	// Sweeps also render offscreen, every combination brings its own scene and camera
+	if (!sweepPath.empty()) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(64, 64, "Sweep", NULL, NULL);
+		if (!window) {
+			glfwTerminate();
+			return -1;
+		}
 
-int main(void)
-{
-	GLFWwindow* window;
+		width = sweep.width;
+		height = sweep.height;
+		sweep.scene = generator;
+		FrameSnapshot snapshot;
+		BuildSnapshot(snapshot, 0.0f, nullptr);
 
-	/* Initialize the library */
-	if (!glfwInit())
-		return -1;
+		bool ok = runSceneSweep(window, snapshot, sweep, sweepPath);
+		glfwTerminate();
+		return ok ? 0 : -1;
+	}
 
 	/* Setup full screen window */
 	GLFWmonitor* monitor = glfwGetPrimaryMonitor(); // Get primary monitor of system
@@ -163,9 +495,13 @@ int main(void)
 	width = mode->width / 2;
 	height = mode->height / 2;
 
-	// Set lastX and lastY to middle of screen size
-	lastX = width / 2;
-	lastY = height / 2;
+	// Replays render at the recorded size, optionally without showing the window
+	if (replaying) {
+		width = replay.width;
+		height = replay.height;
+		if (headless)
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
 
 	/* Create a windowed mode window and its OpenGL context */
 	window = glfwCreateWindow(width, height, "Gregory S. Fellis", NULL, NULL);
@@ -176,925 +512,424 @@ int main(void)
 		return -1;
 	}
 
-	/* Setup input callback functions */
-	glfwSetKeyCallback(window, key_callback); // Keyboard
-	glfwSetCursorPosCallback(window, cursor_position_callback); // Mouse position
-	glfwSetMouseButtonCallback(window, mouse_button_callback); // Mouse button
-	glfwSetScrollCallback(window, scroll_callback); // Scroll wheel
-
-	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
-
-	// Initialize GLEW
-	if (glewInit() != GLEW_OK) {
-		cout << "GLEW failed to initalize!" << endl;
+	/* Setup input callback functions (live input is ignored while replaying) */
+	if (!replaying) {
+		glfwSetKeyCallback(window, key_callback); // Keyboard
+		glfwSetCursorPosCallback(window, cursor_position_callback); // Mouse position
+		glfwSetMouseButtonCallback(window, mouse_button_callback); // Mouse button
+		glfwSetScrollCallback(window, scroll_callback); // Scroll wheel
+	}
+	glfwSetWindowRefreshCallback(window, window_refresh_callback); // Window contents damaged
+
+	/* Map keys and buttons to actions */
+	BindActions();
+
+	// Harmonica instances and their materials, shared with the render thread through snapshots
+	shared_ptr<const TransformSoA> instances;
+	shared_ptr<const vector<uint16_t>> instanceMaterials;
+	if (sceneLoaded) {
+		// Starts empty, lists of the chunks around the camera replace it as they load
+		instances = make_shared<TransformSoA>();
+		startSceneStream(sceneStream, scene, cameraPosition, streamRadius);
+	}
+	else {
+		shared_ptr<TransformSoA> harmonica = make_shared<TransformSoA>();
+		addTransform(*harmonica, glm::vec3(0.0f), glm::quat(), glm::vec3(1.0f));
+		instances = harmonica;
+	}
 
+	/* Benchmark outputs */
+	if (!timingsPath.empty() && !openFrameTimings(timingsPath)) {
 		glfwTerminate();
 		return -1;
 	}
 
-	/* Setup vertices and indices for objects */
-	GLfloat reedV[] = {
-		/* Top Reed */
-		// Height	= 0.1cm
-		// Width	= 10cm
-		// Depth	= 2.5cm
-		// color : 0.80, 0.65, 0.20, bronze
-
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-5.0,	+0.3,	0.0,	0.80, 0.65, 0.20,	0.0, 0.0,	0.0, 0.0, 1.0,	// 0 low-left back
-		-5.0,	+0.4,	0.0,	1.00, 0.85, 0.40,	0.0, 1.0,	0.0, 0.0, 1.0,	// 1 top-left back
-		+5.0,	+0.4,	0.0,	1.00, 0.85, 0.40,	1.0, 1.0,	0.0, 0.0, 1.0,	// 2 top-right back
-		+5.0,	+0.3,	0.0,	0.80, 0.65, 0.20,	1.0, 0.0,	0.0, 0.0, 1.0,	// 3 low-right back
-
-		-5.0,	+0.3,  +2.5,	0.80, 0.65, 0.20,	0.0, 1.0,	0.0, 0.0, 1.0,	// 4 low-right left
-		-5.0,	+0.4,  +2.5,	1.00, 0.85, 0.40,	1.0, 0.0,	0.0, 0.0, 1.0,	// 5 top-right left
-
-		+5.0,	+0.3,  +2.5,	0.80, 0.65, 0.20,	1.0, 1.0,	0.0, 0.0, 1.0,	// 6 low-left right
-		+5.0,	+0.4,  +2.5,	1.00, 0.85, 0.40,	0.0, 0.0,	0.0, 0.0, 1.0,	// 7 top-left right
-	};
-
-	GLubyte reedI[] = {
-		/* Top Reed */
-		0,		1,		2,			2,		3,		0,			// back
-		0,		4,		5,			5,		1,		0,			// left
-		3,		6,		7,			7,		2,		3,			// right
-		7,		6,		4,			4,		5,		7,			// front
-		0,		3,		4,			4,		6,		3,			// bottom
-		1,		2,		5,			5,		7,		2,			// top
-	};
-	
-	GLfloat coverV[] = {
-		/* Top Cover Plate v2 */
-		// Height	= 0.5cm
-		// Width	= 8.2cm (not counting flaps)
-		// Depth	= 2.4cm
-		// color : 0.65, 0.65, 0.85, silver
-
-		/* Strip 1 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C	
-		-4.1,	+0.40,	+0.3,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 0 low-left back 
-		-4.1,	+0.525, +0.3,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 1 top-left back 
-		+4.1,	+0.525, +0.3,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 2 top-right back 
-		+4.1,	+0.40,	+0.3,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 3 low-right back 
-		-4.1,	+0.40,  +2.45,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 4 low-right left 
-		-4.1,	+0.525,	+2.39,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 5 top-right left 
-		+4.1,	+0.40,  +2.45,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 6 low-left right 
-		+4.1,	+0.525, +2.39,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 7 top-left right 
-
-		/* Strip 2 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C		
-		-4.1,	+0.525, +0.3,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 8 low-left back 
-		-4.1,	+0.65,	+0.3,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 9 top-left back 
-		+4.1,	+0.65,	+0.3,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 10 top-right back 
-		+4.1,	+0.525,	+0.3,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 11 low-right back 
-		-4.1,	+0.525, +2.39,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 12 low-right left 
-		-4.1,	+0.65,  +2.30,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 13 top-right left 
-		+4.1,	+0.525, +2.39,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 14 low-left right 
-		+4.1,	+0.65,  +2.30,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 15 top-left right 
-
-		/* Strip 3 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C		
-		-4.1,	+0.65,	+0.3,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 16 low-left back 
-		-4.1,	+0.775,	+0.3,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 17 top-left back 
-		+4.1,	+0.775,	+0.3,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 18 top-right back 
-		+4.1,	+0.65,	+0.3,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 19 low-right back 
-		-4.1,	+0.65,  +2.30,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 20 low-right left 
-		-4.1,	+0.775, +2.175,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 21 top-right left 
-		+4.1,	+0.65,  +2.30,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 22 low-left right 
-		+4.1,	+0.775, +2.175,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 23 top-left right 
-
-		/* Strip 4 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C		
-		-4.1,	+0.775,	+0.3,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 24 low-left back 
-		-4.1,	+0.80,	+0.3,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 25 top-left back 
-		+4.1,	+0.80,	+0.3,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 26 top-right back 
-		+4.1,	+0.775,	+0.3,	0.65, 0.65, 0.85,	0.0, 1.0,	0.0, 0.0, 1.0,	// 27 low-right back 
-		-4.1,	+0.775, +2.175,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 28 low-right left 
-		-4.1,	+0.90,  +2.0,	0.85, 0.85, 1.00,	1.0, 1.0,	0.0, 0.0, 1.0,	// 29 top-right left 
-		+4.1,	+0.775, +2.175,	0.65, 0.65, 0.85,	0.0, 0.0,	0.0, 0.0, 1.0,	// 30 low-left right 
-		+4.1,	+0.90,  +2.0,	0.85, 0.85, 1.00,	0.0, 1.0,	0.0, 0.0, 1.0,	// 31 top-left right
-
-		/* Back Fin */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C		
-		-3.9,	+1.00,	+0.0,	0.85, 0.85, 1.00,	0.0, 0.0,	0.0, 0.0, 1.0,	// 32 top-left back slope
-		+3.9,	+1.00,	+0.0,	0.85, 0.85, 1.00,	0.0, 1.0,	0.0, 0.0, 1.0,	// 33 top-right back slope
-		+3.7,	+1.00,	+0.0,	0.65, 0.65, 0.85,	1.0, 1.0,	0.0, 0.0, 1.0,	// 34 top-right back
-		-3.9,	+1.00,	+0.0,	0.65, 0.65, 0.85,	1.0, 0.0,	0.0, 0.0, 1.0,	// 35 top-left back
-		+3.7,	+0.60,	+0.0,	0.85, 0.85, 1.00,	0.0, 1.0,	0.0, 0.0, 1.0,	// 36 bottom-right back
-		-3.9,	+0.60,	+0.0,	0.85, 0.85, 1.00,	0.0, 0.0,	0.0, 0.0, 1.0,	// 37 bottom-left back
-	};
-
-	GLubyte coverI[] = {
-		/*	Top	Cover Plate */
-		// Strip 1														
-		0,		4,		5,			5,		1,		0,			// left
-		3,		6,		7,			7,		2,		3,			// right
-		7,		6,		4,			4,		5,		7,			// front
-
-		// Strip 2	
-		8,		12,		13,			13,		9,		8,			// left
-		11,		14,		15,			15,		10,		11,			// right
-		15,		14,		12,			12,		13,		15,			// front
-
-		// Strip 3	
-		16,		20,		21,			21,		17,		16,			// left
-		19,		22,		23,			23,		18,		19,			// right
-		23,		22,		20,			20,		21,		23,			// front
-
-		// Strip 4	
-		24,		28,		29,			29,		25,		24,			// left
-		27,		30,		31,			31,		26,		27,			// right
-		31,		30,		28,			28,		29,		31,			// front
-
-		// Top	
-		25,		26,		29,			29,		31,		26,			// top
-
-		// Back Fin	
-		25,		32,		33,			33,		26,		25,			// front
-		34,		35,		36,			36,		35,		37,			// back
-	};
-
-	GLfloat combV[] = {
-		/* Comb */
-		// Height	= 0.6cm
-		// Width	= 10cm
-		// Depth	= 2.5cm
-		// color : 0.82, 0.42, 0.12, chocolate brown
-
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-5.0,	 0.0,	0.0,	0.20, 0.20, 0.20,	0.0, 0.0,	0.0, 0.0, 1.0,	// 0 low-left back
-		-5.0,	+0.3,	0.0,	0.20, 0.20, 0.20,	0.1, 0.0,	0.0, 0.0, 1.0,	// 1 top-left back
-		+5.0,	+0.3,	0.0,	0.20, 0.20, 0.20,	0.1, 1.0,	0.0, 0.0, 1.0,	// 2 top-right back
-		+5.0,	 0.0,	0.0,	0.20, 0.20, 0.20,	0.0, 1.0,	0.0, 0.0, 1.0,	// 3 low-right back
-
-		// Left Block
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-5.0,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 4 low-right left
-		-5.0,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 5 top-right left
-		-3.35,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 6 low-right front
-		-3.35,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 7 top-right front
-		-3.35,	 0.0,	0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 8 low-right front
-		-3.35,	+0.3,	0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 9 top-right front
-
-		/* Divider 1 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-2.95,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 10 low-left back
-		-2.95,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 11 top-left back
-		-2.65,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 12 top-right back
-		-2.65,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 13 low-right back
-
-		-2.95,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 14 low-right front
-		-2.95,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 15 top-right front
-		-2.65,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 16 low-right front
-		-2.65,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 17 top-right front
-		-2.65,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 18 low-right front
-		-2.65,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 19 top-right front
-
-		/* Divider 2 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-2.25,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 20 low-left back
-		-2.25,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 21 top-left back
-		-1.95,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 22 top-right back
-		-1.95,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 23 low-right back
-
-		-2.25,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 24 low-right front
-		-2.25,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 25 top-right front
-		-1.95,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 26 low-right front
-		-1.95,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 27 top-right front
-		-1.95,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 28 low-right front
-		-1.95,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 29 top-right front
-
-		/* Divider 3 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C	
-		-1.55,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 30 low-left back
-		-1.55,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 31 top-left back
-		-1.25,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 32 top-right back
-		-1.25,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 33 low-right back
-
-		-1.55,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 34 low-right front
-		-1.55,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 35 top-right front
-		-1.25,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 36 low-right front
-		-1.25,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 37 top-right front
-		-1.25,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 38 low-right front
-		-1.25,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 39 top-right front
-
-		/* Divider 4 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-0.85,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 40 low-left back
-		-0.85,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 41 top-left back
-		-0.55,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 42 top-right back
-		-0.55,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 43 low-right back
-
-		-0.85,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 44 low-right front
-		-0.85,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 45 top-right front
-		-0.55,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 46 low-right front
-		-0.55,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 47 top-right front
-		-0.55,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 48 low-right front
-		-0.55,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 49 top-right front
-
-		/* Divider 5 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		-0.15,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 50 low-left back
-		-0.15,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 51 top-left back
-		+0.15,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 52 top-right back
-		+0.15,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 53 low-right back
-
-		-0.15,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 54 low-right front
-		-0.15,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 55 top-right front
-		+0.15,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 56 low-right front
-		+0.15,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 57 top-right front
-		+0.15,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 58 low-right front
-		+0.05,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 59 top-right front
-
-		/* Divider 6 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		+0.85,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 60 low-left back
-		+0.85,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 61 top-left back
-		+0.55,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 62 top-right back
-		+0.55,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 63 low-right back
-
-		+0.85,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 64 low-right front
-		+0.85,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 65 top-right front
-		+0.55,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 66 low-right front
-		+0.55,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 67 top-right front
-		+0.55,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 68 low-right front
-		+0.55,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 69 top-right front
-
-		/* Divider 7 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C	
-		+1.55,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 70 low-left back
-		+1.55,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 71 top-left back
-		+1.25,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 72 top-right back
-		+1.25,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 73 low-right back
-
-		+1.55,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 74 low-right front
-		+1.55,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 75 top-right front
-		+1.25,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 76 low-right front
-		+1.25,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 77 top-right front
-		+1.25,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 78 low-right front
-		+1.25,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 79 top-right front
-
-		/* Divider 8 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		+2.25,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 80 low-left back
-		+2.25,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 81 top-left back
-		+1.95,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 82 top-right back
-		+1.95,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 83 low-right back
-
-		+2.25,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 84 low-right front
-		+2.25,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 85 top-right front
-		+1.95,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 86 low-right front
-		+1.95,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 87 top-right front
-		+1.95,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 88 low-right front
-		+1.95,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 89 top-right front
-
-		/* Divider 9 */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		+2.95,	 0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 90 low-left back
-		+2.95,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 91 top-left back
-		+2.65,	+0.3,  +0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 92 top-right back
-		+2.65,	+0.0,  +0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 93 low-right back
-
-		+2.95,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 94 low-right front
-		+2.95,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 95 top-right front
-		+2.65,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 96 low-right front
-		+2.65,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 97 top-right front
-		+2.65,	 0.0,	+0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 98 low-right front
-		+2.65,	+0.3,	+0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 99 top-right front
-
-		/* Right Block */
-		// Vertex				// Color			// Texture	// Normal Z
-		//X     Y		Z		//R    G     B		S    T		A	 B	  C
-		+5.0,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 100 low-right left
-		+5.0,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 101 top-right left
-		+3.35,	 0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 102 low-right front
-		+3.35,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 103 top-right front
-		+3.35,	 0.0,	0.0,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 104 low-right front
-		+3.35,	+0.3,	0.0,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 105 top-right front
-
-		// Fixed front wall
-		+5.0,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 1.0,	0.0, 0.0, 1.0,	// 106 top-right front
-		+3.35,	0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 0.0,	0.0, 0.0, 1.0,	// 107 low-left front
-		+3.35,	+0.3,	+2.5,	0.82, 0.42, 0.12,	0.1, 0.0,	0.0, 0.0, 1.0,	// 108 top-left front
-		+5.0,	0.0,	+2.5,	0.82, 0.42, 0.12,	0.0, 1.0,	0.0, 0.0, 1.0,	// 109 low-right left
-	};
-
-	GLubyte combI[] = {
-		/* Comb */
-		0,		1,		2,			2,		3,		0,			// back wall
-
-		// Left Block
-		0,		4,		5,			5,		1,		0,			// left
-		4,		5,		6,			6,		7,		5,			// front
-		6,		7,		9,			9,		8,		6,			// right
-
-		// Divider 1
-		10,		14,		15,			15,		11,		10,			// left
-		14,		15,		16,			16,		17,		15,			// front
-		16,		17,		19,			19,		18,		16,			// right
-
-		// Divider 2
-		20,		24,		25,			25,		21,		20,			// left
-		24,		25,		26,			26,		27,		25,			// front
-		26,		27,		29,			29,		28,		26,			// right
-
-		// Divider 3
-		30,		34,		35,			35,		31,		30,			// left
-		34,		35,		36,			36,		37,		35,			// front
-		36,		37,		39,			39,		38,		36,			// right
-
-		// Divider 4
-		40,		44,		45,			45,		41,		40,			// left
-		44,		45,		46,			46,		47,		45,			// front
-		46,		47,		49,			49,		48,		46,			// right
-
-		// Divider 5
-		50,		54,		55,			55,		51,		50,			// left
-		54,		55,		56,			56,		57,		55,			// front
-		56,		57,		59,			59,		58,		56,			// right
-
-		// Divider 6
-		60,		64,		65,			65,		61,		60,			// left
-		64,		65,		66,			66,		67,		65,			// front
-		66,		67,		69,			69,		68,		66,			// right
-
-		// Divider 7
-		70,		74,		75,			75,		71,		70,			// left
-		74,		75,		76,			76,		77,		75,			// front
-		76,		77,		79,			79,		78,		76,			// right
-
-		// Divider 8
-		80,		84,		85,			85,		81,		80,			// left
-		84,		85,		86,			86,		87,		85,			// front
-		86,		87,		89,			89,		88,		86,			// right
-
-		// Divider 9
-		90,		94,		95,			95,		91,		90,			// left
-		94,		95,		96,			96,		97,		95,			// front
-		96,		97,		99,			99,		98,		96,			// right
-
-		// Right Block
-		2,		3,		101,		101,	100,	3,			// left
-		107,	108,	106,		106,	109,	107,		// front
-		102,	103,	105,		105,	104,	102,		// right
-	};
-
-	GLfloat lampV[] = {
-		// Vertex
-		//X     Y		Z
-		-0.5,	-0.5,	0.0,		// index 0
-		-0.5,	0.5,	0.0,		// index 1
-		0.5,	-0.5,	0.0,		// index 2		
-		0.5,	0.5,	0.0,		// index 3	
-	};
-
-	GLubyte lampI[] = {
-		0, 1, 2,
-		1, 2, 3
-	};
-
-	/* Lamp Transforms */
-	glm::vec3 lampPlanePositions[] = {
-		glm::vec3(0.0f,  0.0f,  0.5f),
-		glm::vec3(0.5f,  0.0f,  0.0f),
-		glm::vec3(0.0f,  0.0f,  -0.5f),
-		glm::vec3(-0.5f, 0.0f,  0.0f),
-		glm::vec3(0.0f, 0.5f,  0.0f),
-		glm::vec3(0.0f, -0.5f,  0.0f)
-	};
-
-	glm::float32 lampPlaneRotations[] = {
-		0.0f, 90.0f, 180.0f, -90.0f, -90.f, 90.f
-	};
-
-	// Enable Depth Buffer
-	glEnable(GL_DEPTH_TEST);
-
-	/* Setup VBO, EBO, and VAO for objects */
-	GLuint reedVBO, reedEBO, reedVAO;
-	GLuint combVBO, combEBO, combVAO;
-	GLuint coverVBO, coverEBO, coverVAO;
-	GLuint lampVBO, lampEBO, lampVAO;
-
-	// Reed Buffers
-	glGenBuffers(1, &reedVBO);
-	glGenBuffers(1, &reedEBO);
-
-	// Comb Buffers
-	glGenBuffers(1, &combVBO);
-	glGenBuffers(1, &combEBO);
-
-	// Cover Buffers
-	glGenBuffers(1, &coverVBO);
-	glGenBuffers(1, &coverEBO);
+	// A video takes precedence over a PNG folder
+	if (!capturePath.empty() && !openFrameCapture(capturePath, CAPTURE_Y4M, captureFps)) {
+		glfwTerminate();
+		return -1;
+	}
+	if (capturePath.empty() && !captureDirectory.empty() && !openFrameCapture(captureDirectory, CAPTURE_PNG, captureFps)) {
+		glfwTerminate();
+		return -1;
+	}
+	bool capturing = frameCaptureEnabled();
+
+	if (!recordPath.empty()) {
+		int fbWidth, fbHeight;
+		glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+		if (!openInputRecording(recorder, recordPath, fbWidth, fbHeight, glfwGetTime())) {
+			glfwTerminate();
+			return -1;
+		}
+	}
 
-	// Light Buffers
-	glGenBuffers(1, &lampVBO);
-	glGenBuffers(1, &lampEBO);
+	/* Hand the window's context to the render thread */
+	if (!startRenderThread(window)) {
+		glfwTerminate();
+		return -1;
+	}
 
-	// Vertex Arrays
-	glGenVertexArrays(1, &reedVAO);
-	glGenVertexArrays(1, &combVAO);
-	glGenVertexArrays(1, &coverVAO);
-	glGenVertexArrays(1, &lampVAO);
+	uint32_t divergedFrames = 0;	// Replayed frames whose camera differs from the recording
 
-	/* Reed VAO */
-	glBindVertexArray(reedVAO); // Bind Reed VAO
+	// Longest the main thread waits on the renderer before processing input again
+	double framePeriod = 1.0 / (mode->refreshRate > 0 ? mode->refreshRate : 60);
 
-	glBindBuffer(GL_ARRAY_BUFFER, reedVBO); // Select VBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, reedEBO); // Select EBO
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(reedV), reedV, GL_STATIC_DRAW); // Load vertex attributes
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(reedI), reedI, GL_STATIC_DRAW); // Load indices
-
-	// Specify attribute location and layout to GPU
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-	glBindVertexArray(0); // Unbind Reed VAO
-
-	/* Comb VAO */
-	glBindVertexArray(combVAO); // Bind Comb VAO
-
-	glBindBuffer(GL_ARRAY_BUFFER, combVBO); // Select VBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, combEBO); // Select EBO
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(combV), combV, GL_STATIC_DRAW); // Load vertex attributes
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(combI), combI, GL_STATIC_DRAW); // Load indices
-
-	// Specify attribute location and layout to GPU
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-	glBindVertexArray(0); // Unbind Comb VAO
-
-	/* Cover VAO */
-	glBindVertexArray(coverVAO); // Bind Cover VAO
-
-	glBindBuffer(GL_ARRAY_BUFFER, coverVBO); // Select VBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, coverEBO); // Select EBO
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(coverV), coverV, GL_STATIC_DRAW); // Load vertex attributes
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(coverI), coverI, GL_STATIC_DRAW); // Load indices
-
-	// Specify attribute location and layout to GPU
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-	glBindVertexArray(0); // Unbind Cover VAO
-
-	/* Lamp VAO */
-	glBindVertexArray(lampVAO); // Bind Lamp VAO
-
-	glBindBuffer(GL_ARRAY_BUFFER, lampVBO); // Select VBO
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lampEBO); // Select EBO
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(lampV), lampV, GL_STATIC_DRAW); // Load vertex attributes
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(lampI), lampI, GL_STATIC_DRAW); // Load indices 
-
-	// Specify attribute location and layout to GPU
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	glBindVertexArray(0); // unbind Lamp VAO
-
-	/* Load Textures */
-	int reedTexW, reedTexH, combTexW, combTexH, coverTexW, coverTexH;
-	unsigned char* reedImage = SOIL_load_image("brass1024.jpg", &reedTexW, &reedTexH, 0, SOIL_LOAD_RGB);	// reed
-	unsigned char* combImage = SOIL_load_image("burl2.jpg", &combTexW, &combTexH, 0, SOIL_LOAD_RGB);		// comb
-	unsigned char* coverImage = SOIL_load_image("silver.jpg", &coverTexW, &coverTexH, 0, SOIL_LOAD_RGB);	// cover
-
-	// Reed Texture
-	GLuint reedTexture;
-	glGenTextures(1, &reedTexture);
-	glBindTexture(GL_TEXTURE_2D, reedTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, reedTexW, reedTexH, 0, GL_RGB, GL_UNSIGNED_BYTE, reedImage);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(reedImage);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// Comb Texture
-	GLuint combTexture;
-	glGenTextures(1, &combTexture);
-	glBindTexture(GL_TEXTURE_2D, combTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, combTexW, combTexH, 0, GL_RGB, GL_UNSIGNED_BYTE, combImage);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(combImage);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// Cover Texture
-	GLuint coverTexture;
-	glGenTextures(1, &coverTexture);
-	glBindTexture(GL_TEXTURE_2D, coverTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, coverTexW, coverTexH, 0, GL_RGB, GL_UNSIGNED_BYTE, coverImage);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(coverImage);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	/* Shader source code */
-	// Vertex shader source code
-	string vertexShaderSource =
-		"#version 330 core\n"
-		"layout(location = 0) in vec3 vPosition;"
-		"layout(location = 1) in vec3 aColor;"
-		"layout(location = 2) in vec2 texCoord;"
-		"layout(location = 3) in vec3 normal;"
-		"out vec3 oColor;"
-		"out vec2 oTexCoord;"
-		"out vec3 oNormal;"
-		"out vec3 FragPos;"
-		"uniform mat4 model;"
-		"uniform mat4 view;"
-		"uniform mat4 projection;"
-		"void main()\n"
-		"{\n"
-		"gl_Position = projection * view * model * vec4(vPosition.x, vPosition.y, vPosition.z, 1.0f);"
-		"oColor = aColor;"
-		"oTexCoord = texCoord;"
-		"oNormal = mat3(transpose(inverse(model))) * normal;" // handles non-uniform scaling
-		"FragPos = vec3(model * vec4(vPosition, 1.0f));"
-		"}\n";
-
-	// Fragment shader source code
-	string fragmentShaderSource =
-		"#version 330 core\n"
-		"in vec3 oColor;"
-		"in vec2 oTexCoord;"
-		"in vec3 oNormal;"
-		"in vec3 FragPos;"
-		"out vec4 fragColor;"
-		"uniform sampler2D myTexture;"
-		"uniform vec3 objectColor;"
-		"uniform vec3 light1Color;"
-		"uniform vec3 light1Pos;"
-		"uniform vec3 light2Color;"
-		"uniform vec3 light2Pos;"
-		"uniform vec3 light3Color;"
-		"uniform vec3 light3Pos;"
-		"uniform vec3 viewPos;"
-		"void main()\n"
-		"{\n"
-		"float ambientStrength = 0.5f;" // Ambient
-		"vec3 ambient = ambientStrength * light1Color * light2Color * light3Color;"
-		"vec3 norm = normalize(oNormal);" // Diffuse
-		"vec3 light1Dir = normalize(light1Pos - FragPos);"
-		"vec3 light2Dir = normalize(light2Pos - FragPos);"
-		"vec3 light3Dir = normalize(light3Pos - FragPos);"
-		"float light1Diff = max(dot(norm, light1Dir), 0.0);"
-		"float light2Diff = max(dot(norm, light2Dir), 0.0);"
-		"float light3Diff = max(dot(norm, light3Dir), 0.0);"		
-		"vec3 light1Diffuse = light1Diff * 1.0 * light1Color;"
-		"vec3 light2Diffuse = light2Diff * 0.2 * light2Color;"
-		"vec3 light3Diffuse = light3Diff * 0.2 * light3Color;"
-		"vec3 fullDiffuse = light1Diffuse + light2Diffuse + light3Diffuse;"
-		"float light1SpecStr = 1.5f;" // Specularity
-		"float light2SpecStr = 0.5f;"
-		"float light3SpecStr = 0.5f;"
-		"vec3 viewDir = normalize(viewPos - FragPos);"
-		"vec3 light1ReflectDir = reflect(-light1Dir, norm);"
-		"vec3 light2ReflectDir = reflect(-light2Dir, norm);"
-		"vec3 light3ReflectDir = reflect(-light3Dir, norm);"
-		"float light1Spec = pow(max(dot(viewDir, light1ReflectDir), 0.0), 32);"
-		"float light2Spec = pow(max(dot(viewDir, light2ReflectDir), 0.0), 32);"
-		"float light3Spec = pow(max(dot(viewDir, light3ReflectDir), 0.0), 32);"
-		"vec3 light1Specular = light1SpecStr * light1Spec * light1Color;"
-		"vec3 light2Specular = light2SpecStr * light2Spec * light2Color;"
-		"vec3 light3Specular = light3SpecStr * light3Spec * light3Color;"
-		"vec3 fullSpecular = light1Specular + light2Specular + light3Specular;"
-		"vec3 result = (ambient + fullDiffuse + fullSpecular) * objectColor;"
-		"fragColor = texture(myTexture, oTexCoord) * vec4(result, 1.0f);"
-		"}\n";
-
-	// Lamp Vertex shader source code
-	string lampVertexShaderSource =
-		"#version 330 core\n"
-		"layout(location = 0) in vec3 vPosition;"
-		"uniform mat4 model;"
-		"uniform mat4 view;"
-		"uniform mat4 projection;"
-		"void main()\n"
-		"{\n"
-		"gl_Position = projection * view * model * vec4(vPosition.x, vPosition.y, vPosition.z, 1.0f);"
-		"}\n";
-
-	// Lamp Fragment shader source code
-	string lampFragmentShaderSource =
-		"#version 330 core\n"
-		"out vec4 fragColor;"
-		"void main()\n"
-		"{\n"
-		"fragColor = vec4(1.0f);"
-		"}\n";
-
-	// Creating Shader Programs
-	GLuint shaderProgram = CreateShaderProgram(vertexShaderSource, fragmentShaderSource);
-	GLuint lampShaderProgram = CreateShaderProgram(lampVertexShaderSource, lampFragmentShaderSource);
+	// Optional frame rate cap (replays always run as fast as possible)
+	FrameLimiter limiter;
+	initFrameLimiter(limiter, replaying ? 0.0 : fpsLimit);
 
 	/* Loop until the user closes the window */
 	while (!glfwWindowShouldClose(window))
 	{
-		// Set Delta Time
-		GLfloat currentFrame = glfwGetTime();
+		// A replay ends with its log
+		if (replaying && frameIndex >= replay.frames.size())
+			break;
+
+		/* Poll for and process events */
+		// On demand, sleep until input arrives (or the renderer asks for a frame)
+		bool idle = onDemand && !replaying;
+		if (idle && !frameInvalid)
+			glfwWaitEventsTimeout(IDLE_TIMEOUT);
+		else
+			glfwPollEvents();
+
+		double buildStart = glfwGetTime();
+
+		// Set Delta Time (fixed while replaying)
+		GLfloat currentFrame = replaying ? (GLfloat)(frameIndex * REPLAY_TIMESTEP) : (GLfloat)buildStart;
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
-		// Toggle Wireframe mode
-		if (wireFrame) {
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		if (replaying) {
+			const ReplayFrame& recorded = replay.frames[frameIndex];
+			ProcessInput(replay.events.data() + recorded.firstEvent, recorded.eventCount);
 		}
 		else {
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			ProcessInput(nullptr, 0);
+		}
+
+		// Poll Camera Transformation
+		TransformCamera();
+
+		// Compare against (or store) the camera this frame produced
+		CameraState camera = CurrentCameraState();
+		if (replaying && !cameraStatesMatch(camera, replay.frames[frameIndex].camera)) {
+			if (divergedFrames++ == 0)
+				cout << "Replay diverged from the recording at frame " << frameIndex << endl;
+		}
+		recordFrameEnd(recorder, frameIndex, camera);
+
+		// Scene chunks follow the camera, a newly loaded list changes the frame
+		updateSceneStream(sceneStream, cameraPosition);
+		if (pollSceneStream(sceneStream, instances, instanceMaterials)) {
+			frameInvalid = true;
 		}
 
 		// Resize window and graphics simultaneously
 		glfwGetFramebufferSize(window, &width, &height);
-		glViewport(0, 0, width, height);
-
-		/* Render here */
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		/* START PRIMARY SHADER PROGRAM */
-		// Use Shader Program exe and select VAO before drawing 
-		glUseProgram(shaderProgram); // Call Shader per-frame when updating attributes
+		// Nothing would change on screen, don't render
+		if (idle && !FrameInvalidated(camera)) {
+			countSkippedFrame();
+			ReportStats();
+			pendingInputTime = -1.0;
+			frameIndex++;
+			continue;
+		}
 
-		// Declare identity matrix
-		glm::mat4 projectionMatrix; // view
-		glm::mat4 modelMatrix; // object				
+		/* Build the next frame while the render thread draws the previous one */
+		FrameSnapshot& snapshot = beginSnapshot();
+		BuildSnapshot(snapshot, currentFrame, instances);
+		snapshot.materials = instanceMaterials;
+		snapshot.capture = capturing;
+		snapshot.inputTime = replaying ? -1.0 : pendingInputTime;
+		snapshot.inputDropped = inputQueue.dropped.load(memory_order_relaxed);
+		snapshot.buildMs = (glfwGetTime() - buildStart) * 1000.0;
+		publishSnapshot();
+		pendingInputTime = -1.0;
+		frameIndex++;
+
+		countRenderedFrame();
+		ReportStats();
+
+		// Pace to the renderer, but never let a slow frame stall input (replays draw every frame)
+		waitSnapshotConsumed(replaying ? -1.0 : framePeriod);
+		waitFrameLimiter(limiter);
+	}
 
-		// Setup views and projections
-		if (ortho) {
-			GLfloat oWidth = (GLfloat)width * 0.01f; // 10% of width
-			GLfloat oHeight = (GLfloat)height * 0.01f; // 10% of height
+	/* MAINTENANCE BEFORE SHUTDOWN */
+	stopRenderThread();
+	stopSceneStream(sceneStream);
+	// Events lost to a full queue never reached the log, so a replay of it will not match
+	if (recorder.file && inputQueue.dropped.load(memory_order_relaxed)) {
+		cout << "Warning: " << inputQueue.dropped.load(memory_order_relaxed) << " input events were dropped and are missing from the recording" << endl;
+	}
+	closeInputRecording(recorder);
+	shutdownFrameLimiter(limiter);
 
-			viewMatrix = glm::lookAt(cameraPosition, target, -worldUp);			
-			projectionMatrix = glm::ortho(-oWidth, oWidth, oHeight, -oHeight, 0.1f, 100.0f);
-		} else {
-			viewMatrix = glm::lookAt(cameraPosition, target, worldUp);
-			projectionMatrix = glm::perspective(fov, (GLfloat)width / (GLfloat)height, 0.1f, 100.0f);
-		}
+	if (replaying) {
+		cout << "Replayed " << frameIndex << " of " << replay.frames.size() << " frames, "
+			<< divergedFrames << " diverged from the recording" << endl;
+	}
 
-		// Select uniform variable and shader
-		GLuint modelLoc = glGetUniformLocation(shaderProgram, "model");
-		GLuint viewLoc = glGetUniformLocation(shaderProgram, "view");
-		GLuint projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-
-		// Get light and object color, and light position location
-		GLint objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-		GLint light1ColorLoc = glGetUniformLocation(shaderProgram, "light1Color");
-		GLint light1PosLoc = glGetUniformLocation(shaderProgram, "light1Pos");
-		GLint light2ColorLoc = glGetUniformLocation(shaderProgram, "light2Color");
-		GLint light2PosLoc = glGetUniformLocation(shaderProgram, "light2Pos");
-		GLint light3ColorLoc = glGetUniformLocation(shaderProgram, "light3Color");
-		GLint light3PosLoc = glGetUniformLocation(shaderProgram, "light3Pos");
-		GLint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
-
-		// Assign Light and Object Colors
-		glUniform3f(objectColorLoc, 1.0f, 1.0f, 1.0f);
-		glUniform3f(light1ColorLoc, 0.0f, 0.0f, 1.0f); // Primary blue light
-		glUniform3f(light2ColorLoc, 1.0f, 0.0f, 0.5f); // Secondary purple light
-		glUniform3f(light3ColorLoc, 1.0f, 0.0f, 0.5f); // Secondary purple light
-
-		// Set light positions
-		glUniform3f(light1PosLoc, lamp1Position.x, lamp1Position.y, lamp1Position.z);
-		glUniform3f(light2PosLoc, lamp2Position.x, lamp2Position.y, lamp2Position.z);
-		glUniform3f(light3PosLoc, lamp3Position.x, lamp3Position.y, lamp3Position.z);
-
-		// Set view position
-		glUniform3f(viewPosLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
-
-		// Pass transform to Shader
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-		glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-
-		/* DRAW REED */
-		glBindVertexArray(reedVAO); // User-defined VAO must be called before draw.	
-
-		glBindTexture(GL_TEXTURE_2D, reedTexture);
-		
-		// Draw primitive(s)
-		for (int i = 0; i < 2; ++i) {		
-			
-			// Rotate the second model on Z to create a complete object
-			if (i == 1) {
-				modelMatrix = glm::rotate(modelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-			}
-			
-			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-			
-			draw(sizeof(reedI));
-		}
+	glfwTerminate();
+	return 0;
+}
 
-		glBindVertexArray(0); // Unbind reed
+// Copy everything the renderer needs for this frame into the snapshot
+void BuildSnapshot(FrameSnapshot& snapshot, GLfloat time, const shared_ptr<const TransformSoA>& instances)
+{
+	snapshot.time = time;
+	snapshot.width = width;
+	snapshot.height = height;
+
+	// Declare identity matrix
+	glm::mat4 projectionMatrix; // view
+
+	// Setup views and projections
+	if (ortho) {
+		GLfloat oWidth = (GLfloat)width * 0.01f; // 10% of width
+		GLfloat oHeight = (GLfloat)height * 0.01f; // 10% of height
+
+		viewMatrix = glm::lookAt(cameraPosition, target, -worldUp);
+		projectionMatrix = glm::ortho(-oWidth, oWidth, oHeight, -oHeight, Z_NEAR, farPlane);
+	} else {
+		viewMatrix = glm::lookAt(cameraPosition, target, worldUp);
+		projectionMatrix = glm::perspective(fov, (GLfloat)width / (GLfloat)height, Z_NEAR, farPlane);
+	}
 
-		/* DRAW COVER */
-		glBindVertexArray(coverVAO); // User-defined VAO must be called before draw.
+	snapshot.camera.view = viewMatrix;
+	snapshot.camera.projection = projectionMatrix;
+	snapshot.camera.position = cameraPosition;
+	snapshot.camera.zNear = Z_NEAR;
+	snapshot.camera.zFar = farPlane;
 
-		glBindTexture(GL_TEXTURE_2D, coverTexture);
+	// Light positions and colors
+	for (int i = 0; i < LIGHT_COUNT; ++i) {
+		snapshot.lights[i] = lights[i];
+	}
 
-		// Draw primitive(s)
-		for (int i = 0; i < 2; ++i) {
+	snapshot.wireFrame = wireFrame;
+	snapshot.lightDraw = lightDraw;
+	snapshot.printStats = showStats;
+	snapshot.progressive = progressive;
+	snapshot.swapMode = swapMode;
+	snapshot.lateLatch = lateLatch;
+	snapshot.frameTargetMs = frameTargetMs;
+	snapshot.sharpenUpscale = sharpenUpscale;
+	snapshot.meshletCulling = meshletCulling;
+	snapshot.depthPrepass = depthPrepass;
+	snapshot.overdraw = overdraw;
+	snapshot.quadView = quadView;
+	snapshot.instances = instances;
+	snapshot.lamps = sceneLamps;
+
+	if (quadView) {
+		BuildQuadViews(snapshot);
+	}
+}
 
-			// Rotate the second model on Z to create a complete object
-			if (i == 1) {
-				modelMatrix = glm::rotate(modelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-			}
+// Front, side and top orthographic views framing what the perspective camera sees at the target, then the perspective
+// camera itself, each with the aspect of a quarter of the window
+void BuildQuadViews(FrameSnapshot& snapshot)
+{
+	GLfloat aspect = (GLfloat)width / (GLfloat)height;
+	GLfloat halfHeight = radius * tanf(glm::radians(fov) * 0.5f);
+	glm::mat4 orthoProjection = glm::ortho(-halfHeight * aspect, halfHeight * aspect, -halfHeight, halfHeight, Z_NEAR, farPlane);
+
+	const glm::vec3 directions[3] = { glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+	const glm::vec3 ups[3] = { worldUp, worldUp, glm::vec3(0.0f, 0.0f, -1.0f) };
+	for (int i = 0; i < 3; ++i) {
+		CameraSnapshot& view = snapshot.views[i];
+		view.position = target + directions[i] * radius;
+		view.view = glm::lookAt(view.position, target, ups[i]);
+		view.projection = orthoProjection;
+		view.zNear = Z_NEAR;
+		view.zFar = farPlane;
+	}
 
-			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-			
-			draw(sizeof(coverI));
-		}
+	snapshot.views[3] = snapshot.camera;
+	if (!ortho) {
+		snapshot.views[3].projection = glm::perspective(fov, aspect, Z_NEAR, farPlane);
+	}
+}
 
-		glBindVertexArray(0); // Unbind cover
+/* Define Input callback functions */
+// Callbacks only record events, they are applied in ProcessInput()
+// Keyboard input callback
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	InputEvent event;
+	event.time = glfwGetTime();
+	event.type = INPUT_KEY;
+	event.code = key;
+	event.action = action;
+	event.mods = mods;
+	pushInputEvent(inputQueue, event);
+}
 
-		/* DRAW COMB */
-		glBindVertexArray(combVAO); // User-defined VAO must be called before draw.		
+// Scrollwheel input callback
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+	InputEvent event;
+	event.time = glfwGetTime();
+	event.type = INPUT_SCROLL;
+	event.x = xoffset;
+	event.y = yoffset;
+	pushInputEvent(inputQueue, event);
+}
 
-		glBindTexture(GL_TEXTURE_2D, combTexture);
+// Mouse position callback
+void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
+	InputEvent event;
+	event.time = glfwGetTime();
+	event.type = INPUT_CURSOR;
+	event.x = xpos;
+	event.y = ypos;
+	pushInputEvent(inputQueue, event);
+}
 
-		// Draw primitive(s)
-		for (int i = 0; i < 2; ++i) {
+// Mouse button callback
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+	InputEvent event;
+	event.time = glfwGetTime();
+	event.type = INPUT_MOUSE_BUTTON;
+	event.code = button;
+	event.action = action;
+	event.mods = mods;
+	pushInputEvent(inputQueue, event);
+}
 
-			// Rotate the second model on Z to create a complete object
-			if (i == 1) {
-				modelMatrix = glm::rotate(modelMatrix, glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-			}
+// Window needs repainting (exposed, resized, restored)
+void window_refresh_callback(GLFWwindow* window) {
+	frameInvalid = true;
+}
 
-			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));			
+// Define key and button bindings
+void BindActions() {
+	initInputState(input);
+	bindKey(input, GLFW_KEY_F, ACTION_RESET_VIEW);
+	bindKey(input, GLFW_KEY_O, ACTION_TOGGLE_ORTHO);
+	bindKey(input, GLFW_KEY_L, ACTION_TOGGLE_LIGHTS);
+	bindKey(input, GLFW_KEY_I, ACTION_TOGGLE_STATS);
+	bindKey(input, GLFW_KEY_SPACE, ACTION_TOGGLE_WIREFRAME);
+	bindKey(input, GLFW_KEY_P, ACTION_TOGGLE_PROGRESSIVE);
+	bindKey(input, GLFW_KEY_V, ACTION_CYCLE_VSYNC);
+	bindKey(input, GLFW_KEY_Z, ACTION_TOGGLE_PREPASS);
+	bindKey(input, GLFW_KEY_H, ACTION_TOGGLE_OVERDRAW);
+	bindKey(input, GLFW_KEY_Q, ACTION_TOGGLE_QUAD_VIEW);
+	bindKey(input, GLFW_KEY_LEFT_ALT, ACTION_ORBIT_MODIFIER);
+	bindMouseButton(input, GLFW_MOUSE_BUTTON_LEFT, ACTION_ORBIT_DRAG);
+}
 
-			draw(sizeof(combI));
-		}
-		
-		glBindVertexArray(0); // Unbind comb
-		
-		glUseProgram(0); // Incase different shader will be used after
-
-		/* LAUNCH LIGHT SHADER PROGRAM */
-		glUseProgram(lampShaderProgram);
-
-		// Get matrix's uniform location and set matrix
-		GLint lampModelLoc = glGetUniformLocation(lampShaderProgram, "model");
-		GLint lampViewLoc = glGetUniformLocation(lampShaderProgram, "view");
-		GLint lampProjLoc = glGetUniformLocation(lampShaderProgram, "projection");
-
-		glUniformMatrix4fv(lampViewLoc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-		glUniformMatrix4fv(lampProjLoc, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-
-		/* DRAW LAMPS */
-		if (lightDraw) {
-			glBindVertexArray(lampVAO); // User-defined VAO must be called before draw.		
-
-			// Transform planes to form cube
-			for (GLuint i = 0; i < 6; i++) {
-				glm::mat4 modelMatrix;
-				modelMatrix = glm::translate(modelMatrix, lampPlanePositions[i] / glm::vec3(8.0f, 8.0f, 8.0f) + lamp1Position);
-				modelMatrix = glm::rotate(modelMatrix, glm::radians(lampPlaneRotations[i]), glm::vec3(0.0f, 1.0f, 0.0f));
-				modelMatrix = glm::scale(modelMatrix, glm::vec3(.125f, .125f, .125f));
-				if (i >= 4)
-					modelMatrix = glm::rotate(modelMatrix, glm::radians(lampPlaneRotations[i]), glm::vec3(1.0f, 0.0f, 0.0f));
-				glUniformMatrix4fv(lampModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-				// Draw primitive(s)
-				draw(sizeof(lampI));
-			}
+// Apply replayed events, then every queued event in the order it happened
+void ProcessInput(const InputEvent* replayEvents, size_t replayCount) {
+	beginInputFrame(input);
 
-			// Transform planes to form cube
-			for (GLuint i = 0; i < 6; i++) {
-				glm::mat4 modelMatrix;
-				modelMatrix = glm::translate(modelMatrix, lampPlanePositions[i] / glm::vec3(8.0f, 8.0f, 8.0f) + lamp2Position);
-				modelMatrix = glm::rotate(modelMatrix, glm::radians(lampPlaneRotations[i]), glm::vec3(0.0f, 1.0f, 0.0f));
-				modelMatrix = glm::scale(modelMatrix, glm::vec3(.125f, .125f, .125f));
-				if (i >= 4)
-					modelMatrix = glm::rotate(modelMatrix, glm::radians(lampPlaneRotations[i]), glm::vec3(1.0f, 0.0f, 0.0f));
-				glUniformMatrix4fv(lampModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-				// Draw primitive(s)
-				draw(sizeof(lampI));
-			}
+	for (size_t i = 0; i < replayCount; ++i) {
+		ApplyInput(replayEvents[i]);
+	}
 
-			// Transform planes to form cube
-			for (GLuint i = 0; i < 6; i++) {
-				glm::mat4 modelMatrix;
-				modelMatrix = glm::translate(modelMatrix, lampPlanePositions[i] / glm::vec3(8.0f, 8.0f, 8.0f) + lamp3Position);
-				modelMatrix = glm::rotate(modelMatrix, glm::radians(lampPlaneRotations[i]), glm::vec3(0.0f, 1.0f, 0.0f));
-				modelMatrix = glm::scale(modelMatrix, glm::vec3(.125f, .125f, .125f));
-				if (i >= 4)
-					modelMatrix = glm::rotate(modelMatrix, glm::radians(lampPlaneRotations[i]), glm::vec3(1.0f, 0.0f, 0.0f));
-				glUniformMatrix4fv(lampModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-				// Draw primitive(s)
-				draw(sizeof(lampI));
-			}
+	InputEvent event;
+	while (popInputEvent(inputQueue, event)) {
+		recordInputEvent(recorder, frameIndex, event);
 
-			glBindVertexArray(0); // Unbind lamp
+		// Latency is measured from the first event that changed the view
+		if (ApplyInput(event) && pendingInputTime < 0.0) {
+			pendingInputTime = event.time;
 		}
+	}
+}
 
-		/* Swap front and back buffers */
-		glfwSwapBuffers(window);
+// Update actions and camera from one event, true if it can change what is drawn
+bool ApplyInput(const InputEvent& event) {
+	applyInputEvent(input, event);
 
-		/* Poll for and process events */
-		glfwPollEvents();
+	// Orbit camera
+	isOrbiting = actionDown(input, ACTION_ORBIT_MODIFIER) && actionDown(input, ACTION_ORBIT_DRAG);
 
-		// Poll Camera Transformation
-		TransformCamera();
+	if (event.type == INPUT_CURSOR && isOrbiting) {
+		OrbitCamera((GLfloat)input.cursorDeltaX, (GLfloat)input.cursorDeltaY);
+		return true;
 	}
 
-	/* MAINTENANCE BEFORE SHUTDOWN */
-	glDeleteVertexArrays(1, &reedVAO);
-	glDeleteBuffers(1, &reedVBO);
-	glDeleteBuffers(1, &reedEBO);
-
-	glDeleteVertexArrays(1, &combVAO);
-	glDeleteBuffers(1, &combVBO);
-	glDeleteBuffers(1, &combEBO);
+	if (event.type == INPUT_SCROLL) {
+		ZoomCamera((GLfloat)event.y);
+		return true;
+	}
 
-	glDeleteVertexArrays(1, &coverVAO);
-	glDeleteBuffers(1, &coverVBO);
-	glDeleteBuffers(1, &coverEBO);
+	return event.type == INPUT_KEY && event.action == GLFW_PRESS;
+}
 
-	glDeleteVertexArrays(1, &lampVAO);
-	glDeleteBuffers(1, &lampVBO);
-	glDeleteBuffers(1, &lampEBO);
+// Once per second: load and latency reports (when stats are shown)
+void ReportStats() {
+	double now = glfwGetTime();
+	updateLoad(now, showStats);
 
-	glfwTerminate();
-	return 0;
+	LatencySample latency;
+	if (updateLatency(now, latency) && showStats && latency.count) {
+		cout << "Input latency: " << latency.averageMs << "ms average, " << latency.maxMs << "ms max over "
+			<< latency.count << " frames" << endl;
+	}
 }
 
-/* Define Input callback functions */
-// Keyboard input callback
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-	if (action == GLFW_PRESS) {
-		keys[key] = true;
+// Camera and view toggles after this frame's input
+CameraState CurrentCameraState() {
+	CameraState camera;
+	camera.position = cameraPosition;
+	camera.yaw = rawYaw;
+	camera.pitch = rawPitch;
+	camera.fov = fov;
+	camera.flags = (uint8_t)((ortho ? CAMERA_ORTHO : 0) | (wireFrame << CAMERA_WIREFRAME_SHIFT) | (lightDraw ? CAMERA_LIGHTS : 0) | (progressive ? CAMERA_PROGRESSIVE : 0) | (quadView ? CAMERA_QUAD_VIEW : 0) |
+		(depthPrepass ? CAMERA_PREPASS : 0) | (overdraw ? CAMERA_OVERDRAW : 0));
+	return camera;
+}
 
-		// Toggle wireframe mode
-		if (key == GLFW_KEY_SPACE) {
-			wireFrame = !wireFrame;
-		}
+// True if the next frame would differ from the one on screen, remembers what is being rendered
+bool FrameInvalidated(const CameraState& camera) {
+	bool redraw = consumeRedrawRequest();	// Reloaded shader, finished compile, animation
+
+	bool changed = frameInvalid || redraw ||
+		width != renderedWidth || height != renderedHeight ||
+		showStats != renderedStats ||
+		camera.position != renderedCamera.position ||
+		camera.fov != renderedCamera.fov ||
+		camera.flags != renderedCamera.flags;
+
+	if (changed) {
+		frameInvalid = false;
+		renderedCamera = camera;
+		renderedWidth = width;
+		renderedHeight = height;
+		renderedStats = showStats;
+	}
 
-		// Toggle orthographic projection
-		if (key == GLFW_KEY_O) {
-			ortho = !ortho;
-		}
+	return changed;
+}
 
-		// Toggle light draw
-		if (key == GLFW_KEY_L) {
-			lightDraw = !lightDraw;
-		}
-	} else if (action == GLFW_RELEASE) {
-		keys[key] = false;
+// Orbit the camera by a cursor offset
+void OrbitCamera(GLfloat xChange, GLfloat yChange) {
+	if (ortho) {
+		rawYaw -= xChange;
+	} else {
+		rawYaw += xChange;
 	}
+	rawPitch += yChange;
+
+	degYaw = glm::radians(rawYaw);
+	degPitch = glm::clamp(glm::radians(rawPitch), -glm::pi<float>() / 2.0f + 0.1f, glm::pi<float>() / 2.0f - 0.1f);
+
+	// Azimuth Altitude Formula
+	cameraPosition.x = target.x + radius * cosf(degPitch) * sinf(degYaw);
+	cameraPosition.y = target.y + radius * sinf(degPitch);
+	cameraPosition.z = target.z + radius * cosf(degPitch) * cosf(degYaw);
 }
 
-// Scrollwheel input callback
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+// Zoom the camera by a scroll offset
+void ZoomCamera(GLfloat offset) {
 	// only scroll if not in ortho mode
 	if (!ortho) {
 		if (fov >= FOV_MIN && fov <= FOV_MAX) {
-			fov -= yoffset * SCROLL_SPEED;
+			fov -= offset * SCROLL_SPEED;
 		}
 
 		// clamp FOV
@@ -1108,76 +943,159 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 	}
 }
 
-// Mouse position callback
-void cursor_position_callback(GLFWwindow* window, double xpos, double ypos) {
-	if (firstMouseMove) {
-		lastX = xpos;
-		lastY = ypos;
-		firstMouseMove = false;
+// Define transform camera function
+void TransformCamera() {
+	// Cycle wireframe off -> overlay -> hidden-line -> all edges
+	for (int i = 0; i < actionPressed(input, ACTION_TOGGLE_WIREFRAME); ++i) {
+		wireFrame = (WireframeMode)((wireFrame + 1) % WIREFRAME_MODE_COUNT);
 	}
 
-	// Calculate cursor offset
-	xChange = xpos - lastX;
-	yChange = lastY - ypos; // inverted Y axis
+	// Toggles flip once per press, including presses released within the frame
 
-	lastX = xpos;
-	lastY = ypos;
+	if (actionPressed(input, ACTION_TOGGLE_ORTHO) % 2) {
+		ortho = !ortho;
+	}
 
-	// Orbit camera
-	if (isOrbiting) {
-		if (ortho) {
-			rawYaw -= xChange;
-		} else {
-			rawYaw += xChange;
-		}
-		rawPitch += yChange;
+	if (actionPressed(input, ACTION_TOGGLE_LIGHTS) % 2) {
+		lightDraw = !lightDraw;
+	}
 
-		degYaw = glm::radians(rawYaw);
-		degPitch = glm::clamp(glm::radians(rawPitch), -glm::pi<float>() / 2.0f + 0.1f, glm::pi<float>() / 2.0f - 0.1f);
+	if (actionPressed(input, ACTION_TOGGLE_STATS) % 2) {
+		showStats = !showStats;
+	}
 
-		// Azimuth Altitude Formula
-		cameraPosition.x = target.x + radius * cosf(degPitch) * sinf(degYaw);
-		cameraPosition.y = target.y + radius * sinf(degPitch);
-		cameraPosition.z = target.z + radius * cosf(degPitch) * cosf(degYaw);
+	if (actionPressed(input, ACTION_TOGGLE_PROGRESSIVE) % 2) {
+		progressive = !progressive;
 	}
-}
 
-// Mouse button callback
-void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
-	if (action == GLFW_PRESS) {
-		mouseButton[button] = true;
+	if (actionPressed(input, ACTION_TOGGLE_PREPASS) % 2) {
+		depthPrepass = !depthPrepass;
 	}
-	else if (action == GLFW_RELEASE) {
-		mouseButton[button] = false;
+
+	if (actionPressed(input, ACTION_TOGGLE_OVERDRAW) % 2) {
+		overdraw = !overdraw;
 	}
-}
 
-// Define transform camera function
-void TransformCamera() {
-	// Orbit camera
-	if (keys[GLFW_KEY_LEFT_ALT] && mouseButton[GLFW_MOUSE_BUTTON_LEFT]) {
-		isOrbiting = true;
+	if (actionPressed(input, ACTION_TOGGLE_QUAD_VIEW) % 2) {
+		quadView = !quadView;
 	}
-	else {
-		isOrbiting = false;
+
+	// Cycle vsync off -> on -> adaptive, the render thread applies it with the next frame
+	for (int i = 0; i < actionPressed(input, ACTION_CYCLE_VSYNC); ++i) {
+		swapMode = (SwapMode)((swapMode + 1) % 3);
+		frameInvalid = true;
 	}
 
 	// Reset camera
-	if (keys[GLFW_KEY_F]) {
+	if (actionDown(input, ACTION_RESET_VIEW) || actionPressed(input, ACTION_RESET_VIEW)) {
 		initCamera();
 	}
 }
 
 // Define initcamera function
 void initCamera() {
-	// Reset camera attributes
-	cameraPosition = glm::vec3(0.0f, 0.0f, 10.0f);
-	target = glm::vec3(0.0f, 0.0f, 0.0f);
+	// Reset camera attributes to the home camera
+	cameraPosition = homeCamera.position;
+	target = homeCamera.target;
 	cameraDirection = glm::normalize(cameraPosition - target);
 	worldUp = glm::vec3(0.0f, 1.0f, 0.0f);
 	cameraRight = glm::normalize(glm::cross(worldUp, cameraDirection));
 	cameraUp = glm::normalize(glm::cross(cameraDirection, cameraRight));	
-	fov = 45.0f;
-	rawPitch = 0.0f;
-	rawYaw = 0.0f;
-}
\ No newline at end of file
+	fov = homeCamera.fov;
+
+	// Orbit angles and radius that reproduce the position
+	glm::vec3 offset = cameraPosition - target;
+	radius = glm::length(offset);
+	rawPitch = glm::degrees(asinf(offset.y / radius));
+	rawYaw = glm::degrees(atan2f(offset.x, offset.z));
+}
+
+// Take the lights, first camera and materials of the loaded scene
+void ApplyScene() {
+	if (!scene.lights.empty()) {
+		// The shader has LIGHT_COUNT lights, the others are only drawn as lamps
+		if (scene.lights.size() > (size_t)LIGHT_COUNT) {
+			cout << "Scene has " << scene.lights.size() << " lights, only the first " << LIGHT_COUNT << " shade it" << endl;
+			shared_ptr<vector<glm::vec3>> lamps = make_shared<vector<glm::vec3>>();
+			for (const SceneLight& light : scene.lights) {
+				lamps->push_back(light.position);
+			}
+			sceneLamps = lamps;
+		}
+
+		// Lights the scene doesn't have are switched off
+		for (int i = 0; i < LIGHT_COUNT; ++i) {
+			lights[i] = (size_t)i < scene.lights.size() ? LightSnapshot{ scene.lights[i].position, scene.lights[i].color } : LightSnapshot{ scene.lights[0].position, glm::vec3(0.0f) };
+		}
+	}
+
+	// A camera sitting on its target has no orbit
+	if (!scene.cameras.empty() && glm::length(scene.cameras[0].position - scene.cameras[0].target) > 0.001f) {
+		homeCamera = scene.cameras[0];
+		ortho = homeCamera.ortho;
+		initCamera();
+	}
+
+	// Far plane reaches the far side of the scene from anywhere on the orbit
+	glm::vec3 low, high;
+	if (sceneBounds(scene, low, high)) {
+		GLfloat reach = radius + glm::length(target - (low + high) * 0.5f) + glm::length(high - low) * 0.5f + GENERATOR_SPACING;
+		farPlane = glm::max(Z_FAR, reach);
+	}
+
+	// Every instance draws with the textures of its mesh's material
+	setSceneMaterials(scene.materials);
+}
+
+// Both halves of a part in one mesh: the half and its copy rotated 180 degrees on Z
+MeshData WholePart(const MeshData& half) {
+	MeshData whole = half;
+	GLuint offset = (GLuint)(half.vertices.size() / half.stride);
+	for (size_t v = 0; v < half.vertices.size(); v += half.stride) {
+		const GLfloat* vertex = &half.vertices[v];
+		whole.vertices.insert(whole.vertices.end(), vertex, vertex + half.stride);
+		GLfloat* copy = &whole.vertices[whole.vertices.size() - half.stride];
+		copy[0] = -copy[0];
+		copy[1] = -copy[1];
+		if (half.stride == FULL_VERTEX_STRIDE) {
+			copy[8] = -copy[8];
+			copy[9] = -copy[9];
+		}
+	}
+	for (GLuint index : half.indices) {
+		whole.indices.push_back(index + offset);
+	}
+	return whole;
+}
+
+// Every light of the scene with the diffuse strength harmonica.frag gives it
+vector<BakeLight> BakeLights() {
+	vector<BakeLight> baked;
+	for (int i = 0; i < LIGHT_COUNT; ++i) {
+		baked.push_back(BakeLight{ lights[i].position, lights[i].color, i == 0 ? PRIMARY_DIFFUSE : SECONDARY_DIFFUSE });
+	}
+
+	// Lights past LIGHT_COUNT only exist in the bake
+	for (size_t i = LIGHT_COUNT; i < scene.lights.size(); ++i) {
+		baked.push_back(BakeLight{ scene.lights[i].position, scene.lights[i].color, SECONDARY_DIFFUSE });
+	}
+	return baked;
+}
+
+// Box covering every harmonica of the scene (or the single one at the origin), grown by the model's reach
+void LightingBounds(const HarmonicaParams& shape, glm::vec3& low, glm::vec3& high) {
+	if (!sceneBounds(scene, low, high)) {
+		low = high = glm::vec3(0.0f);
+	}
+
+	// Both halves are the part mirrored through the Z axis, so the farthest vertex bounds either
+	GLfloat reach = 0.0f;
+	for (int part = MESH_REED; part <= MESH_COMB; ++part) {
+		MeshData data = generateHarmonicaMesh(shape, (HarmonicaMesh)part);
+		for (size_t v = 0; v + 2 < data.vertices.size(); v += data.stride) {
+			reach = glm::max(reach, glm::length(glm::vec3(data.vertices[v], data.vertices[v + 1], data.vertices[v + 2])));
+		}
+	}
+	low -= glm::vec3(reach);
+	high += glm::vec3(reach);
+}
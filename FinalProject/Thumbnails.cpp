@@ -0,0 +1,205 @@
+#include "Thumbnails.h"
+
+#include <GLEW/glew.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <SOIL2\SOIL2.h>
+
+#include "Renderer.h"
+#include "Offscreen.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+/* Constants */
+const int ATLAS_COLUMNS = 4;				// Tiles per row of the offscreen target
+const int ATLAS_ROWS = (MAX_VIEWS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+const size_t MAX_QUEUED_IMAGES = 256;		// Thumbnails waiting for the encoders before rendering waits
+
+/* Batch being read back */
+struct ThumbnailBatch {
+	GLuint pbo = 0;
+	GLsync fence = 0;
+	size_t first = 0;			// Index of the batch's first pose
+	int count = 0;
+};
+
+// Parse the poses file
+bool loadThumbnailPoses(const string& path, vector<ThumbnailPose>& poses)
+{
+	ifstream file(path);
+	if (!file) {
+		cout << "Could not open poses file " << path << endl;
+		return false;
+	}
+
+	string line;
+	int lineNumber = 0;
+	while (getline(file, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		istringstream fields(line);
+		ThumbnailPose pose;
+		string projection;
+		if (!(fields >> pose.yaw))
+			continue;
+		if (!(fields >> pose.pitch >> pose.radius >> pose.fov >> projection) || (projection != "ortho" && projection != "perspective")) {
+			cout << path << ":" << lineNumber << ": expected yaw pitch radius fov ortho|perspective [name]" << endl;
+			return false;
+		}
+
+		pose.ortho = projection == "ortho";
+		if (!(fields >> pose.name)) {
+			char name[32];
+			snprintf(name, sizeof(name), "thumb_%05d", lineNumber);
+			pose.name = name;
+		}
+		poses.push_back(pose);
+	}
+
+	return true;
+}
+
+// Camera of a pose, orbiting the origin like the interactive camera
+static CameraSnapshot PoseCamera(const ThumbnailPose& pose, const CameraSnapshot& base)
+{
+	const glm::vec3 target(0.0f), worldUp(0.0f, 1.0f, 0.0f);
+	GLfloat yaw = glm::radians(pose.yaw);
+	GLfloat pitch = glm::clamp(glm::radians(pose.pitch), -glm::pi<float>() / 2.0f + 0.1f, glm::pi<float>() / 2.0f - 0.1f);
+
+	CameraSnapshot camera = base;
+	camera.position = target + pose.radius * glm::vec3(cosf(pitch) * sinf(yaw), sinf(pitch), cosf(pitch) * cosf(yaw));
+	camera.view = glm::lookAt(camera.position, target, worldUp);
+
+	if (pose.ortho) {
+		GLfloat halfHeight = pose.radius * tanf(glm::radians(pose.fov) * 0.5f);
+		camera.projection = glm::ortho(-halfHeight, halfHeight, -halfHeight, halfHeight, base.zNear, base.zFar);
+	}
+	else {
+		camera.projection = glm::perspective(pose.fov, 1.0f, base.zNear, base.zFar);
+	}
+	return camera;
+}
+
+// Cut a batch's tiles out of its read-back and queue them for encoding
+static void FinishBatch(ThumbnailBatch& batch, const vector<ThumbnailPose>& poses, const string& folder, int size, WorkerPool& encoders)
+{
+	if (!batch.fence)
+		return;
+
+	glClientWaitSync(batch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(batch.fence);
+	batch.fence = 0;
+
+	size_t rowSize = (size_t)ATLAS_COLUMNS * size * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, batch.pbo);
+	const unsigned char* atlas = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowSize * ATLAS_ROWS * size, GL_MAP_READ_BIT));
+	if (!atlas) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		return;
+	}
+
+	for (int i = 0; i < batch.count; ++i) {
+		// RGB rows from the top, GL rows start at the bottom of the tile
+		shared_ptr<vector<unsigned char>> pixels = make_shared<vector<unsigned char>>((size_t)size * size * 3);
+		const unsigned char* tile = atlas + (size_t)(i / ATLAS_COLUMNS) * size * rowSize + (size_t)(i % ATLAS_COLUMNS) * size * 4;
+		for (int y = 0; y < size; ++y) {
+			const unsigned char* source = tile + (size_t)(size - 1 - y) * rowSize;
+			unsigned char* target = pixels->data() + (size_t)y * size * 3;
+			for (int x = 0; x < size; ++x)
+				memcpy(target + x * 3, source + x * 4, 3);
+		}
+
+		string path = folder + "/" + poses[batch.first + i].name + ".png";
+		submitWork(encoders, [pixels, path, size] {
+			if (!SOIL_save_image(path.c_str(), SOIL_SAVE_TYPE_PNG, size, size, 3, pixels->data()))
+				cout << "Failed to save thumbnail " << path << endl;
+		});
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// Encoders are behind, hold off so queued images do not pile up
+	if (pendingWork(encoders) > MAX_QUEUED_IMAGES)
+		waitWorkerPool(encoders, MAX_QUEUED_IMAGES / 2);
+}
+
+// Render every pose into folder, on the calling thread with the window's (hidden) context
+bool renderThumbnails(GLFWwindow* window, const FrameSnapshot& scene, const vector<ThumbnailPose>& poses, const string& folder, int size)
+{
+	double start = glfwGetTime();
+
+	/* Offscreen target holding one batch of tiles */
+	int atlasWidth = ATLAS_COLUMNS * size, atlasHeight = ATLAS_ROWS * size;
+	OffscreenTarget target;
+	if (!initOffscreenRenderer(window, target, atlasWidth, atlasHeight))
+		return false;
+
+	// Two read-backs: one in flight while the other batch renders
+	ThumbnailBatch batches[2];
+	for (ThumbnailBatch& batch : batches) {
+		glGenBuffers(1, &batch.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, batch.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)atlasWidth * atlasHeight * 4, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	WorkerPool encoders;
+	startWorkerPool(encoders);
+
+	bool ok = true;
+	CameraSnapshot cameras[MAX_VIEWS];
+	int current = 0;
+	for (size_t first = 0; first < poses.size(); first += MAX_VIEWS) {
+		int count = (int)min(poses.size() - first, (size_t)MAX_VIEWS);
+		for (int i = 0; i < count; ++i)
+			cameras[i] = PoseCamera(poses[first + i], scene.camera);
+
+		if (!renderViews(scene, cameras, count, ATLAS_COLUMNS, size, size)) {
+			cout << "Shaders did not compile, no thumbnails rendered" << endl;
+			ok = false;
+			break;
+		}
+
+		// Read into the free buffer, then hand over the previous batch while this one copies
+		ThumbnailBatch& batch = batches[current];
+		FinishBatch(batch, poses, folder, size, encoders);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, batch.pbo);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, atlasWidth, atlasHeight, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		batch.first = first;
+		batch.count = count;
+
+		current = 1 - current;
+		FinishBatch(batches[current], poses, folder, size, encoders);
+	}
+
+	FinishBatch(batches[current], poses, folder, size, encoders);
+	FinishBatch(batches[1 - current], poses, folder, size, encoders);
+	stopWorkerPool(encoders);
+
+	if (ok) {
+		double seconds = glfwGetTime() - start;
+		cout << "Rendered " << poses.size() << " thumbnails in " << seconds << "s ("
+			<< (seconds > 0.0 ? poses.size() * 60.0 / seconds : 0.0) << " per minute)" << endl;
+	}
+
+	/* MAINTENANCE BEFORE SHUTDOWN */
+	for (ThumbnailBatch& batch : batches)
+		glDeleteBuffers(1, &batch.pbo);
+	freeOffscreenRenderer(target);
+	glfwMakeContextCurrent(nullptr);
+	return ok;
+}
@@ -0,0 +1,39 @@
+/* Description:
+Batch thumbnail rendering. Reads a list of camera poses and
+renders the harmonica from each into a PNG, without showing
+a window or starting the render thread.
+
+Poses file, one pose per line (# starts a comment):
+	yaw pitch radius fov ortho|perspective [name]
+Angles are in degrees and orbit the origin like the ALT +
+drag camera; fov is passed to the projection like the
+interactive camera's. Orthographic views frame the same
+height at the target as a perspective view of that fov.
+Thumbnails are named <name>.png, or thumb_<line>.png.
+
+Views are drawn MAX_VIEWS at a time into tiles of one
+offscreen target (one pass with a viewport array when the
+driver has one), read back while the next batch renders and
+encoded on a pool of worker threads.
+*/
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <string>
+#include <vector>
+
+#include "FrameSnapshot.h"
+
+/* One thumbnail's camera */
+struct ThumbnailPose {
+	float yaw = 0.0f;
+	float pitch = 0.0f;
+	float radius = 10.0f;
+	float fov = 45.0f;
+	bool ortho = false;
+	std::string name;
+};
+
+/* Thumbnail prototypes */
+bool loadThumbnailPoses(const std::string& path, std::vector<ThumbnailPose>& poses);
+bool renderThumbnails(GLFWwindow* window, const FrameSnapshot& scene, const std::vector<ThumbnailPose>& poses, const std::string& folder, int size);
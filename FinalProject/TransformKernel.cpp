@@ -0,0 +1,360 @@
+#include "TransformKernel.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORM_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TRANSFORM_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+void clearTransforms(TransformSoA& t)
+{
+	t.px.clear(); t.py.clear(); t.pz.clear();
+	t.qx.clear(); t.qy.clear(); t.qz.clear(); t.qw.clear();
+	t.sx.clear(); t.sy.clear(); t.sz.clear();
+}
+
+void addTransform(TransformSoA& t, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	t.px.push_back(position.x); t.py.push_back(position.y); t.pz.push_back(position.z);
+	t.qx.push_back(rotation.x); t.qy.push_back(rotation.y); t.qz.push_back(rotation.z); t.qw.push_back(rotation.w);
+	t.sx.push_back(scale.x); t.sy.push_back(scale.y); t.sz.push_back(scale.z);
+}
+
+size_t transformCount(const TransformSoA& t)
+{
+	return t.px.size();
+}
+
+// Reference kernel, one instance at a time
+void transformInstancesScalar(const TransformSoA& t, size_t first, size_t count, float* world, float* normal)
+{
+	for (size_t i = first; i < first + count; ++i) {
+		float x = t.qx[i], y = t.qy[i], z = t.qz[i], w = t.qw[i];
+
+		// Rotation matrix columns from the quaternion
+		float r00 = 1.0f - 2.0f * (y * y + z * z), r01 = 2.0f * (x * y + w * z), r02 = 2.0f * (x * z - w * y);
+		float r10 = 2.0f * (x * y - w * z), r11 = 1.0f - 2.0f * (x * x + z * z), r12 = 2.0f * (y * z + w * x);
+		float r20 = 2.0f * (x * z + w * y), r21 = 2.0f * (y * z - w * x), r22 = 1.0f - 2.0f * (x * x + y * y);
+
+		float sx = t.sx[i], sy = t.sy[i], sz = t.sz[i];
+		float* m = world + (i - first) * WORLD_FLOATS;
+		m[0] = r00 * sx;	m[1] = r01 * sx;	m[2] = r02 * sx;	m[3] = 0.0f;
+		m[4] = r10 * sy;	m[5] = r11 * sy;	m[6] = r12 * sy;	m[7] = 0.0f;
+		m[8] = r20 * sz;	m[9] = r21 * sz;	m[10] = r22 * sz;	m[11] = 0.0f;
+		m[12] = t.px[i];	m[13] = t.py[i];	m[14] = t.pz[i];	m[15] = 1.0f;
+
+		float ix = 1.0f / sx, iy = 1.0f / sy, iz = 1.0f / sz;
+		float* n = normal + (i - first) * NORMAL_FLOATS;
+		n[0] = r00 * ix;	n[1] = r01 * ix;	n[2] = r02 * ix;	n[3] = 0.0f;
+		n[4] = r10 * iy;	n[5] = r11 * iy;	n[6] = r12 * iy;	n[7] = 0.0f;
+		n[8] = r20 * iz;	n[9] = r21 * iz;	n[10] = r22 * iz;	n[11] = 0.0f;
+	}
+}
+
+#ifdef TRANSFORM_X86
+// Transpose 8 component vectors (one lane per instance) into 8 rows of 8 components
+TARGET_AVX2 static inline void Transpose8(__m256 r[8])
+{
+	__m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	__m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	__m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	__m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44), s1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44), s3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44), s5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44), s7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+
+	r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// 8 instances per iteration, remainder handled by the scalar kernel
+TARGET_AVX2 static void TransformInstancesAVX2(const TransformSoA& t, size_t first, size_t count, float* world, float* normal)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		size_t k = first + i;
+		__m256 x = _mm256_loadu_ps(&t.qx[k]), y = _mm256_loadu_ps(&t.qy[k]);
+		__m256 z = _mm256_loadu_ps(&t.qz[k]), w = _mm256_loadu_ps(&t.qw[k]);
+
+		__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+		__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+		__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+		// Rotation matrix columns
+		__m256 r00 = _mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one);
+		__m256 r01 = _mm256_mul_ps(two, _mm256_add_ps(xy, wz));
+		__m256 r02 = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy));
+		__m256 r10 = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz));
+		__m256 r11 = _mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one);
+		__m256 r12 = _mm256_mul_ps(two, _mm256_add_ps(yz, wx));
+		__m256 r20 = _mm256_mul_ps(two, _mm256_add_ps(xz, wy));
+		__m256 r21 = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx));
+		__m256 r22 = _mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one);
+
+		__m256 sx = _mm256_loadu_ps(&t.sx[k]), sy = _mm256_loadu_ps(&t.sy[k]), sz = _mm256_loadu_ps(&t.sz[k]);
+		__m256 ix = _mm256_div_ps(one, sx), iy = _mm256_div_ps(one, sy), iz = _mm256_div_ps(one, sz);
+
+		// World matrix: components 0-7 and 8-15, transposed to one row per instance
+		__m256 lo[8] = {
+			_mm256_mul_ps(r00, sx), _mm256_mul_ps(r01, sx), _mm256_mul_ps(r02, sx), zero,
+			_mm256_mul_ps(r10, sy), _mm256_mul_ps(r11, sy), _mm256_mul_ps(r12, sy), zero
+		};
+		__m256 hi[8] = {
+			_mm256_mul_ps(r20, sz), _mm256_mul_ps(r21, sz), _mm256_mul_ps(r22, sz), zero,
+			_mm256_loadu_ps(&t.px[k]), _mm256_loadu_ps(&t.py[k]), _mm256_loadu_ps(&t.pz[k]), one
+		};
+		Transpose8(lo);
+		Transpose8(hi);
+
+		// Normal matrix: components 0-7, then 8-11 (upper half of the second transpose is unused)
+		__m256 nlo[8] = {
+			_mm256_mul_ps(r00, ix), _mm256_mul_ps(r01, ix), _mm256_mul_ps(r02, ix), zero,
+			_mm256_mul_ps(r10, iy), _mm256_mul_ps(r11, iy), _mm256_mul_ps(r12, iy), zero
+		};
+		__m256 nhi[8] = {
+			_mm256_mul_ps(r20, iz), _mm256_mul_ps(r21, iz), _mm256_mul_ps(r22, iz), zero,
+			zero, zero, zero, zero
+		};
+		Transpose8(nlo);
+		Transpose8(nhi);
+
+		for (int j = 0; j < 8; ++j) {
+			float* m = world + (i + j) * WORLD_FLOATS;
+			_mm256_storeu_ps(m, lo[j]);
+			_mm256_storeu_ps(m + 8, hi[j]);
+
+			float* n = normal + (i + j) * NORMAL_FLOATS;
+			_mm256_storeu_ps(n, nlo[j]);
+			_mm_storeu_ps(n + 8, _mm256_castps256_ps128(nhi[j]));
+		}
+	}
+
+	if (i < count)
+		transformInstancesScalar(t, first + i, count - i, world + i * WORLD_FLOATS, normal + i * NORMAL_FLOATS);
+}
+
+// Runtime check, the binary itself does not require AVX2
+static bool CpuHasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	__cpuid(info, 1);
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	return avx2 && fma && osxsave && (_xgetbv(0) & 0x6) == 0x6;
+#else
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+static const bool useAVX2 = CpuHasAVX2();
+#endif
+
+#ifdef TRANSFORM_NEON
+// Transpose 4 component vectors (one lane per instance) into 4 rows of 4 components
+static inline void Transpose4(float32x4_t r[4])
+{
+	float32x4x2_t t01 = vtrnq_f32(r[0], r[1]);
+	float32x4x2_t t23 = vtrnq_f32(r[2], r[3]);
+	r[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+	r[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+	r[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+	r[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+// Store one column (4 components) of 4 instances
+static inline void StoreColumn(float32x4_t c[4], float* out, size_t stride)
+{
+	Transpose4(c);
+	for (int j = 0; j < 4; ++j)
+		vst1q_f32(out + j * stride, c[j]);
+}
+
+// 4 instances per iteration, remainder handled by the scalar kernel
+static void TransformInstancesNEON(const TransformSoA& t, size_t first, size_t count, float* world, float* normal)
+{
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float32x4_t two = vdupq_n_f32(2.0f);
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		size_t k = first + i;
+		float32x4_t x = vld1q_f32(&t.qx[k]), y = vld1q_f32(&t.qy[k]);
+		float32x4_t z = vld1q_f32(&t.qz[k]), w = vld1q_f32(&t.qw[k]);
+
+		float32x4_t xx = vmulq_f32(x, x), yy = vmulq_f32(y, y), zz = vmulq_f32(z, z);
+		float32x4_t xy = vmulq_f32(x, y), xz = vmulq_f32(x, z), yz = vmulq_f32(y, z);
+		float32x4_t wx = vmulq_f32(w, x), wy = vmulq_f32(w, y), wz = vmulq_f32(w, z);
+
+		// Rotation matrix columns
+		float32x4_t r00 = vmlsq_f32(one, two, vaddq_f32(yy, zz));
+		float32x4_t r01 = vmulq_f32(two, vaddq_f32(xy, wz));
+		float32x4_t r02 = vmulq_f32(two, vsubq_f32(xz, wy));
+		float32x4_t r10 = vmulq_f32(two, vsubq_f32(xy, wz));
+		float32x4_t r11 = vmlsq_f32(one, two, vaddq_f32(xx, zz));
+		float32x4_t r12 = vmulq_f32(two, vaddq_f32(yz, wx));
+		float32x4_t r20 = vmulq_f32(two, vaddq_f32(xz, wy));
+		float32x4_t r21 = vmulq_f32(two, vsubq_f32(yz, wx));
+		float32x4_t r22 = vmlsq_f32(one, two, vaddq_f32(xx, yy));
+
+		float32x4_t sx = vld1q_f32(&t.sx[k]), sy = vld1q_f32(&t.sy[k]), sz = vld1q_f32(&t.sz[k]);
+		float32x4_t ix = vdivq_f32(one, sx), iy = vdivq_f32(one, sy), iz = vdivq_f32(one, sz);
+
+		float* m = world + i * WORLD_FLOATS;
+		float32x4_t c0[4] = { vmulq_f32(r00, sx), vmulq_f32(r01, sx), vmulq_f32(r02, sx), zero };
+		float32x4_t c1[4] = { vmulq_f32(r10, sy), vmulq_f32(r11, sy), vmulq_f32(r12, sy), zero };
+		float32x4_t c2[4] = { vmulq_f32(r20, sz), vmulq_f32(r21, sz), vmulq_f32(r22, sz), zero };
+		float32x4_t c3[4] = { vld1q_f32(&t.px[k]), vld1q_f32(&t.py[k]), vld1q_f32(&t.pz[k]), one };
+		StoreColumn(c0, m, WORLD_FLOATS);
+		StoreColumn(c1, m + 4, WORLD_FLOATS);
+		StoreColumn(c2, m + 8, WORLD_FLOATS);
+		StoreColumn(c3, m + 12, WORLD_FLOATS);
+
+		float* n = normal + i * NORMAL_FLOATS;
+		float32x4_t n0[4] = { vmulq_f32(r00, ix), vmulq_f32(r01, ix), vmulq_f32(r02, ix), zero };
+		float32x4_t n1[4] = { vmulq_f32(r10, iy), vmulq_f32(r11, iy), vmulq_f32(r12, iy), zero };
+		float32x4_t n2[4] = { vmulq_f32(r20, iz), vmulq_f32(r21, iz), vmulq_f32(r22, iz), zero };
+		StoreColumn(n0, n, NORMAL_FLOATS);
+		StoreColumn(n1, n + 4, NORMAL_FLOATS);
+		StoreColumn(n2, n + 8, NORMAL_FLOATS);
+	}
+
+	if (i < count)
+		transformInstancesScalar(t, first + i, count - i, world + i * WORLD_FLOATS, normal + i * NORMAL_FLOATS);
+}
+#endif
+
+// Build world and normal matrices for instances [first, first + count) with the fastest kernel available
+void transformInstances(const TransformSoA& t, size_t first, size_t count, float* world, float* normal)
+{
+#if defined(TRANSFORM_X86)
+	if (useAVX2) {
+		TransformInstancesAVX2(t, first, count, world, normal);
+		return;
+	}
+#elif defined(TRANSFORM_NEON)
+	TransformInstancesNEON(t, first, count, world, normal);
+	return;
+#endif
+	transformInstancesScalar(t, first, count, world, normal);
+}
+
+const char* transformKernelName()
+{
+#if defined(TRANSFORM_X86)
+	return useAVX2 ? "AVX2" : "scalar";
+#elif defined(TRANSFORM_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+// Compare the per-object glm path against the batched kernels
+void runTransformBenchmark(size_t count, int iterations)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	// Random animated-looking instances
+	mt19937 random(330);
+	uniform_real_distribution<float> position(-50.0f, 50.0f), angle(0.0f, 6.2831853f), size(0.5f, 2.0f);
+
+	TransformSoA transforms;
+	vector<glm::vec3> positions, scales, axes;
+	vector<float> angles;
+	for (size_t i = 0; i < count; ++i) {
+		glm::vec3 p(position(random), position(random), position(random));
+		glm::vec3 axis = glm::normalize(glm::vec3(position(random), position(random), position(random)) + glm::vec3(0.001f));
+		float a = angle(random);
+		glm::vec3 s(size(random), size(random), size(random));
+
+		positions.push_back(p);
+		axes.push_back(axis);
+		angles.push_back(a);
+		scales.push_back(s);
+		addTransform(transforms, p, glm::angleAxis(a, axis), s);
+	}
+
+	vector<glm::mat4> glmWorld(count);
+	vector<glm::mat3> glmNormal(count);
+	vector<float> world(count * WORLD_FLOATS), normal(count * NORMAL_FLOATS);
+	vector<float> scalarWorld(count * WORLD_FLOATS), scalarNormal(count * NORMAL_FLOATS);
+
+	// Per-object glm path, as used in main()
+	auto start = Clock::now();
+	for (int it = 0; it < iterations; ++it) {
+		for (size_t i = 0; i < count; ++i) {
+			glm::mat4 model;
+			model = glm::translate(model, positions[i]);
+			model = glm::rotate(model, angles[i], axes[i]);
+			model = glm::scale(model, scales[i]);
+			glmWorld[i] = model;
+			glmNormal[i] = glm::transpose(glm::inverse(glm::mat3(model)));
+		}
+	}
+	double glmTime = chrono::duration<double, milli>(Clock::now() - start).count() / iterations;
+
+	start = Clock::now();
+	for (int it = 0; it < iterations; ++it)
+		transformInstancesScalar(transforms, 0, count, scalarWorld.data(), scalarNormal.data());
+	double scalarTime = chrono::duration<double, milli>(Clock::now() - start).count() / iterations;
+
+	start = Clock::now();
+	for (int it = 0; it < iterations; ++it)
+		transformInstances(transforms, 0, count, world.data(), normal.data());
+	double kernelTime = chrono::duration<double, milli>(Clock::now() - start).count() / iterations;
+
+	// Largest difference from the glm reference
+	float worldError = 0.0f, normalError = 0.0f;
+	for (size_t i = 0; i < count; ++i) {
+		const float* reference = glm::value_ptr(glmWorld[i]);
+		for (size_t c = 0; c < WORLD_FLOATS; ++c)
+			worldError = fmax(worldError, fabs(reference[c] - world[i * WORLD_FLOATS + c]));
+
+		for (int col = 0; col < 3; ++col)
+			for (int row = 0; row < 3; ++row)
+				normalError = fmax(normalError, fabs(glmNormal[i][col][row] - normal[i * NORMAL_FLOATS + col * 4 + row]));
+	}
+
+	cout << "Transform benchmark: " << count << " instances, " << iterations << " iterations" << endl;
+	cout << "  glm per-object: " << glmTime << " ms" << endl;
+	cout << "  scalar SoA:     " << scalarTime << " ms (" << glmTime / scalarTime << "x)" << endl;
+	cout << "  " << transformKernelName() << " SoA:" << string(11 - string(transformKernelName()).size(), ' ')
+		<< kernelTime << " ms (" << glmTime / kernelTime << "x)" << endl;
+	cout << "  max error: world " << worldError << ", normal " << normalError << endl;
+}
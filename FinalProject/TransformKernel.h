@@ -0,0 +1,38 @@
+/* Description:
+Batched instance transforms. Positions, rotations (unit
+quaternions) and scales are stored as separate arrays
+(structure of arrays) so the kernel can process 8 (AVX2)
+or 4 (NEON) instances per instruction, with a scalar
+fallback for other CPUs.
+
+Output per instance:
+	world	16 floats, column-major T * R * S
+	normal	12 floats, std140 mat3 (3 columns padded to vec4),
+			inverse transpose of the upper 3x3 = R * S^-1
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstddef>
+#include <vector>
+
+/* Constants */
+const size_t WORLD_FLOATS = 16;		// Floats per world matrix
+const size_t NORMAL_FLOATS = 12;	// Floats per std140 normal matrix
+
+/* Instance transforms, one array per component */
+struct TransformSoA {
+	std::vector<float> px, py, pz;			// Translation
+	std::vector<float> qx, qy, qz, qw;		// Rotation quaternion
+	std::vector<float> sx, sy, sz;			// Scale
+};
+
+/* Transform kernel prototypes */
+void clearTransforms(TransformSoA& transforms);
+void addTransform(TransformSoA& transforms, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+size_t transformCount(const TransformSoA& transforms);
+void transformInstances(const TransformSoA& transforms, size_t first, size_t count, float* world, float* normal);
+void transformInstancesScalar(const TransformSoA& transforms, size_t first, size_t count, float* world, float* normal);
+const char* transformKernelName();
+void runTransformBenchmark(size_t count, int iterations);
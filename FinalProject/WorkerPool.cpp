@@ -0,0 +1,82 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Take jobs until the pool stops and the queue is empty
+static void WorkerLoop(WorkerPool* pool)
+{
+	while (true) {
+		function<void()> job;
+		{
+			unique_lock<mutex> lock(pool->mutex);
+			pool->work.wait(lock, [pool] { return pool->quit || !pool->jobs.empty(); });
+			if (pool->jobs.empty())
+				return;
+
+			job = move(pool->jobs.front());
+			pool->jobs.pop_front();
+			pool->running++;
+		}
+
+		job();
+
+		{
+			lock_guard<mutex> lock(pool->mutex);
+			pool->running--;
+		}
+		pool->done.notify_all();
+	}
+}
+
+// Start the threads, by default one per core left over by the main and render threads
+void startWorkerPool(WorkerPool& pool, unsigned int threadCount)
+{
+	if (threadCount == 0) {
+		unsigned int cores = thread::hardware_concurrency();
+		threadCount = max(cores > 2 ? cores - 2 : 1u, 1u);
+	}
+
+	pool.quit = false;
+	for (unsigned int i = 0; i < threadCount; ++i)
+		pool.threads.emplace_back(WorkerLoop, &pool);
+}
+
+// Queue a job for the next free thread
+void submitWork(WorkerPool& pool, function<void()> job)
+{
+	{
+		lock_guard<mutex> lock(pool.mutex);
+		pool.jobs.push_back(move(job));
+	}
+	pool.work.notify_one();
+}
+
+// Jobs queued or running
+size_t pendingWork(WorkerPool& pool)
+{
+	lock_guard<mutex> lock(pool.mutex);
+	return pool.jobs.size() + pool.running;
+}
+
+// Block until at most maxPending jobs are queued or running
+void waitWorkerPool(WorkerPool& pool, size_t maxPending)
+{
+	unique_lock<mutex> lock(pool.mutex);
+	pool.done.wait(lock, [&pool, maxPending] { return pool.jobs.size() + pool.running <= maxPending; });
+}
+
+// Finish every queued job and join the threads
+void stopWorkerPool(WorkerPool& pool)
+{
+	{
+		lock_guard<mutex> lock(pool.mutex);
+		pool.quit = true;
+	}
+	pool.work.notify_all();
+
+	for (thread& worker : pool.threads)
+		worker.join();
+	pool.threads.clear();
+}
@@ -0,0 +1,32 @@
+/* Description:
+Fixed set of background threads running queued jobs in the
+order they were submitted. Used for work that must stay off
+the main and render threads (encoding captured frames).
+Jobs must not touch the GL context.
+*/
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/* Threads and their job queue */
+struct WorkerPool {
+	std::vector<std::thread> threads;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable work;		// Workers wait for jobs
+	std::condition_variable done;		// Submitters wait for jobs to finish
+	size_t running = 0;					// Jobs taken but not finished
+	bool quit = false;
+};
+
+/* Worker pool prototypes */
+void startWorkerPool(WorkerPool& pool, unsigned int threadCount = 0);
+void submitWork(WorkerPool& pool, std::function<void()> job);
+size_t pendingWork(WorkerPool& pool);
+void waitWorkerPool(WorkerPool& pool, size_t maxPending = 0);
+void stopWorkerPool(WorkerPool& pool);
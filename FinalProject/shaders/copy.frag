@@ -0,0 +1,10 @@
+#version 330 core
+in vec2 texCoord;
+out vec4 fragColor;
+
+uniform sampler2D source;
+
+void main()
+{
+	fragColor = vec4(texture(source, texCoord).rgb, 1.0f);
+}
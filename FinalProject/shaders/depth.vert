@@ -0,0 +1,18 @@
+#version 330 core
+layout(location = 0) in vec3 vPosition;
+
+layout(std140) uniform PerDraw {
+	mat4 model;
+	mat3 normalMatrix;
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Must match the shading pass exactly, it is depth tested with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = projection * view * model * vec4(vPosition.x, vPosition.y, vPosition.z, 1.0f);
+}
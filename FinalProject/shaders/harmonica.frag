@@ -0,0 +1,108 @@
+#version 330 core
+in VertexData {
+	vec3 oColor;
+	vec2 oTexCoord;
+	vec3 oNormal;
+	vec3 FragPos;
+};
+
+out vec4 fragColor;
+
+uniform sampler2D myTexture;
+uniform vec3 objectColor;
+uniform vec3 light1Color;
+uniform vec3 light1Pos;
+uniform vec3 light2Color;
+uniform vec3 light2Pos;
+uniform vec3 light3Color;
+uniform vec3 light3Pos;
+#ifdef MULTIVIEW
+// Camera of the view this triangle was projected for, from multiview.geom
+flat in vec3 viewPos;
+#else
+uniform vec3 viewPos;
+#endif
+
+#ifdef WIREFRAME
+// Screen-space distance in pixels to each edge of the triangle, from wireframe.geom
+noperspective in vec3 edgeDistance;
+
+uniform int wireMode;		// 0 edges over the shaded surface, 1 edges only with hidden lines removed, 2 every edge
+uniform float lineWidth;	// Pixels
+uniform vec3 lineColor;
+#endif
+
+#ifdef BAKED_DIFFUSE
+// Diffuse light of every light of the scene, baked per probe for six directions stacked along z (+X, -X, +Y, -Y, +Z, -Z)
+uniform sampler3D irradianceVolume;
+uniform vec3 volumeLow;
+uniform vec3 volumeSize;
+uniform vec3 volumeProbes;
+
+// Trilinear lookup of one direction, never blending into the next slab
+vec3 BakedIrradiance(vec3 cell, float slab)
+{
+	vec3 coord = vec3((cell.xy + 0.5f) / volumeProbes.xy, (cell.z + 0.5f + slab * volumeProbes.z) / (6.0f * volumeProbes.z));
+	return texture(irradianceVolume, coord).rgb;
+}
+#endif
+
+void main()
+{
+	// Ambient
+	float ambientStrength = 0.5f;
+	vec3 ambient = ambientStrength * light1Color * light2Color * light3Color;
+
+	// Diffuse
+	vec3 norm = normalize(oNormal);
+	vec3 light1Dir = normalize(light1Pos - FragPos);
+	vec3 light2Dir = normalize(light2Pos - FragPos);
+	vec3 light3Dir = normalize(light3Pos - FragPos);
+#ifdef BAKED_DIFFUSE
+	// The three directions facing the normal, weighted by the squared normal components
+	vec3 cell = clamp((FragPos - volumeLow) / volumeSize, 0.0f, 1.0f) * (volumeProbes - 1.0f);
+	vec3 weight = norm * norm;
+	vec3 fullDiffuse = weight.x * BakedIrradiance(cell, norm.x >= 0.0f ? 0.0f : 1.0f)
+		+ weight.y * BakedIrradiance(cell, norm.y >= 0.0f ? 2.0f : 3.0f)
+		+ weight.z * BakedIrradiance(cell, norm.z >= 0.0f ? 4.0f : 5.0f);
+#else
+	float light1Diff = max(dot(norm, light1Dir), 0.0);
+	float light2Diff = max(dot(norm, light2Dir), 0.0);
+	float light3Diff = max(dot(norm, light3Dir), 0.0);
+	vec3 light1Diffuse = light1Diff * 1.0 * light1Color;
+	vec3 light2Diffuse = light2Diff * 0.2 * light2Color;
+	vec3 light3Diffuse = light3Diff * 0.2 * light3Color;
+	vec3 fullDiffuse = light1Diffuse + light2Diffuse + light3Diffuse;
+#endif
+
+	// Specularity
+	float light1SpecStr = 1.5f;
+	float light2SpecStr = 0.5f;
+	float light3SpecStr = 0.5f;
+	vec3 viewDir = normalize(viewPos - FragPos);
+	vec3 light1ReflectDir = reflect(-light1Dir, norm);
+	vec3 light2ReflectDir = reflect(-light2Dir, norm);
+	vec3 light3ReflectDir = reflect(-light3Dir, norm);
+	float light1Spec = pow(max(dot(viewDir, light1ReflectDir), 0.0), 32);
+	float light2Spec = pow(max(dot(viewDir, light2ReflectDir), 0.0), 32);
+	float light3Spec = pow(max(dot(viewDir, light3ReflectDir), 0.0), 32);
+	vec3 light1Specular = light1SpecStr * light1Spec * light1Color;
+	vec3 light2Specular = light2SpecStr * light2Spec * light2Color;
+	vec3 light3Specular = light3SpecStr * light3Spec * light3Color;
+	vec3 fullSpecular = light1Specular + light2Specular + light3Specular;
+
+	vec3 result = (ambient + fullDiffuse + fullSpecular) * objectColor;
+	fragColor = texture(myTexture, oTexCoord) * vec4(result, 1.0f);
+
+#ifdef WIREFRAME
+	// Coverage of the nearest edge: constant width on screen, one pixel of smoothing on each side
+	float nearest = min(edgeDistance.x, min(edgeDistance.y, edgeDistance.z));
+	float edge = 1.0f - smoothstep(lineWidth * 0.5f - 0.5f, lineWidth * 0.5f + 0.5f, nearest);
+	if (wireMode == 2 && edge <= 0.0f)
+		discard;
+
+	// Edge-only modes draw the surface in the background color, it still hides the edges behind it
+	vec4 surface = wireMode == 0 ? fragColor : vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	fragColor = mix(surface, vec4(lineColor, 1.0f), edge);
+#endif
+}
@@ -0,0 +1,49 @@
+#version 330 core
+layout(location = 0) in vec3 vPosition;
+layout(location = 1) in vec3 aColor;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in vec3 normal;
+
+// Block so the wireframe and multiview geometry shaders can pass it through under the same names
+out VertexData {
+	vec3 oColor;
+	vec2 oTexCoord;
+	vec3 oNormal;
+	vec3 FragPos;
+};
+
+#ifdef INSTANCED_MODEL
+// Per-instance transform written by the meshlet culling pass
+layout(location = 4) in mat4 model;
+layout(location = 8) in vec3 normalColumn0;
+layout(location = 9) in vec3 normalColumn1;
+layout(location = 10) in vec3 normalColumn2;
+#else
+layout(std140) uniform PerDraw {
+	mat4 model;
+	mat3 normalMatrix;
+};
+#endif
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Same position as the depth pre-pass, which this pass is depth tested against with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+#ifdef INSTANCED_MODEL
+	mat3 normalMatrix = mat3(normalColumn0, normalColumn1, normalColumn2);
+#endif
+#ifdef MULTIVIEW
+	// World position, multiview.geom projects it once per view
+	gl_Position = model * vec4(vPosition.x, vPosition.y, vPosition.z, 1.0f);
+#else
+	gl_Position = projection * view * model * vec4(vPosition.x, vPosition.y, vPosition.z, 1.0f);
+#endif
+	oColor = aColor;
+	oTexCoord = texCoord;
+	oNormal = normalMatrix * normal; // handles non-uniform scaling
+	FragPos = vec3(model * vec4(vPosition, 1.0f));
+}
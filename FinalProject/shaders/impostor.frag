@@ -0,0 +1,120 @@
+#version 330 core
+in vec3 quadPoint;
+in vec3 rayDir;
+flat in vec2 frame0;
+flat in vec2 frame1;
+flat in vec2 frame2;
+flat in vec3 frameWeights;
+flat in vec3 worldCenter;
+flat in vec4 rotation;
+flat in float scale;
+
+out vec4 fragColor;
+
+uniform sampler2D albedoAtlas;
+uniform sampler2D normalDepthAtlas;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float boundsRadius;
+uniform int gridSize;
+
+uniform vec3 objectColor;
+uniform vec3 light1Color;
+uniform vec3 light1Pos;
+uniform vec3 light2Color;
+uniform vec3 light2Pos;
+uniform vec3 light3Color;
+uniform vec3 light3Pos;
+uniform vec3 viewPos;
+
+vec3 Rotate(vec4 q, vec3 v)
+{
+	return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Direction of an octahedral coordinate in [-1, 1] (OctDecode() in Impostor.cpp)
+vec3 OctDecode(vec2 p)
+{
+	vec3 n = vec3(p.x, 1.0f - abs(p.x) - abs(p.y), p.y);
+	if (n.y < 0.0f)
+		n.xz = (1.0f - abs(n.zx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.z >= 0.0f ? 1.0f : -1.0f);
+	return normalize(n);
+}
+
+void FrameBasis(vec3 direction, out vec3 right, out vec3 up)
+{
+	vec3 worldUp = abs(direction.y) > 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+	right = normalize(cross(worldUp, direction));
+	up = cross(direction, right);
+}
+
+vec4 albedoSum = vec4(0.0f);
+vec3 normalSum = vec3(0.0f);
+vec3 pointSum = vec3(0.0f);
+
+// Follow the view ray to the view's plane and sample what that view saw there
+void SampleView(vec2 frame, float weight)
+{
+	if (weight <= 0.0f)
+		return;
+
+	vec3 direction = OctDecode(frame / float(gridSize - 1) * 2.0f - 1.0f);
+	float facing = dot(rayDir, direction);
+	if (abs(facing) < 1e-5f)
+		return;
+
+	vec3 right, up;
+	FrameBasis(direction, right, up);
+	vec3 onPlane = quadPoint - rayDir * (dot(quadPoint, direction) / facing);
+	vec2 uv = vec2(dot(onPlane, right), dot(onPlane, up)) / boundsRadius * 0.5f + 0.5f;
+	if (any(lessThan(uv, vec2(0.0f))) || any(greaterThan(uv, vec2(1.0f))))
+		return;
+
+	vec2 atlasUv = (frame + uv) / float(gridSize);
+	vec4 albedo = texture(albedoAtlas, atlasUv);
+	vec4 normalDepth = texture(normalDepthAtlas, atlasUv);
+	float coverage = weight * albedo.a;
+
+	// Depth runs across the bounding sphere from the view's side
+	vec3 surface = onPlane + direction * (boundsRadius - 2.0f * boundsRadius * normalDepth.w);
+
+	// Empty texels are black, so filtered edges come out premultiplied by their coverage
+	albedoSum += vec4(albedo.rgb * weight, coverage);
+	normalSum += normalDepth.xyz * coverage;
+	pointSum += surface * coverage;
+}
+
+void main()
+{
+	SampleView(frame0, frameWeights.x);
+	SampleView(frame1, frameWeights.y);
+	SampleView(frame2, frameWeights.z);
+	if (albedoSum.a < 0.5f)
+		discard;
+
+	vec3 albedo = albedoSum.rgb / albedoSum.a;
+	vec3 norm = normalize(Rotate(rotation, normalSum));
+	vec3 FragPos = worldCenter + Rotate(rotation, pointSum / albedoSum.a * scale);
+
+	vec4 clip = projection * view * vec4(FragPos, 1.0f);
+	gl_FragDepth = clip.z / clip.w * 0.5f + 0.5f;
+
+	// Same lighting as harmonica.frag
+	float ambientStrength = 0.5f;
+	vec3 ambient = ambientStrength * light1Color * light2Color * light3Color;
+
+	vec3 light1Dir = normalize(light1Pos - FragPos);
+	vec3 light2Dir = normalize(light2Pos - FragPos);
+	vec3 light3Dir = normalize(light3Pos - FragPos);
+	vec3 fullDiffuse = max(dot(norm, light1Dir), 0.0) * 1.0 * light1Color
+		+ max(dot(norm, light2Dir), 0.0) * 0.2 * light2Color
+		+ max(dot(norm, light3Dir), 0.0) * 0.2 * light3Color;
+
+	vec3 viewDir = normalize(viewPos - FragPos);
+	vec3 fullSpecular = 1.5f * pow(max(dot(viewDir, reflect(-light1Dir, norm)), 0.0), 32) * light1Color
+		+ 0.5f * pow(max(dot(viewDir, reflect(-light2Dir, norm)), 0.0), 32) * light2Color
+		+ 0.5f * pow(max(dot(viewDir, reflect(-light3Dir, norm)), 0.0), 32) * light3Color;
+
+	vec3 result = (ambient + fullDiffuse + fullSpecular) * objectColor;
+	fragColor = vec4(albedo * result, 1.0f);
+}
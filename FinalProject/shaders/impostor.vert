@@ -0,0 +1,87 @@
+#version 330 core
+layout(location = 0) in vec4 instancePosition;	// xyz position, w uniform scale
+layout(location = 1) in vec4 instanceRotation;	// Quaternion xyzw
+
+out vec3 quadPoint;		// Object space, relative to the bounds center
+out vec3 rayDir;		// Object space view ray through quadPoint
+flat out vec2 frame0;	// Atlas views blended for this instance
+flat out vec2 frame1;
+flat out vec2 frame2;
+flat out vec3 frameWeights;
+flat out vec3 worldCenter;
+flat out vec4 rotation;
+flat out float scale;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform vec3 viewForward;
+uniform bool orthographic;
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+uniform int gridSize;
+
+vec3 Rotate(vec4 q, vec3 v)
+{
+	return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Octahedral coordinate in [-1, 1] of a direction, Y is the octahedron's axis
+vec2 OctEncode(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 p = n.xz;
+	if (n.y < 0.0f)
+		p = (1.0f - abs(p.yx)) * vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+	return p;
+}
+
+// Same basis as the baked views (ViewUp() in Impostor.cpp)
+void FrameBasis(vec3 direction, out vec3 right, out vec3 up)
+{
+	vec3 worldUp = abs(direction.y) > 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+	right = normalize(cross(worldUp, direction));
+	up = cross(direction, right);
+}
+
+void main()
+{
+	scale = instancePosition.w;
+	rotation = instanceRotation;
+	vec4 inverse = vec4(-instanceRotation.xyz, instanceRotation.w);
+	worldCenter = instancePosition.xyz + Rotate(instanceRotation, boundsCenter * scale);
+
+	// Direction toward the camera in object space
+	vec3 toCamera = orthographic ? -viewForward : viewPos - worldCenter;
+	vec3 direction = normalize(Rotate(inverse, toCamera));
+
+	// Three grid views around the direction, weighted by where it falls in their triangle
+	vec2 grid = (OctEncode(direction) * 0.5f + 0.5f) * float(gridSize - 1);
+	vec2 cell = min(floor(grid), vec2(gridSize - 2));
+	vec2 f = grid - cell;
+	frame0 = cell;
+	frame2 = cell + vec2(1.0f, 1.0f);
+	if (f.x > f.y) {
+		frame1 = cell + vec2(1.0f, 0.0f);
+		frameWeights = vec3(1.0f - f.x, f.x - f.y, f.y);
+	}
+	else {
+		frame1 = cell + vec2(0.0f, 1.0f);
+		frameWeights = vec3(1.0f - f.y, f.y - f.x, f.x);
+	}
+
+	// Quad facing the camera, grown so a close perspective view still covers the whole sphere
+	float grow = 1.0f;
+	if (!orthographic) {
+		float distance = length(toCamera) / scale;
+		grow = distance / sqrt(max(distance * distance - boundsRadius * boundsRadius, 1e-4f));
+	}
+	vec3 right, up;
+	FrameBasis(direction, right, up);
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0f - 1.0f;
+	quadPoint = (right * corner.x + up * corner.y) * boundsRadius * grow;
+
+	vec3 worldPoint = worldCenter + Rotate(instanceRotation, quadPoint * scale);
+	rayDir = Rotate(inverse, orthographic ? viewForward : worldPoint - viewPos);
+	gl_Position = projection * view * vec4(worldPoint, 1.0f);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+in VertexData {
+	vec3 oColor;
+	vec2 oTexCoord;
+	vec3 oNormal;
+	vec3 FragPos;
+};
+
+layout(location = 0) out vec4 albedo;
+layout(location = 1) out vec4 normalDepth;
+
+uniform sampler2D myTexture;
+
+void main()
+{
+	// Unlit, the impostor is lit when it is drawn
+	albedo = vec4(texture(myTexture, oTexCoord).rgb, 1.0f);
+
+	// Orthographic depth is linear across the bounding sphere
+	normalDepth = vec4(normalize(oNormal), gl_FragCoord.z);
+}
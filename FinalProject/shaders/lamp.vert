@@ -0,0 +1,15 @@
+#version 330 core
+layout(location = 0) in vec3 vPosition;
+
+layout(std140) uniform PerDraw {
+	mat4 model;
+	mat3 normalMatrix;
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+	gl_Position = projection * view * model * vec4(vPosition.x, vPosition.y, vPosition.z, 1.0f);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+out vec4 fragColor;
+
+// Added once per shaded fragment: dark red for one layer, through orange and yellow to white
+const vec3 layerColor = vec3(0.25f, 0.1f, 0.04f);
+
+void main()
+{
+	fragColor = vec4(layerColor, 1.0f);
+}
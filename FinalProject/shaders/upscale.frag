@@ -0,0 +1,29 @@
+#version 330 core
+in vec2 texCoord;
+out vec4 fragColor;
+
+uniform sampler2D source;
+uniform vec2 uvScale;		// Part of the texture the scene was rendered into
+uniform vec2 texelSize;		// 1 / texture size
+uniform float sharpness;	// 0 for plain bilinear
+
+// Bilinear sample, kept inside the rendered part so edges do not pick up stale texels
+vec3 Sample(vec2 uv)
+{
+	return texture(source, clamp(uv, texelSize * 0.5f, uvScale - texelSize * 0.5f)).rgb;
+}
+
+void main()
+{
+	vec2 uv = texCoord * uvScale;
+	vec3 color = Sample(uv);
+
+	// Unsharp mask: push the pixel away from the average of its neighbours
+	if (sharpness > 0.0f) {
+		vec3 blur = (Sample(uv + vec2(texelSize.x, 0.0f)) + Sample(uv - vec2(texelSize.x, 0.0f)) +
+			Sample(uv + vec2(0.0f, texelSize.y)) + Sample(uv - vec2(0.0f, texelSize.y))) * 0.25f;
+		color = clamp(color + (color - blur) * sharpness, 0.0f, 1.0f);
+	}
+
+	fragColor = vec4(color, 1.0f);
+}